@@ -138,9 +138,20 @@ public:
 
     Replication* get_replication() noexcept;
 
+    /// Returns true if leaves allocated through this allocator may be stored in
+    /// one of the compact, read-mostly forms introduced by file format version
+    /// 10 (frame-of-reference integer arrays, Array::wtype_BitsWithBase, and
+    /// compressed medium string leaves, see ArrayStringLong::compress()). The
+    /// same goes for the value summaries in inner B+-tree nodes of integer
+    /// columns (BpTreeNode::has_bptree_summary()). This is decided by the Group
+    /// that owns the allocator.
+    bool allows_compact_leaves() const noexcept;
+
 protected:
     size_t m_baseline = 0; // Separation line between immutable and mutable refs.
 
+    bool m_allow_compact_leaves = false;
+
     Replication* m_replication = nullptr;
 
     ref_type m_debug_watch = 0;
@@ -369,6 +380,11 @@ inline Replication* Allocator::get_replication() noexcept
     return m_replication;
 }
 
+inline bool Allocator::allows_compact_leaves() const noexcept
+{
+    return m_allow_compact_leaves;
+}
+
 } // namespace realm
 
 #endif // REALM_ALLOC_HPP
@@ -32,6 +32,7 @@
 #endif
 
 #include <realm/util/encrypted_file_mapping.hpp>
+#include <realm/util/file_mapper.hpp>
 #include <realm/util/miscellaneous.hpp>
 #include <realm/util/terminate.hpp>
 #include <realm/util/thread.hpp>
@@ -64,6 +65,9 @@ struct SlabAlloc::MappedFile {
     util::Mutex m_mutex;
     util::File m_file;
     util::File::Map<char> m_initial_mapping;
+    // The flags used for all mappings of the file. They are chosen by the
+    // allocator that establishes the initial mapping.
+    int m_map_flags = 0;
     // additional sections beyond those covered by the initial mapping, are
     // managed as separate mmap allocations, each covering one section.
     size_t m_first_additional_mapping = 0;
@@ -128,52 +132,172 @@ void SlabAlloc::init_streaming_header(Header* streaming_header, int file_format_
 }
 
 
-class SlabAlloc::ChunkRefEq {
-public:
-    ChunkRefEq(ref_type ref) noexcept
-        : m_ref(ref)
-    {
+int SlabAlloc::FreeSpace::get_size_class(size_t size) noexcept
+{
+    REALM_ASSERT_DEBUG(size != 0);
+    return log2(size);
+}
+
+
+auto SlabAlloc::FreeSpace::find_ending_at(ref_type ref) noexcept -> iterator
+{
+    iterator i = m_chunks.lower_bound(ref);
+    if (i == m_chunks.begin())
+        return m_chunks.end();
+    --i;
+    return i->first + i->second.size == ref ? i : m_chunks.end();
+}
+
+
+auto SlabAlloc::FreeSpace::find_fit(size_t size) noexcept -> iterator
+{
+    // Every chunk in bin k is at least 2^k bytes, so any chunk in a bin at or
+    // above the ceiling of log2(size) will do.
+    int floor_class = get_size_class(size);
+    int fit_class = size == size_t(1) << floor_class ? floor_class : floor_class + 1;
+    size_t candidates = fit_class < num_size_classes ? m_nonempty_bins & ~((size_t(1) << fit_class) - 1) : 0;
+    if (candidates != 0) {
+        // Isolate the lowest set bit
+        const std::vector<iterator>& bin = m_bins[get_size_class(candidates & (~candidates + 1))];
+#if REALM_ENABLE_MEMDEBUG
+        // Pick a *random* chunk instead of the most recently freed one. This
+        // will increase the chance of catching use-after-free bugs in Core.
+        return bin[size_t(fastrand(bin.size() - 1))];
+#else
+        return bin.back();
+#endif
     }
-    bool operator()(const Chunk& chunk) const noexcept
-    {
-        return chunk.ref == m_ref;
+
+    // Chunks in the bin of the requested size itself may or may not fit
+    for (iterator i : m_bins[floor_class]) {
+        if (size <= i->second.size)
+            return i;
     }
+    return m_chunks.end();
+}
 
-private:
-    ref_type m_ref;
-};
 
+bool SlabAlloc::FreeSpace::intersects(ref_type ref, size_t size) const noexcept
+{
+    const_iterator i = m_chunks.lower_bound(ref);
+    if (i != m_chunks.end() && i->first < ref + size)
+        return true;
+    if (i == m_chunks.begin())
+        return false;
+    --i;
+    return ref < i->first + i->second.size;
+}
 
-class SlabAlloc::ChunkRefEndEq {
-public:
-    ChunkRefEndEq(ref_type ref) noexcept
-        : m_ref(ref)
-    {
-    }
-    bool operator()(const Chunk& chunk) const noexcept
-    {
-        return chunk.ref + chunk.size == m_ref;
+
+void SlabAlloc::FreeSpace::insert(ref_type ref, size_t size)
+{
+    int size_class = get_size_class(size);
+    std::vector<iterator>& bin = m_bins[size_class];
+    bin.reserve(bin.size() + 1); // Throws
+    iterator i = m_chunks.emplace(ref, Entry{size, bin.size()}).first; // Throws
+    bin.push_back(i);
+    m_nonempty_bins |= size_t(1) << size_class;
+}
+
+
+void SlabAlloc::FreeSpace::resize(iterator i, size_t new_size)
+{
+    int old_class = get_size_class(i->second.size);
+    int new_class = get_size_class(new_size);
+    if (new_class != old_class) {
+        std::vector<iterator>& bin = m_bins[new_class];
+        bin.push_back(i); // Throws
+        remove_from_bin(i);
+        i->second.bin_ndx = bin.size() - 1;
+        m_nonempty_bins |= size_t(1) << new_class;
     }
+    i->second.size = new_size;
+}
 
-private:
-    ref_type m_ref;
-};
 
+void SlabAlloc::FreeSpace::erase(iterator i) noexcept
+{
+    remove_from_bin(i);
+    m_chunks.erase(i);
+}
 
-class SlabAlloc::SlabRefEndEq {
-public:
-    SlabRefEndEq(ref_type ref) noexcept
-        : m_ref(ref)
-    {
+
+void SlabAlloc::FreeSpace::clear() noexcept
+{
+    for (auto& bin : m_bins)
+        bin.clear();
+    m_nonempty_bins = 0;
+    m_chunks.clear();
+}
+
+
+void SlabAlloc::FreeSpace::remove_from_bin(iterator i) noexcept
+{
+    // Erase by "move last over"
+    int size_class = get_size_class(i->second.size);
+    std::vector<iterator>& bin = m_bins[size_class];
+    size_t bin_ndx = i->second.bin_ndx;
+    REALM_ASSERT_DEBUG(bin[bin_ndx] == i);
+    iterator last = bin.back();
+    bin[bin_ndx] = last;
+    last->second.bin_ndx = bin_ndx;
+    bin.pop_back();
+    if (bin.empty())
+        m_nonempty_bins &= ~(size_t(1) << size_class);
+}
+
+
+void SlabAlloc::FreeSpace::verify() const
+{
+#ifdef REALM_DEBUG
+    size_t num_binned = 0;
+    for (int k = 0; k < num_size_classes; ++k) {
+        const std::vector<iterator>& bin = m_bins[k];
+        REALM_ASSERT_3(bin.empty(), ==, (m_nonempty_bins & (size_t(1) << k)) == 0);
+        for (size_t j = 0; j < bin.size(); ++j) {
+            REALM_ASSERT_3(get_size_class(bin[j]->second.size), ==, k);
+            REALM_ASSERT_3(bin[j]->second.bin_ndx, ==, j);
+        }
+        num_binned += bin.size();
     }
-    bool operator()(const Slab& slab) const noexcept
-    {
-        return slab.ref_end == m_ref;
+    REALM_ASSERT_3(num_binned, ==, m_chunks.size());
+#endif
+}
+
+
+bool SlabAlloc::is_slab_boundary(ref_type ref) const noexcept
+{
+    slabs::const_iterator i = upper_bound(m_slabs.begin(), m_slabs.end(), ref, &ref_less_than_slab_ref_end);
+    return i != m_slabs.begin() && (i - 1)->ref_end == ref;
+}
+
+
+size_t SlabAlloc::get_effective_page_size() const noexcept
+{
+    return m_huge_pages ? util::huge_page_size : page_size();
+}
+
+
+char* SlabAlloc::allocate_slab_memory(size_t size)
+{
+    if (m_huge_pages) {
+        // Anonymous mappings are zero-filled
+        return static_cast<char*>(util::mmap_anon_huge_pages(size)); // Throws
     }
+    std::unique_ptr<char[]> mem(new char[size]); // Throws
+    std::fill(mem.get(), mem.get() + size, 0);
+    return mem.release();
+}
 
-private:
-    ref_type m_ref;
-};
+
+void SlabAlloc::free_slab_memory(char* addr, size_t size) noexcept
+{
+    if (m_huge_pages) {
+        util::munmap(addr, size);
+        return;
+    }
+    delete[] addr;
+}
 
 
 void SlabAlloc::detach() noexcept
@@ -190,6 +314,7 @@ void SlabAlloc::detach() noexcept
             m_data = 0;
             m_file_mappings.reset();
             m_local_mappings.reset();
+            m_ref_translations.reset();
             m_num_local_mappings = 0;
             break;
         default:
@@ -200,10 +325,13 @@ void SlabAlloc::detach() noexcept
     // Release all allocated memory - this forces us to create new
     // slabs after re-attaching thereby ensuring that the slabs are
     // placed correctly (logically) after the end of the file.
+    ref_type slab_ref = m_baseline;
     for (auto& slab : m_slabs) {
-        delete[] slab.addr;
+        free_slab_memory(slab.addr, slab.ref_end - slab_ref);
+        slab_ref = slab.ref_end;
     }
     m_slabs.clear();
+    m_huge_pages = false;
 
     m_attach_mode = attach_None;
 }
@@ -268,52 +396,35 @@ MemRef SlabAlloc::do_alloc(const size_t size)
 
     // Do we have a free space we can reuse?
     {
-        typedef chunks::reverse_iterator iter;
-        iter rend = m_free_space.rend();
-        for (iter i = m_free_space.rbegin(); i != rend; ++i) {
-            if (size <= i->size) {
-
-#if REALM_ENABLE_MEMDEBUG
-                // Pick a *random* match instead of just the first. This will increase the chance of catching
-                // use-after-free bugs in Core. It's chosen such that the mathematical average of all picked
-                // positions is the middle of the list.
-                iter j = i;
-                while (j != rend && (size > j->size || fastrand() % (m_free_space.size() / 2 + 1) != 0)) {
-                    j++;
-                }
-                if (j != rend)
-                    i = j;
-#endif
-
-                ref_type ref = i->ref;
-                size_t rest = i->size - size;
-
-                // Update free list
-                if (rest == 0) {
-                    // Erase by "move last over"
-                    *i = m_free_space.back();
-                    m_free_space.pop_back();
-                }
-                else {
-                    i->size = rest;
-                    i->ref += size;
-                }
+        FreeSpace::iterator i = m_free_space.find_fit(size);
+        if (i != m_free_space.end()) {
+            // Carve the block from the end of the chunk, such that the
+            // remaining chunk keeps its ref
+            size_t rest = i->second.size - size;
+            ref_type ref = i->first + rest;
+
+            // Update free list
+            if (rest == 0) {
+                m_free_space.erase(i);
+            }
+            else {
+                m_free_space.resize(i, rest); // Throws
+            }
 
 #ifdef REALM_DEBUG
-                if (REALM_COVER_NEVER(m_debug_out))
-                    std::cerr << "Alloc ref: " << ref << " size: " << size << "\n";
+            if (REALM_COVER_NEVER(m_debug_out))
+                std::cerr << "Alloc ref: " << ref << " size: " << size << "\n";
 #endif
 
-                char* addr = translate(ref);
+            char* addr = translate(ref);
 #if REALM_ENABLE_ALLOC_SET_ZERO
-                std::fill(addr, addr + size, 0);
+            std::fill(addr, addr + size, 0);
 #endif
 #ifdef REALM_SLAB_ALLOC_DEBUG
-                malloc_debug_map[ref] = malloc(1);
+            malloc_debug_map[ref] = malloc(1);
 #endif
-                REALM_ASSERT_EX(ref >= m_baseline, ref, m_baseline);
-                return MemRef(addr, ref, *this);
-            }
+            REALM_ASSERT_EX(ref >= m_baseline, ref, m_baseline);
+            return MemRef(addr, ref, *this);
         }
     }
 
@@ -340,7 +451,8 @@ MemRef SlabAlloc::do_alloc(const size_t size)
     }
 
     // Round upwards to nearest page size
-    new_size = ((new_size - 1) | (page_size() - 1)) + 1;
+    size_t slab_page_size = get_effective_page_size();
+    new_size = ((new_size - 1) | (slab_page_size - 1)) + 1;
 
 #ifdef REALM_SLAB_ALLOC_TUNE
     {
@@ -364,27 +476,27 @@ MemRef SlabAlloc::do_alloc(const size_t size)
                                  + util::to_string(new_size));
     }
 
-    std::unique_ptr<char[]> mem(new char[new_size]); // Throws
-    std::fill(mem.get(), mem.get() + new_size, 0);
-
     // Add to list of slabs
     Slab slab;
-    slab.addr = mem.get();
+    slab.addr = allocate_slab_memory(new_size); // Throws
     slab.ref_end = ref_end;
-    m_slabs.push_back(slab); // Throws
-    mem.release();
+    try {
+        m_slabs.push_back(slab); // Throws
+    }
+    catch (...) {
+        free_slab_memory(slab.addr, new_size);
+        throw;
+    }
 
     // Update free list
     size_t unused = new_size - size;
     if (0 < unused) {
-        Chunk chunk;
-        chunk.ref = ref;
-        if (REALM_UNLIKELY(int_add_with_overflow_detect(chunk.ref, size))) {
+        ref_type chunk_ref = ref;
+        if (REALM_UNLIKELY(int_add_with_overflow_detect(chunk_ref, size))) {
             throw MaximumFileSizeExceeded("AllocSlab free list ref size overflow: " + util::to_string(ref) + " + "
                                      + util::to_string(size));
         }
-        chunk.size = unused;
-        m_free_space.push_back(chunk); // Throws
+        m_free_space.insert(chunk_ref, unused); // Throws
     }
 
 #ifdef REALM_DEBUG
@@ -409,7 +521,6 @@ void SlabAlloc::do_free(ref_type ref, const char* addr) noexcept
 
     // Free space in read only segment is tracked separately
     bool read_only = is_read_only(ref);
-    chunks& free_space = read_only ? m_free_read_only : m_free_space;
 
 #ifdef REALM_SLAB_ALLOC_DEBUG
     free(malloc_debug_map[ref]);
@@ -433,61 +544,54 @@ void SlabAlloc::do_free(ref_type ref, const char* addr) noexcept
 
     m_free_space_state = free_space_Dirty;
 
+    if (read_only) {
 #ifdef REALM_DEBUG
-    // Check for double free
-    for (auto& c : free_space) {
-        if ((ref >= c.ref && ref < (c.ref + c.size)) || (ref < c.ref && ref_end > c.ref)) {
-            REALM_ASSERT(false && "Double Free");
-        }
-    }
-#endif
-
-    // Check if we can merge with adjacent succeeding free block
-    typedef chunks::iterator iter;
-    iter merged_with = free_space.end();
-    if (!read_only) {
-        {
-            iter i = find_if(free_space.begin(), free_space.end(), ChunkRefEq(ref_end));
-            if (i != free_space.end()) {
-                // No consolidation over slab borders
-                if (find_if(m_slabs.begin(), m_slabs.end(), SlabRefEndEq(ref_end)) == m_slabs.end()) {
-                    i->ref = ref;
-                    i->size += size;
-                    merged_with = i;
-                }
+        // Check for double free
+        for (auto& c : m_free_read_only) {
+            if ((ref >= c.ref && ref < (c.ref + c.size)) || (ref < c.ref && ref_end > c.ref)) {
+                REALM_ASSERT(false && "Double Free");
             }
         }
-
-        // Check if we can merge with adjacent preceeding free block (not if that
-        // would cross slab boundary)
-        if (find_if(m_slabs.begin(), m_slabs.end(), SlabRefEndEq(ref)) == m_slabs.end()) {
-            iter i = find_if(free_space.begin(), free_space.end(), ChunkRefEndEq(ref));
-            if (i != free_space.end()) {
-                if (merged_with != free_space.end()) {
-                    i->size += merged_with->size;
-                    // Erase by "move last over"
-                    *merged_with = free_space.back();
-                    free_space.pop_back();
-                }
-                else {
-                    i->size += size;
-                }
-                return;
-            }
-        }
-    }
-
-    // Else just add to freelist
-    if (merged_with == free_space.end()) {
+#endif
         try {
             Chunk chunk;
             chunk.ref = ref;
             chunk.size = size;
-            free_space.push_back(chunk); // Throws
+            m_free_read_only.push_back(chunk); // Throws
         }
         catch (...) {
             m_free_space_state = free_space_Invalid;
         }
+        return;
+    }
+
+    // Check for double free
+    REALM_ASSERT_DEBUG(!m_free_space.intersects(ref, size));
+
+    try {
+        // Check if we can merge with adjacent succeeding and preceeding free
+        // blocks (no consolidation over slab borders)
+        FreeSpace::iterator next = m_free_space.end();
+        if (!is_slab_boundary(ref_end))
+            next = m_free_space.find(ref_end);
+        FreeSpace::iterator prev = m_free_space.end();
+        if (!is_slab_boundary(ref))
+            prev = m_free_space.find_ending_at(ref);
+
+        size_t merged_size = size;
+        if (next != m_free_space.end())
+            merged_size += next->second.size;
+        if (prev != m_free_space.end()) {
+            m_free_space.resize(prev, prev->second.size + merged_size); // Throws
+        }
+        else {
+            m_free_space.insert(ref, merged_size); // Throws
+        }
+        if (next != m_free_space.end())
+            m_free_space.erase(next);
+    }
+    catch (...) {
+        m_free_space_state = free_space_Invalid;
     }
 }
 
@@ -557,47 +661,49 @@ char* SlabAlloc::do_translate(ref_type ref) const noexcept
     REALM_ASSERT_DEBUG(is_attached());
 
     const char* addr = nullptr;
+    util::EncryptedFileMapping* encrypted_mapping = nullptr;
 
-    size_t cache_index = ref ^ ((ref >> 16) >> 16);
-    // we shift by 16 two times. On 32-bitters it's undefined to shift by
-    // 32. Shifting twice x16 however, is defined and gives zero. On 64-bitters
-    // the compiler should reduce it to a single 32 bit shift.
-    cache_index = cache_index ^ (cache_index >> 16);
-    cache_index = (cache_index ^ (cache_index >> 8)) & 0xFF;
-    if (cache[cache_index].ref == ref && cache[cache_index].version == version)
-        return const_cast<char*>(cache[cache_index].addr);
-
+    // Refs into unencrypted parts of the file are resolved directly, which is
+    // cheaper than a lookup in the cache.
     if (ref < m_baseline) {
-
-        const util::File::Map<char>* map;
-
         // fast path if reference is inside the initial mapping (or buffer):
         if (ref < m_initial_chunk_size) {
             addr = m_data + ref;
             if (m_file_mappings) {
                 // Once established, the initial mapping is immutable, so we
                 // don't need to grab a lock for access.
-                map = &m_file_mappings->m_initial_mapping;
-                realm::util::encryption_read_barrier(addr, Array::header_size, map->get_encrypted_mapping(),
-                                                     Array::get_byte_size_from_header);
+                encrypted_mapping = m_file_mappings->m_initial_mapping.get_encrypted_mapping();
             }
         }
         else {
             // reference must be inside a section mapped later
-            size_t section_index = get_section_index(ref);
             REALM_ASSERT_DEBUG(m_file_mappings);
-
-            size_t mapping_index = section_index - m_file_mappings->m_first_additional_mapping;
-            size_t section_offset = ref - get_section_base(section_index);
-            REALM_ASSERT_DEBUG(m_local_mappings);
+            size_t mapping_index = get_section_index(ref) - m_file_mappings->m_first_additional_mapping;
             REALM_ASSERT_DEBUG(mapping_index < m_num_local_mappings);
-            map = m_local_mappings[mapping_index].get();
-            REALM_ASSERT_DEBUG(map->get_addr() != nullptr);
-            addr = map->get_addr() + section_offset;
-            realm::util::encryption_read_barrier(addr, Array::header_size, map->get_encrypted_mapping(),
-                                                 Array::get_byte_size_from_header);
+            const RefTranslation& txl = m_ref_translations[mapping_index];
+            REALM_ASSERT_DEBUG(txl.mapping_addr != nullptr);
+            addr = txl.mapping_addr + (ref - txl.section_base);
+            encrypted_mapping = txl.encrypted_mapping;
+        }
+        if (REALM_LIKELY(!encrypted_mapping)) {
+            ++m_num_translation_hits;
+            return const_cast<char*>(addr);
+        }
+    }
+
+    TranslationCacheEntry* set = m_translation_cache[get_translation_cache_set(ref)];
+    for (size_t i = 0; i < translation_cache_ways; ++i) {
+        if (set[i].ref == ref && set[i].version == version) {
+            ++m_num_translation_hits;
+            return const_cast<char*>(set[i].addr);
         }
     }
+    ++m_num_translation_misses;
+
+    if (encrypted_mapping) {
+        realm::util::encryption_read_barrier(addr, Array::header_size, encrypted_mapping,
+                                             Array::get_byte_size_from_header);
+    }
     else {
         typedef slabs::const_iterator iter;
         iter i = upper_bound(m_slabs.begin(), m_slabs.end(), ref, &ref_less_than_slab_ref_end);
@@ -606,14 +712,36 @@ char* SlabAlloc::do_translate(ref_type ref) const noexcept
         ref_type slab_ref = i == m_slabs.begin() ? m_baseline : (i - 1)->ref_end;
         addr = i->addr + (ref - slab_ref);
     }
-    cache[cache_index].addr = addr;
-    cache[cache_index].ref = ref;
-    cache[cache_index].version = version;
+
+    // Evict the least recently inserted entry of the set
+    for (size_t i = translation_cache_ways - 1; i > 0; --i)
+        set[i] = set[i - 1];
+    set[0].ref = ref;
+    set[0].addr = addr;
+    set[0].version = version;
     REALM_ASSERT_DEBUG(addr != nullptr);
     return const_cast<char*>(addr);
 }
 
 
+void SlabAlloc::update_local_mappings(size_t num_mappings)
+{
+    std::unique_ptr<std::shared_ptr<const util::File::Map<char>>[]> mappings;
+    mappings.reset(new std::shared_ptr<const util::File::Map<char>>[num_mappings]); // Throws
+    std::unique_ptr<RefTranslation[]> translations(new RefTranslation[num_mappings]); // Throws
+    for (size_t k = 0; k < num_mappings; ++k) {
+        mappings[k] = m_file_mappings->m_global_mappings[k];
+        RefTranslation& txl = translations[k];
+        txl.mapping_addr = mappings[k]->get_addr();
+        txl.section_base = get_section_base(k + m_file_mappings->m_first_additional_mapping);
+        txl.encrypted_mapping = mappings[k]->get_encrypted_mapping();
+    }
+    m_local_mappings = std::move(mappings);
+    m_ref_translations = std::move(translations);
+    m_num_local_mappings = num_mappings;
+}
+
+
 int SlabAlloc::get_committed_file_format_version() const noexcept
 {
     const Header& header = *reinterpret_cast<const Header*>(m_data);
@@ -677,6 +805,7 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
     const std::string path = file_path.c_str();
 
     using namespace realm::util;
+    m_huge_pages = cfg.huge_pages && huge_pages_supported();
     File::AccessMode access = cfg.read_only ? File::access_ReadOnly : File::access_ReadWrite;
     File::CreateMode create = cfg.read_only || cfg.no_create ? File::create_Never : File::create_Auto;
     {
@@ -724,11 +853,7 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
             size_t mapping_index = m_file_mappings->m_num_global_mappings;
             size_t section_index = mapping_index + m_file_mappings->m_first_additional_mapping;
             m_baseline = get_section_base(section_index);
-            m_num_local_mappings = m_file_mappings->m_num_global_mappings;
-            m_local_mappings.reset(new std::shared_ptr<const util::File::Map<char>>[ m_num_local_mappings ]);
-            for (size_t k = 0; k < m_num_local_mappings; ++k) {
-                m_local_mappings[k] = m_file_mappings->m_global_mappings[k];
-            }
+            update_local_mappings(m_file_mappings->m_num_global_mappings); // Throws
         }
         else {
             // TODO: m_file_mappings->m_initial_mapping.get_size() may not represent the actual file size
@@ -795,7 +920,9 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
     }
     ref_type top_ref;
     try {
-        File::Map<char> map(m_file_mappings->m_file, File::access_ReadOnly, size); // Throws
+        m_file_mappings->m_map_flags = m_huge_pages ? File::map_HugePages : 0;
+        File::Map<char> map(m_file_mappings->m_file, File::access_ReadOnly, size,
+                            m_file_mappings->m_map_flags); // Throws
         // we'll read header and (potentially) footer
         realm::util::encryption_read_barrier(map, 0, sizeof(Header));
         realm::util::encryption_read_barrier(map, size - sizeof(Header), sizeof(Header));
@@ -904,7 +1031,8 @@ ref_type SlabAlloc::attach_file(const std::string& file_path, Config& cfg)
                 // actual size of the file.
                 size = get_upper_section_boundary(size);
                 m_file_mappings->m_file.prealloc(0, size);
-                m_file_mappings->m_initial_mapping.remap(m_file_mappings->m_file, File::access_ReadOnly, size);
+                m_file_mappings->m_initial_mapping.remap(m_file_mappings->m_file, File::access_ReadOnly, size,
+                                                         m_file_mappings->m_map_flags);
                 m_data = m_file_mappings->m_initial_mapping.get_addr();
                 m_baseline = size;
                 m_initial_chunk_size = size;
@@ -939,6 +1067,7 @@ ref_type SlabAlloc::attach_buffer(const char* data, size_t size)
     // Verify the data structures
     std::string path; // No path
     validate_buffer(data, size, path); // Throws
+    m_huge_pages = false;
 
     ref_type top_ref = get_top_ref(data, size);
 
@@ -962,6 +1091,7 @@ void SlabAlloc::attach_empty()
 
     m_attach_mode = attach_OwnedBuffer;
     m_data = nullptr; // Empty buffer
+    m_huge_pages = false;
 
     // Below this point (assignment to `m_attach_mode`), nothing must throw.
 
@@ -1023,13 +1153,10 @@ void SlabAlloc::reset_free_space_tracking()
     m_free_space.clear();
 
     // Rebuild free list to include all slabs
-    Chunk chunk;
-    chunk.ref = m_baseline;
-
+    ref_type slab_ref = m_baseline;
     for (const auto& slab : m_slabs) {
-        chunk.size = slab.ref_end - chunk.ref;
-        m_free_space.push_back(chunk); // Throws
-        chunk.ref = slab.ref_end;
+        m_free_space.insert(slab_ref, slab.ref_end - slab_ref); // Throws
+        slab_ref = slab.ref_end;
     }
 
 #ifdef REALM_DEBUG
@@ -1080,7 +1207,8 @@ void SlabAlloc::update_reader_view(size_t file_size)
             size_t section_size =
                 get_section_base(1 + k + m_file_mappings->m_first_additional_mapping) - section_start_offset;
             m_file_mappings->m_global_mappings[k] = std::make_shared<const util::File::Map<char>>(
-                m_file_mappings->m_file, section_start_offset, File::access_ReadOnly, section_size);
+                m_file_mappings->m_file, section_start_offset, File::access_ReadOnly, section_size,
+                m_file_mappings->m_map_flags);
         }
 
         // Share the increased number of mappings. This *must* be a conditional update to ensure
@@ -1091,25 +1219,26 @@ void SlabAlloc::update_reader_view(size_t file_size)
             m_file_mappings->m_num_global_mappings = num_additional_mappings;
 
         // update local cache of mappings, if global mappings have been extended beyond local
-        if (num_additional_mappings > m_num_local_mappings) {
-            m_num_local_mappings = num_additional_mappings;
-            m_local_mappings.reset(new std::shared_ptr<const util::File::Map<char>>[ m_num_local_mappings ]);
-            for (size_t k = 0; k < m_num_local_mappings; ++k) {
-                m_local_mappings[k] = m_file_mappings->m_global_mappings[k];
-            }
-        }
+        if (num_additional_mappings > m_num_local_mappings)
+            update_local_mappings(num_additional_mappings); // Throws
     }
     // Rebase slabs and free list (assumes exactly one entry in m_free_space for
     // each entire slab in m_slabs)
     size_t slab_ref = file_size;
     size_t n = m_free_space.size();
     REALM_ASSERT(m_slabs.size() == n);
+    FreeSpace::const_iterator free_chunk = m_free_space.begin();
     for (size_t i = 0; i < n; ++i) {
-        Chunk& free_chunk = m_free_space[i];
-        free_chunk.ref = slab_ref;
-        ref_type slab_ref_end = slab_ref + free_chunk.size;
+        ref_type slab_ref_end = slab_ref + free_chunk->second.size;
         m_slabs[i].ref_end = slab_ref_end;
         slab_ref = slab_ref_end;
+        ++free_chunk;
+    }
+    m_free_space.clear();
+    slab_ref = file_size;
+    for (const auto& slab : m_slabs) {
+        m_free_space.insert(slab_ref, slab.ref_end - slab_ref); // Throws
+        slab_ref = slab.ref_end;
     }
 }
 
@@ -1195,6 +1324,13 @@ void SlabAlloc::resize_file(size_t new_file_size)
         m_file_mappings->m_file.sync(); // Throws
 }
 
+void SlabAlloc::truncate_file(size_t new_file_size)
+{
+    std::lock_guard<Mutex> lock(m_file_mappings->m_mutex);
+    REALM_ASSERT(matches_section_boundary(new_file_size));
+    m_file_mappings->m_file.resize(new_file_size); // Throws
+}
+
 void SlabAlloc::reserve_disk_space(size_t size)
 {
     std::lock_guard<Mutex> lock(m_file_mappings->m_mutex);
@@ -1213,13 +1349,14 @@ void SlabAlloc::verify() const
     // Make sure that all free blocks fit within a slab
     for (const auto& chunk : m_free_space) {
         slabs::const_iterator slab =
-            upper_bound(m_slabs.begin(), m_slabs.end(), chunk.ref, &ref_less_than_slab_ref_end);
+            upper_bound(m_slabs.begin(), m_slabs.end(), chunk.first, &ref_less_than_slab_ref_end);
         REALM_ASSERT(slab != m_slabs.end());
 
         ref_type slab_ref_end = slab->ref_end;
-        ref_type chunk_ref_end = chunk.ref + chunk.size;
+        ref_type chunk_ref_end = chunk.first + chunk.second.size;
         REALM_ASSERT_3(chunk_ref_end, <=, slab_ref_end);
     }
+    m_free_space.verify();
 #endif
 }
 
@@ -1234,10 +1371,10 @@ bool SlabAlloc::is_all_free() const
     ref_type slab_ref = m_baseline;
     for (const auto& slab : m_slabs) {
         size_t slab_size = slab.ref_end - slab_ref;
-        chunks::const_iterator chunk = find_if(m_free_space.begin(), m_free_space.end(), ChunkRefEq(slab_ref));
+        FreeSpace::const_iterator chunk = m_free_space.find(slab_ref);
         if (chunk == m_free_space.end())
             return false;
-        if (slab_size != chunk->size)
+        if (slab_size != chunk->second.size)
             return false;
         slab_ref = slab.ref_end;
     }
@@ -1252,7 +1389,7 @@ void SlabAlloc::print() const
 
     size_t free = 0;
     for (const auto& free_block : m_free_space) {
-        free += free_block.size;
+        free += free_block.second.size;
     }
 
     size_t allocated = allocated_for_slabs - free;
@@ -1278,11 +1415,11 @@ void SlabAlloc::print() const
     if (!m_free_space.empty()) {
         std::cout << "FreeSpace: ";
         for (const auto& free_block : m_free_space) {
-            if (&free_block != &m_free_space.front())
+            if (&free_block != &*m_free_space.begin())
                 std::cout << ", ";
 
-            ref_type last_ref = free_block.ref + free_block.size - 1;
-            std::cout << "(" << free_block.ref << "->" << last_ref << ", size=" << free_block.size << ")";
+            ref_type last_ref = free_block.first + free_block.second.size - 1;
+            std::cout << "(" << free_block.first << "->" << last_ref << ", size=" << free_block.second.size << ")";
         }
         std::cout << "\n";
     }
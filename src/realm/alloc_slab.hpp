@@ -21,6 +21,8 @@
 
 #include <cstdint> // unint8_t etc
 #include <vector>
+#include <map>
+#include <limits>
 #include <string>
 #include <atomic>
 
@@ -99,6 +101,11 @@ public:
     /// Always initialize the file as if it was a newly
     /// created file and ignore any pre-existing contents. Requires that
     /// Config::session_initiator be true as well.
+    ///
+    /// \var Config::huge_pages
+    /// Place the file mappings and the slabs at addresses that allow them to
+    /// be backed by transparent huge pages, and advise the system to do so.
+    /// Ignored if the system does not support transparent huge pages.
     struct Config {
         bool is_shared = false;
         bool read_only = false;
@@ -106,6 +113,7 @@ public:
         bool skip_validate = false;
         bool session_initiator = false;
         bool clear_file = false;
+        bool huge_pages = false;
         const char* encryption_key = nullptr;
     };
 
@@ -216,6 +224,16 @@ public:
     /// attached to a file. Doing so will result in undefined behavior.
     void resize_file(size_t new_file_size);
 
+    /// Shrink the attached file to the specified size, which must match a
+    /// section boundary. Existing mappings are left in place. This is safe
+    /// as long as nothing is accessed beyond the new end of file until the
+    /// file has been extended again by resize_file(). The same restrictions
+    /// on concurrent use as for resize_file() apply.
+    ///
+    /// It is an error to call this function on an allocator that is not
+    /// attached to a file. Doing so will result in undefined behavior.
+    void truncate_file(size_t new_file_size);
+
     /// Reserve disk space now to avoid allocation errors at a later point in
     /// time, and to minimize on-disk fragmentation. In some cases, less
     /// fragmentation translates into improved performance. On SSD-drives
@@ -282,6 +300,20 @@ public:
     /// call to SlabAlloc::alloc() corresponds to a mutation event.
     bool is_free_space_clean() const noexcept;
 
+    /// Number of ref translations since the last call to
+    /// reset_translation_stats() that were resolved directly from the table of
+    /// mapped sections or from the translation cache (hits), and that required
+    /// a search of the slabs or an encryption read barrier (misses).
+    size_t get_translation_hits() const noexcept;
+    size_t get_translation_misses() const noexcept;
+    void reset_translation_stats() noexcept;
+
+    /// The size of the pages that this allocator requests for its file
+    /// mappings and slabs. This is util::huge_page_size if huge pages were
+    /// requested (Config::huge_pages) and are supported by the system,
+    /// otherwise it is the regular page size.
+    size_t get_effective_page_size() const noexcept;
+
     void verify() const override;
 #ifdef REALM_DEBUG
     void enable_debug(bool enable)
@@ -355,6 +387,88 @@ private:
         size_t size;
     };
 
+    // Free space in the mutable (slab) part of the ref space. The chunks are
+    // kept in a map ordered by ref, so that a freed block can be coalesced
+    // with its neighbours by lookup rather than by scanning. Each chunk is
+    // also filed in a size class bin (bin k holds chunks whose size is in
+    // [2^k, 2^(k+1))), so that do_alloc() can find a large enough chunk in
+    // constant time.
+    class FreeSpace {
+    public:
+        struct Entry {
+            size_t size;
+            size_t bin_ndx; // Position in the bin of its size class
+        };
+        typedef std::map<ref_type, Entry> map_type;
+        typedef map_type::iterator iterator;
+        typedef map_type::const_iterator const_iterator;
+
+        bool empty() const noexcept
+        {
+            return m_chunks.empty();
+        }
+        size_t size() const noexcept
+        {
+            return m_chunks.size();
+        }
+        iterator begin() noexcept
+        {
+            return m_chunks.begin();
+        }
+        iterator end() noexcept
+        {
+            return m_chunks.end();
+        }
+        const_iterator begin() const noexcept
+        {
+            return m_chunks.begin();
+        }
+        const_iterator end() const noexcept
+        {
+            return m_chunks.end();
+        }
+        iterator find(ref_type ref) noexcept
+        {
+            return m_chunks.find(ref);
+        }
+        const_iterator find(ref_type ref) const noexcept
+        {
+            return m_chunks.find(ref);
+        }
+
+        /// Returns the chunk that ends at the specified ref, or end() if
+        /// there is none.
+        iterator find_ending_at(ref_type) noexcept;
+
+        /// Returns a chunk of at least the specified size, or end() if there
+        /// is none. Chunks from the smallest size class that is guaranteed to
+        /// fit are preferred, and within a class, the most recently freed.
+        iterator find_fit(size_t size) noexcept;
+
+        /// Returns true if the specified range overlaps any free chunk.
+        bool intersects(ref_type, size_t size) const noexcept;
+
+        void insert(ref_type, size_t size); // Throws
+
+        /// Change the size of the specified chunk, keeping its ref. Leaves
+        /// the free space unchanged if it throws.
+        void resize(iterator, size_t new_size); // Throws
+
+        void erase(iterator) noexcept;
+        void clear() noexcept;
+
+        void verify() const;
+
+    private:
+        static const int num_size_classes = std::numeric_limits<size_t>::digits;
+        map_type m_chunks;
+        std::vector<iterator> m_bins[num_size_classes];
+        size_t m_nonempty_bins = 0; // Bit k is set if m_bins[k] is not empty
+
+        static int get_size_class(size_t size) noexcept;
+        void remove_from_bin(iterator) noexcept;
+    };
+
     // Values of each used bit in m_flags
     enum {
         flags_SelectBit = 1,
@@ -422,17 +536,41 @@ private:
     typedef std::vector<Slab> slabs;
     typedef std::vector<Chunk> chunks;
     slabs m_slabs;
-    chunks m_free_space;
+    FreeSpace m_free_space;
     chunks m_free_read_only;
 
     bool m_debug_out = false;
-    struct hash_entry {
+    bool m_huge_pages = false;
+
+    // Translation of refs into the additional mappings, one entry per element
+    // of m_local_mappings. It saves do_translate() from going through the
+    // shared pointers and the table of section bases.
+    struct RefTranslation {
+        const char* mapping_addr = nullptr;
+        size_t section_base = 0;
+        util::EncryptedFileMapping* encrypted_mapping = nullptr;
+    };
+    std::unique_ptr<RefTranslation[]> m_ref_translations;
+
+    // Set associative cache of the translations that are expensive to
+    // compute, i.e., refs into slabs and refs into encrypted mappings. All
+    // entries are invalidated by bumping `version`.
+    static const size_t translation_cache_sets = 256;
+    static const size_t translation_cache_ways = 4;
+    struct TranslationCacheEntry {
         ref_type ref = 0;
         const char* addr = nullptr;
         size_t version = 0;
     };
-    mutable hash_entry cache[256];
+    mutable TranslationCacheEntry m_translation_cache[translation_cache_sets][translation_cache_ways];
     mutable size_t version = 1;
+    mutable size_t m_num_translation_hits = 0;
+    mutable size_t m_num_translation_misses = 0;
+
+    static size_t get_translation_cache_set(ref_type) noexcept;
+    /// Copy the global mappings into m_local_mappings and
+    /// m_ref_translations.
+    void update_local_mappings(size_t num_mappings);
 
     /// Throws if free-lists are no longer valid.
     void consolidate_free_read_only();
@@ -449,9 +587,10 @@ private:
     /// if the buffer contains a file in streaming form
     static ref_type get_top_ref(const char* data, size_t len);
 
-    class ChunkRefEq;
-    class ChunkRefEndEq;
-    class SlabRefEndEq;
+    /// Returns true if the specified ref is the end of one of the slabs.
+    bool is_slab_boundary(ref_type) const noexcept;
+    char* allocate_slab_memory(size_t size);
+    void free_slab_memory(char* addr, size_t size) noexcept;
     static bool ref_less_than_slab_ref_end(ref_type, const Slab&) noexcept;
 
     Replication* get_replication() const noexcept
@@ -473,6 +612,34 @@ inline void SlabAlloc::internal_invalidate_cache() noexcept
     ++version;
 }
 
+inline size_t SlabAlloc::get_translation_hits() const noexcept
+{
+    return m_num_translation_hits;
+}
+
+inline size_t SlabAlloc::get_translation_misses() const noexcept
+{
+    return m_num_translation_misses;
+}
+
+inline void SlabAlloc::reset_translation_stats() noexcept
+{
+    m_num_translation_hits = 0;
+    m_num_translation_misses = 0;
+}
+
+inline size_t SlabAlloc::get_translation_cache_set(ref_type ref) noexcept
+{
+    // Refs are 8-byte aligned, so the lowest 3 bits carry no information. We
+    // shift by 16 two times. On 32-bitters it's undefined to shift by 32.
+    // Shifting twice x16 however, is defined and gives zero.
+    size_t h = ref >> 3;
+    h ^= (h >> 16) >> 16;
+    h ^= h >> 16;
+    h ^= h >> 8;
+    return h % translation_cache_sets;
+}
+
 class SlabAlloc::DetachGuard {
 public:
     DetachGuard(SlabAlloc& alloc) noexcept
@@ -33,6 +33,7 @@
 #endif
 
 #include <realm/utilities.hpp>
+#include <realm/util/safe_int_ops.hpp>
 #include <realm/array.hpp>
 #include <realm/array_basic.hpp>
 #include <realm/impl/destroy_guard.hpp>
@@ -71,6 +72,15 @@
 //        0    |  number of bits      |  ceil(width * size / 8)
 //        1    |  number of bytes     |  width * size
 //        2    |  ignored             |  size
+//        3    |  number of bits      |  ceil(width * size / 8) + 8
+//
+//      Width scheme 3 is the frame-of-reference form of an integer
+//      array. The elements are stored as with width scheme 0, but the
+//      value of an element is the stored value plus a 64-bit 'base',
+//      which is found in the last 8 bytes of the array (after padding
+//      the elements to 8-byte alignment). It allows for narrow elements
+//      in arrays of large but close values, such as timestamps or
+//      increasing identifiers. Introduced in file format version 10.
 //
 //  5: 'width_ndx' (3 bits)
 //
@@ -233,6 +243,8 @@ void Array::init_from_mem(MemRef mem) noexcept
 
     m_ref = mem.get_ref();
     m_data = get_data_from_header(header);
+    m_has_base = get_wtype_from_header(header) == wtype_BitsWithBase;
+    m_base = m_has_base ? get_base_from_header(header) : 0;
     set_width(m_width);
 }
 
@@ -378,13 +390,19 @@ void Array::destroy_children(size_t offset) noexcept
 }
 
 
-ref_type Array::do_write_shallow(_impl::ArrayWriterBase& out) const
+ref_type Array::do_write_shallow(_impl::ArrayWriterBase& out, bool persistent) const
 {
     // Write flat array
     const char* header = get_header_from_data(m_data);
     size_t byte_size = get_byte_size();
-    uint32_t dummy_checksum = 0x41414141UL;                                // "AAAA" in ASCII
-    ref_type new_ref = out.write_array(header, byte_size, dummy_checksum); // Throws
+    uint32_t dummy_checksum = 0x41414141UL; // "AAAA" in ASCII
+    ref_type new_ref;
+    if (persistent) {
+        new_ref = out.write_persistent_array(header, byte_size, dummy_checksum); // Throws
+    }
+    else {
+        new_ref = out.write_array(header, byte_size, dummy_checksum); // Throws
+    }
     REALM_ASSERT_3(new_ref % 8, ==, 0);                                    // 8-byte alignment
     return new_ref;
 }
@@ -604,6 +622,8 @@ void Array::insert(size_t ndx, int_fast64_t value)
 {
     REALM_ASSERT_DEBUG(ndx <= m_size);
 
+    if (REALM_UNLIKELY(m_has_base))
+        expand_base(); // Throws
 
     Getter old_getter = m_getter; // Save old getter before potential width expansion
 
@@ -728,6 +748,11 @@ void Array::truncate_and_destroy_children(size_t new_size)
 
 void Array::do_ensure_minimum_width(int_fast64_t value)
 {
+    if (REALM_UNLIKELY(m_has_base)) {
+        expand_base(); // Throws
+        if (value >= m_lbound && value <= m_ubound)
+            return;
+    }
 
     // Make room for the new value
     size_t width = bit_width(value);
@@ -748,7 +773,7 @@ void Array::do_ensure_minimum_width(int_fast64_t value)
 
 void Array::set_all_to_zero()
 {
-    if (m_size == 0 || m_width == 0)
+    if (m_size == 0 || (m_width == 0 && !m_has_base))
         return;
 
     copy_on_write(); // Throws
@@ -762,6 +787,9 @@ void Array::set_all_to_zero()
 
 void Array::adjust_ge(int_fast64_t limit, int_fast64_t diff)
 {
+    if (REALM_UNLIKELY(m_has_base) && diff != 0)
+        expand_base(); // Throws
+
     if (diff != 0) {
         for (size_t i = 0, n = size(); i != n;) {
             REALM_TEMPEX(i = adjust_ge, m_width, (i, n, limit, diff))
@@ -804,23 +832,24 @@ size_t Array::adjust_ge(size_t start, size_t end, int_fast64_t limit, int_fast64
 // This method is mostly used by query_engine to enumerate table row indexes in increasing order through a TableView
 size_t Array::find_gte(const int64_t target, size_t start, size_t end) const
 {
+    const int64_t stored_target = rebase(target);
     switch (m_width) {
         case 0:
-            return find_gte<0>(target, start, end);
+            return find_gte<0>(stored_target, start, end);
         case 1:
-            return find_gte<1>(target, start, end);
+            return find_gte<1>(stored_target, start, end);
         case 2:
-            return find_gte<2>(target, start, end);
+            return find_gte<2>(stored_target, start, end);
         case 4:
-            return find_gte<4>(target, start, end);
+            return find_gte<4>(stored_target, start, end);
         case 8:
-            return find_gte<8>(target, start, end);
+            return find_gte<8>(stored_target, start, end);
         case 16:
-            return find_gte<16>(target, start, end);
+            return find_gte<16>(stored_target, start, end);
         case 32:
-            return find_gte<32>(target, start, end);
+            return find_gte<32>(stored_target, start, end);
         case 64:
-            return find_gte<64>(target, start, end);
+            return find_gte<64>(stored_target, start, end);
         default:
             return not_found;
     }
@@ -841,7 +870,7 @@ size_t Array::find_gte(const int64_t target, size_t start, size_t end) const
     size_t idx;
 
     for (idx = start; idx < end; ++idx) {
-        if (get(idx) >= target) {
+        if (get<w>(idx) >= target) {
             ref = idx;
             break;
         }
@@ -1049,12 +1078,141 @@ size_t find_zero(uint64_t v)
 
 } // anonymous namesapce
 
+#ifdef REALM_COMPILER_AVX
+namespace {
+
+// Reads element 'ndx' of a vector register that was spilled to memory. Used when reducing the lanes of an
+// accumulator at the end of a vectorized loop.
+template <size_t w>
+int64_t get_lane(const char* data, size_t ndx)
+{
+    if (w == 8)
+        return reinterpret_cast<const int8_t*>(data)[ndx];
+    else if (w == 16)
+        return reinterpret_cast<const int16_t*>(data)[ndx];
+    else if (w == 32)
+        return reinterpret_cast<const int32_t*>(data)[ndx];
+    else
+        return reinterpret_cast<const int64_t*>(data)[ndx];
+}
+
+// Sums 'chunks' 32-byte chunks of packed, signed w-bit integers starting at 'data', which need not be aligned. The
+// accumulator has 64-bit lanes, so it cannot overflow before the final int64_t sum would. Only called for w >= 8.
+template <size_t w>
+REALM_TARGET_AVX2 int64_t sum_avx2(const char* data, size_t chunks)
+{
+    const __m256i* p = reinterpret_cast<const __m256i*>(data);
+    __m256i acc = _mm256_setzero_si256();
+
+    for (size_t t = 0; t < chunks; ++t) {
+        __m256i v = _mm256_loadu_si256(p + t);
+        if (w == 8) {
+            // Flip the sign bit to get x + 128 as unsigned bytes, which _mm256_sad_epu8() can sum 8 at a time
+            v = _mm256_xor_si256(v, _mm256_set1_epi8(char(0x80)));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, _mm256_setzero_si256()));
+        }
+        else if (w == 16) {
+            __m256i pairs = _mm256_madd_epi16(v, _mm256_set1_epi16(1)); // 8 x (a + b) as int32
+            acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(pairs)));
+            acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(pairs, 1)));
+        }
+        else if (w == 32) {
+            acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+            acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+        }
+        else {
+            acc = _mm256_add_epi64(acc, v);
+        }
+    }
+
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    int64_t s = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    if (w == 8)
+        s -= int64_t(chunks * sizeof(__m256i)) * 128; // undo the bias from flipping the sign bits
+    return s;
+}
 
-template <bool find_max, size_t w>
-bool Array::minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
+// Finds the maximum (or minimum) of 'chunks' 32-byte chunks of packed, signed w-bit integers starting at 'data',
+// and stores it in 'best'. 'identity' must be the smallest (or largest) value of the width. If 'skip_null' is true,
+// elements equal to 'null_value' are ignored. Returns false if all elements were skipped, in which case 'best' is
+// left untouched. Only called for w >= 8.
+template <bool find_max, bool skip_null, size_t w>
+REALM_TARGET_AVX2 bool minmax_avx2(const char* data, size_t chunks, int64_t identity, int64_t null_value,
+                                   int64_t& best)
 {
-    size_t best_index = 0;
+    const __m256i* p = reinterpret_cast<const __m256i*>(data);
+    __m256i acc, null_vec;
+    __m256i non_null = _mm256_setzero_si256();
+
+    if (w == 8) {
+        acc = _mm256_set1_epi8(char(identity));
+        null_vec = _mm256_set1_epi8(char(null_value));
+    }
+    else if (w == 16) {
+        acc = _mm256_set1_epi16(short(identity));
+        null_vec = _mm256_set1_epi16(short(null_value));
+    }
+    else if (w == 32) {
+        acc = _mm256_set1_epi32(int(identity));
+        null_vec = _mm256_set1_epi32(int(null_value));
+    }
+    else {
+        acc = _mm256_set1_epi64x(identity);
+        null_vec = _mm256_set1_epi64x(null_value);
+    }
+
+    for (size_t t = 0; t < chunks; ++t) {
+        __m256i v = _mm256_loadu_si256(p + t);
+
+        if (skip_null) {
+            // Replace nulls by the identity of the reduction, and remember whether any element was not null
+            __m256i is_null;
+            if (w == 8)
+                is_null = _mm256_cmpeq_epi8(v, null_vec);
+            else if (w == 16)
+                is_null = _mm256_cmpeq_epi16(v, null_vec);
+            else if (w == 32)
+                is_null = _mm256_cmpeq_epi32(v, null_vec);
+            else
+                is_null = _mm256_cmpeq_epi64(v, null_vec);
+            non_null = _mm256_or_si256(non_null, _mm256_xor_si256(is_null, _mm256_set1_epi8(-1)));
+            v = _mm256_blendv_epi8(v, acc, is_null);
+        }
+
+        if (w == 8)
+            acc = find_max ? _mm256_max_epi8(acc, v) : _mm256_min_epi8(acc, v);
+        else if (w == 16)
+            acc = find_max ? _mm256_max_epi16(acc, v) : _mm256_min_epi16(acc, v);
+        else if (w == 32)
+            acc = find_max ? _mm256_max_epi32(acc, v) : _mm256_min_epi32(acc, v);
+        else // AVX2 has no 64-bit max/min instruction
+            acc = _mm256_blendv_epi8(acc, v, find_max ? _mm256_cmpgt_epi64(v, acc) : _mm256_cmpgt_epi64(acc, v));
+    }
+
+    if (skip_null && _mm256_testz_si256(non_null, non_null))
+        return false;
 
+    alignas(32) char lanes[sizeof(__m256i)];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    int64_t m = get_lane<w>(lanes, 0);
+    for (size_t i = 1; i < sizeof(__m256i) * 8 / no0(w); ++i) {
+        int64_t v = get_lane<w>(lanes, i);
+        if (find_max ? v > m : v < m)
+            m = v;
+    }
+    best = m;
+    return true;
+}
+
+} // anonymous namespace
+#endif // REALM_COMPILER_AVX
+
+
+
+template <bool find_max, bool skip_null, size_t w>
+bool Array::minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx, int64_t null_value) const
+{
     if (end == size_t(-1))
         end = m_size;
     REALM_ASSERT_11(start, <, m_size, &&, end, <=, m_size, &&, start, <, end);
@@ -1063,88 +1221,108 @@ bool Array::minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx
         return false;
 
     if (w == 0) {
+        // All elements are zero, which is also the null value of a nullable leaf of this width
+        if (skip_null && null_value == 0)
+            return false;
         if (return_ndx)
-            *return_ndx = best_index;
+            *return_ndx = start;
         result = 0;
         return true;
     }
 
-    int64_t m = get<w>(start);
-    ++start;
-
-#if 0 // We must now return both value AND index of result. SSE does not support finding index, so we've disabled it
-#ifdef REALM_COMPILER_SSE
-    if (sseavx<42>()) {
-        // Test manually until 128 bit aligned
-        for (; (start < end) && (((size_t(m_data) & 0xf) * 8 + start * w) % (128) != 0); start++) {
-            if (find_max ? get<w>(start) > m : get<w>(start) < m) {
-                m = get<w>(start);
-                best_index = start;
-            }
-        }
-
-        if ((w == 8 || w == 16 || w == 32) && end - start > 2 * sizeof (__m128i) * 8 / no0(w)) {
-            __m128i* data = reinterpret_cast<__m128i*>(m_data + start * w / 8);
-            __m128i state = data[0];
-            char state2[sizeof (state)];
-
-            size_t chunks = (end - start) * w / 8 / sizeof (__m128i);
-            for (size_t t = 0; t < chunks; t++) {
-                if (w == 8)
-                    state = find_max ? _mm_max_epi8(data[t], state) : _mm_min_epi8(data[t], state);
-                else if (w == 16)
-                    state = find_max ? _mm_max_epi16(data[t], state) : _mm_min_epi16(data[t], state);
-                else if (w == 32)
-                    state = find_max ? _mm_max_epi32(data[t], state) : _mm_min_epi32(data[t], state);
-
-                start += sizeof (__m128i) * 8 / no0(w);
-            }
-
-            // Todo: prevent taking address of 'state' to make the compiler keep it in SSE register in above loop (vc2010/gcc4.6)
-
-            // We originally had declared '__m128i state2' and did an 'state2 = state' assignment. When we read from state2 through int16_t, int32_t or int64_t in GetUniversal(),
-            // the compiler thinks it cannot alias state2 and hence reorders the read and assignment.
+    int64_t m = 0;
+    bool found = false;
+    size_t best_index = not_found;
+    size_t scalar_start = start;
 
-            // In this fixed version using memcpy, we have char-read-access from __m128i (OK aliasing) and char-write-access to char-array, and finally int8/16/32/64
-            // read access from char-array (OK aliasing).
-            memcpy(&state2, &state, sizeof state);
-            for (size_t t = 0; t < sizeof (__m128i) * 8 / no0(w); ++t) {
-                int64_t v = get_universal<w>(reinterpret_cast<char*>(&state2), t);
-                if (find_max ? v > m : v < m) {
-                    m = v;
-                }
-            }
-        }
+#ifdef REALM_COMPILER_AVX
+    // The vector kernel only yields the value, so the index of its first occurrence is looked up afterwards with
+    // find_first(), which is itself vectorized
+    if ((w == 8 || w == 16 || w == 32 || w == 64) && sseavx<2>() &&
+        end - start >= 2 * sizeof(__m256i) * 8 / no0(w)) {
+        size_t chunks = (end - start) * w / 8 / sizeof(__m256i);
+        int64_t identity = find_max ? lbound_for_width<w>() : ubound_for_width<w>();
+        found = minmax_avx2<find_max, skip_null, w>(m_data + start * w / 8, chunks, identity, null_value, m);
+        scalar_start = start + sizeof(__m256i) * 8 / no0(w) * chunks;
     }
-#endif
 #endif
 
-    for (; start < end; ++start) {
-        const int64_t v = get<w>(start);
-        if (find_max ? v > m : v < m) {
+    for (size_t i = scalar_start; i < end; ++i) {
+        const int64_t v = get<w>(i);
+        if (skip_null && v == null_value)
+            continue;
+        if (!found || (find_max ? v > m : v < m)) {
             m = v;
-            best_index = start;
+            best_index = i;
+            found = true;
         }
     }
 
+    if (!found)
+        return false;
+
     result = m;
-    if (return_ndx)
+    if (return_ndx) {
+        if (best_index == not_found) {
+            // 'm' is a stored value, so the search must not go through find(), which would apply the base
+            QueryState<int64_t> state;
+            state.init(act_ReturnFirst, nullptr, 1);
+            find_optimized<Equal, act_ReturnFirst, w>(m, start, scalar_start, 0, &state, CallbackDummy());
+            best_index = size_t(state.m_state);
+        }
         *return_ndx = best_index;
+    }
     return true;
 }
 
 bool Array::maximum(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
 {
-    REALM_TEMPEX2(return minmax, true, m_width, (result, start, end, return_ndx));
+    bool found;
+    REALM_TEMPEX3(found = minmax, true, false, m_width, (result, start, end, return_ndx, 0));
+    if (found)
+        result += m_base;
+    return found;
 }
 
 bool Array::minimum(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
 {
-    REALM_TEMPEX2(return minmax, false, m_width, (result, start, end, return_ndx));
+    bool found;
+    REALM_TEMPEX3(found = minmax, false, false, m_width, (result, start, end, return_ndx, 0));
+    if (found)
+        result += m_base;
+    return found;
+}
+
+bool Array::maximum_nonnull(int64_t null_value, int64_t& result, size_t start, size_t end,
+                            size_t* return_ndx) const
+{
+    bool found;
+    REALM_TEMPEX3(found = minmax, true, true, m_width, (result, start, end, return_ndx, rebase(null_value)));
+    if (found)
+        result += m_base;
+    return found;
+}
+
+bool Array::minimum_nonnull(int64_t null_value, int64_t& result, size_t start, size_t end,
+                            size_t* return_ndx) const
+{
+    bool found;
+    REALM_TEMPEX3(found = minmax, false, true, m_width, (result, start, end, return_ndx, rebase(null_value)));
+    if (found)
+        result += m_base;
+    return found;
 }
 
 int64_t Array::sum(size_t start, size_t end) const
 {
+    if (REALM_UNLIKELY(m_has_base)) {
+        if (end == size_t(-1))
+            end = m_size;
+        int64_t s;
+        REALM_TEMPEX(s = sum, m_width, (start, end));
+        // Unsigned, so that overflow wraps the same way as when summing the elements one by one
+        return int64_t(uint64_t(s) + uint64_t(m_base) * (end - start));
+    }
     REALM_TEMPEX(return sum, m_width, (start, end));
 }
 
@@ -1217,6 +1395,14 @@ int64_t Array::sum(size_t start, size_t end) const
         start += sizeof(int64_t) * 8 / no0(w) * chunks;
     }
 
+#ifdef REALM_COMPILER_AVX
+    if ((w == 8 || w == 16 || w == 32 || w == 64) && sseavx<2>() && end - start >= sizeof(__m256i) * 8 / no0(w)) {
+        size_t chunks = (end - start) * w / 8 / sizeof(__m256i);
+        s += sum_avx2<w>(m_data + start * w / 8, chunks);
+        start += sizeof(__m256i) * 8 / no0(w) * chunks;
+    }
+#endif
+
 #ifdef REALM_COMPILER_SSE
     if (sseavx<42>()) {
 
@@ -1314,8 +1500,57 @@ int64_t Array::sum(size_t start, size_t end) const
     return s;
 }
 
+// find_optimized() is defined in the header and aggregates the stored elements with these directly
+#define REALM_INSTANTIATE_AGGREGATES(w)                                                                              \
+    template int64_t Array::sum<w>(size_t, size_t) const;                                                            \
+    template bool Array::minmax<true, false, w>(int64_t&, size_t, size_t, size_t*, int64_t) const;                   \
+    template bool Array::minmax<false, false, w>(int64_t&, size_t, size_t, size_t*, int64_t) const;
+REALM_INSTANTIATE_AGGREGATES(0)
+REALM_INSTANTIATE_AGGREGATES(1)
+REALM_INSTANTIATE_AGGREGATES(2)
+REALM_INSTANTIATE_AGGREGATES(4)
+REALM_INSTANTIATE_AGGREGATES(8)
+REALM_INSTANTIATE_AGGREGATES(16)
+REALM_INSTANTIATE_AGGREGATES(32)
+REALM_INSTANTIATE_AGGREGATES(64)
+#undef REALM_INSTANTIATE_AGGREGATES
+
+int64_t Array::sum_nonnull(int64_t null_value, size_t start, size_t end, size_t& non_null_count) const
+{
+    if (end == size_t(-1))
+        end = m_size;
+
+    // Sum all elements, nulls included, and then take the nulls back out. Both passes are vectorized, which is much
+    // faster than testing each element for null.
+    size_t null_count = start < end ? count_range(null_value, start, end) : 0;
+    non_null_count = end - start - null_count;
+    if (non_null_count == 0)
+        return 0;
+
+    // Unsigned, so that an intermediate overflow wraps the same way as summing the non-null elements one by one
+    return int64_t(uint64_t(sum(start, end)) - uint64_t(null_value) * null_count);
+}
+
+size_t Array::count_range(int64_t value, size_t start, size_t end) const noexcept
+{
+    QueryState<int64_t> state;
+    state.init(act_Count, nullptr, size_t(-1));
+    find<Equal>(act_Count, value, start, end, 0, &state);
+    return size_t(state.m_state);
+}
+
 size_t Array::count(int64_t value) const noexcept
 {
+    // The bit-hacks below compare the stored elements directly
+    if (REALM_UNLIKELY(m_has_base))
+        return m_size == 0 ? 0 : count_range(value, 0, m_size);
+
+#ifdef REALM_COMPILER_AVX
+    // For byte-sized elements and up, the vectorized find() beats the bit-hacks below
+    if (m_width >= 8 && sseavx<2>())
+        return m_size == 0 ? 0 : count_range(value, 0, m_size);
+#endif
+
     const uint64_t* next = reinterpret_cast<uint64_t*>(m_data);
     size_t value_count = 0;
     const size_t end = m_size;
@@ -1703,6 +1938,8 @@ void Array::alloc(size_t init_size, size_t width)
     // this method is not public and callers must (and currently do) ensure that
     // needed_bytes are never larger than max_array_payload.
     REALM_ASSERT_3(needed_bytes, <=, max_array_payload);
+    // Callers must expand a frame-of-reference array before they decide on the new width
+    REALM_ASSERT_DEBUG(!m_has_base);
 
     if (is_read_only())
         do_copy_on_write(needed_bytes);
@@ -1854,6 +2091,28 @@ struct Array::VTableForWidth {
 template <size_t width>
 const typename Array::VTableForWidth<width>::PopulatedVTable Array::VTableForWidth<width>::vtable;
 
+// The finders go through find(), which already takes the base into account. The setter is never called, because the
+// array is expanded before it is modified.
+template <size_t width>
+struct Array::VTableForWidthWithBase {
+    struct PopulatedVTable : Array::VTable {
+        PopulatedVTable()
+        {
+            getter = &Array::get_with_base<width>;
+            setter = &Array::set<width>;
+            chunk_getter = &Array::get_chunk_with_base<width>;
+            finder[cond_Equal] = &Array::find<Equal, act_ReturnFirst, width>;
+            finder[cond_NotEqual] = &Array::find<NotEqual, act_ReturnFirst, width>;
+            finder[cond_Greater] = &Array::find<Greater, act_ReturnFirst, width>;
+            finder[cond_Less] = &Array::find<Less, act_ReturnFirst, width>;
+        }
+    };
+    static const PopulatedVTable vtable;
+};
+
+template <size_t width>
+const typename Array::VTableForWidthWithBase<width>::PopulatedVTable Array::VTableForWidthWithBase<width>::vtable;
+
 void Array::set_width(size_t width) noexcept
 {
     REALM_TEMPEX(set_width, width, ());
@@ -1867,10 +2126,103 @@ void Array::set_width() noexcept
 
     m_width = width;
 
-    m_vtable = &VTableForWidth<width>::vtable;
+    if (REALM_UNLIKELY(m_has_base)) {
+        m_vtable = &VTableForWidthWithBase<width>::vtable;
+    }
+    else {
+        m_vtable = &VTableForWidth<width>::vtable;
+    }
     m_getter = m_vtable->getter;
 }
 
+template <size_t w>
+int64_t Array::get_with_base(size_t ndx) const noexcept
+{
+    return get<w>(ndx) + m_base;
+}
+
+template <size_t w>
+void Array::get_chunk_with_base(size_t ndx, int64_t res[8]) const noexcept
+{
+    get_chunk<w>(ndx, res);
+    for (size_t i = 0; i < 8 && ndx + i < m_size; ++i)
+        res[i] += m_base;
+}
+
+int64_t Array::rebase(int64_t value) const noexcept
+{
+    if (util::int_subtract_with_overflow_detect(value, m_base))
+        return m_base > 0 ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+    return value;
+}
+
+bool Array::compress_with_base()
+{
+    REALM_ASSERT(is_attached());
+
+    if (m_has_refs || m_has_base || m_size == 0 || get_wtype_from_header() != wtype_Bits)
+        return false;
+
+    int64_t min_value, max_value;
+    minimum(min_value);
+    maximum(max_value);
+
+    // The elements are stored as their (non-negative) distance from the smallest one
+    uint64_t range = uint64_t(max_value) - uint64_t(min_value);
+    if (range > uint64_t(std::numeric_limits<int64_t>::max()))
+        return false;
+    size_t width = bit_width(int64_t(range));
+    if (width >= m_width)
+        return false;
+    size_t byte_size = calc_byte_size(wtype_BitsWithBase, m_size, uint_least8_t(width));
+    if (byte_size >= get_byte_size())
+        return false;
+
+    MemRef mem = m_alloc.alloc(byte_size); // Throws
+    char* header = mem.get_addr();
+    init_header(header, m_is_inner_bptree_node, m_has_refs, m_context_flag, wtype_BitsWithBase, int(width), m_size,
+                byte_size);
+    char* data = get_data_from_header(header);
+    for (size_t i = 0; i < m_size; ++i)
+        REALM_TEMPEX(set_direct, width, (data, i, get(i) - min_value));
+    *reinterpret_cast<int64_t*>(header + byte_size - 8) = min_value;
+
+    ref_type old_ref = m_ref;
+    const char* old_header = get_header_from_data(m_data);
+    init_from_mem(mem);
+    update_parent();
+    m_alloc.free_(old_ref, old_header);
+    return true;
+}
+
+void Array::expand_base()
+{
+    REALM_ASSERT_DEBUG(m_has_base);
+
+    int64_t min_value = 0, max_value = 0;
+    minimum(min_value);
+    maximum(max_value);
+    size_t width = std::max(bit_width(min_value), bit_width(max_value));
+
+    // Leave some room for growth, as is done by do_copy_on_write()
+    size_t byte_size = calc_byte_size(wtype_Bits, m_size, uint_least8_t(width));
+    if (byte_size < max_array_payload - 64)
+        byte_size += 64;
+    MemRef mem = m_alloc.alloc(byte_size); // Throws
+    char* header = mem.get_addr();
+    init_header(header, m_is_inner_bptree_node, m_has_refs, m_context_flag, wtype_Bits, int(width), m_size,
+                byte_size);
+    char* data = get_data_from_header(header);
+    for (size_t i = 0; i < m_size; ++i)
+        REALM_TEMPEX(set_direct, width, (data, i, get(i)));
+
+    ref_type old_ref = m_ref;
+    const char* old_header = get_header_from_data(m_data);
+    init_from_mem(mem);
+    update_parent();
+    m_alloc.free_(old_ref, old_header);
+}
+
 // This method reads 8 concecutive values into res[8], starting from index 'ndx'. It's allowed for the 8 values to
 // exceed array length; in this case, remainder of res[8] will be left untouched.
 template <size_t w>
@@ -1954,6 +2306,10 @@ ref_type Array::bptree_leaf_insert(size_t ndx, int64_t value, TreeInsertBase& st
     if (ndx == leaf_size) {
         new_leaf.add(value); // Throws
         state.m_split_offset = ndx;
+        // Appends continue in the new leaf, so this one is now likely to stay unmodified. That makes it a good
+        // candidate for the more compact, but read-only, frame-of-reference form.
+        if (m_alloc.allows_compact_leaves())
+            compress_with_base(); // Throws
     }
     else {
         for (size_t i = ndx; i != leaf_size; ++i)
@@ -2114,12 +2470,19 @@ VerifyBptreeResult verify_bptree(const Array& node, Array::LeafVerifier leaf_ver
     REALM_ASSERT_3(node.get_type(), ==, Array::type_InnerBptreeNode);
 
     REALM_ASSERT_3(node.size(), >=, 2);
-    size_t num_children = node.size() - 2;
+    size_t num_children = BpTreeNode::get_num_bptree_children_from_header(node.get_mem().get_addr());
 
     // Verify invar:bptree-nonempty-inner
     REALM_ASSERT_3(num_children, >=, 1);
 
     Allocator& alloc = node.get_alloc();
+    Array summary(alloc);
+    if (node.get_context_flag()) {
+        summary.init_from_ref(node.get_as_ref(node.size() - 2));
+        summary.verify();
+        REALM_ASSERT_3(summary.get_type(), ==, Array::type_Normal);
+        REALM_ASSERT_3(summary.size(), ==, 2 * num_children);
+    }
     Array offsets(alloc);
     size_t elems_per_child = 0;
     bool general_form;
@@ -2150,6 +2513,16 @@ VerifyBptreeResult verify_bptree(const Array& node, Array::LeafVerifier leaf_ver
             // Verify invar:bptree-nonempty-leaf
             REALM_ASSERT_3(elems_in_child, >=, 1);
             leaf_level_of_child = 0;
+            // Verify that the summary covers all values in the leaf
+            if (summary.is_attached()) {
+                Array leaf(alloc);
+                leaf.init_from_ref(child_ref);
+                int64_t min = 0, max = 0;
+                leaf.minimum(min);
+                leaf.maximum(max);
+                REALM_ASSERT_3(summary.get(2 * i), <=, min);
+                REALM_ASSERT_3(summary.get(2 * i + 1), >=, max);
+            }
         }
         else {
             Array child(alloc);
@@ -2160,6 +2533,17 @@ VerifyBptreeResult verify_bptree(const Array& node, Array::LeafVerifier leaf_ver
             // Verify invar:bptree-node-form
             bool child_on_general_form = std::get<2>(r);
             REALM_ASSERT(general_form || !child_on_general_form);
+            // Either all, or none of the inner nodes carry a summary,
+            // and the summary must cover that of the child
+            REALM_ASSERT_3(child.get_context_flag(), ==, summary.is_attached());
+            if (summary.is_attached()) {
+                Array child_summary(alloc);
+                child_summary.init_from_ref(child.get_as_ref(child.size() - 2));
+                for (size_t j = 0; j != child_summary.size(); j += 2) {
+                    REALM_ASSERT_3(summary.get(2 * i), <=, child_summary.get(j));
+                    REALM_ASSERT_3(summary.get(2 * i + 1), >=, child_summary.get(j + 1));
+                }
+            }
         }
         if (i == 0)
             leaf_level_of_children = leaf_level_of_child;
@@ -2240,7 +2624,13 @@ void Array::dump_bptree_structure(std::ostream& out, int level, LeafDumper leaf_
         out << ")\n";
     }
 
-    size_t num_children = size() - 2;
+    bool has_summary = get_context_flag();
+    if (has_summary) {
+        out << std::setw(indent) << ""
+            << "  Summary (ref: " << get_as_ref(size() - 2) << ")\n";
+    }
+
+    size_t num_children = BpTreeNode::get_num_bptree_children_from_header(get_mem().get_addr());
     size_t child_ref_begin = 1;
     size_t child_ref_end = 1 + num_children;
     for (size_t i = child_ref_begin; i != child_ref_end; ++i) {
@@ -2273,9 +2663,17 @@ void Array::bptree_to_dot(std::ostream& out, ToDotHandler& handler) const
         offsets.to_dot(out, "Offsets");
     }
 
+    bool has_summary = get_context_flag();
+    if (has_summary) {
+        Array summary(m_alloc);
+        summary.init_from_ref(get_as_ref(size() - 2));
+        summary.set_parent(const_cast<Array*>(this), size() - 2);
+        summary.to_dot(out, "Summary");
+    }
+
     out << "}" << std::endl;
 
-    size_t num_children = size() - 2;
+    size_t num_children = BpTreeNode::get_num_bptree_children_from_header(get_mem().get_addr());
     size_t child_ref_begin = 1;
     size_t child_ref_end = 1 + num_children;
     for (size_t i = child_ref_begin; i != child_ref_end; ++i) {
@@ -2354,12 +2752,12 @@ void Array::to_dot_parent_edge(std::ostream& out) const
 
 size_t Array::lower_bound_int(int64_t value) const noexcept
 {
-    REALM_TEMPEX(return lower_bound, m_width, (m_data, m_size, value));
+    REALM_TEMPEX(return lower_bound, m_width, (m_data, m_size, rebase(value)));
 }
 
 size_t Array::upper_bound_int(int64_t value) const noexcept
 {
-    REALM_TEMPEX(return upper_bound, m_width, (m_data, m_size, value));
+    REALM_TEMPEX(return upper_bound, m_width, (m_data, m_size, rebase(value)));
 }
 
 
@@ -2414,7 +2812,7 @@ int_fast64_t Array::get(const char* header, size_t ndx) noexcept
 {
     const char* data = get_data_from_header(header);
     uint_least8_t width = get_width_from_header(header);
-    return get_direct(data, width, ndx);
+    return get_direct(data, width, ndx) + get_base_from_header(header);
 }
 
 
@@ -2423,7 +2821,8 @@ std::pair<int64_t, int64_t> Array::get_two(const char* header, size_t ndx) noexc
     const char* data = get_data_from_header(header);
     uint_least8_t width = get_width_from_header(header);
     std::pair<int64_t, int64_t> p = ::get_two(data, width, ndx);
-    return std::make_pair(p.first, p.second);
+    int64_t base = get_base_from_header(header);
+    return std::make_pair(p.first + base, p.second + base);
 }
 
 
@@ -70,6 +70,9 @@ Searching: The main finding function is:
 #include <emmintrin.h>             // SSE2
 #include <realm/realm_nmmintrin.h> // SSE42
 #endif
+#ifdef REALM_COMPILER_AVX
+#include <immintrin.h> // AVX2, AVX-512 (only used from REALM_TARGET_AVX2/REALM_TARGET_AVX512 functions)
+#endif
 
 namespace realm {
 
@@ -172,6 +175,7 @@ protected:
 struct TreeInsertBase {
     size_t m_split_offset;
     size_t m_split_size;
+    size_t m_num_inserted = 1; // Number of elements added to the tree by one insertion
 };
 
 /// Provides access to individual array nodes of the database.
@@ -552,6 +556,17 @@ public:
 
     bool minimum(int64_t& result, size_t start = 0, size_t end = size_t(-1), size_t* return_ndx = nullptr) const;
 
+    /// Re-encode this array in the frame-of-reference form (see
+    /// wtype_BitsWithBase), where each element is stored as its distance from
+    /// the smallest element. Returns false, leaving the array unchanged, if it
+    /// has refs or the encoded form would not be smaller. The encoded form is
+    /// read-only in the sense that any modification expands the array back to
+    /// the plain form first.
+    bool compress_with_base();
+
+    /// Returns true if this array is in the frame-of-reference form.
+    bool has_base() const noexcept;
+
     /// This information is guaranteed to be cached in the array accessor.
     bool is_inner_bptree_node() const noexcept;
 
@@ -757,6 +772,18 @@ public:
 
 #endif
 
+// AVX2 and AVX-512 find for the four functions Equal/NotEqual/Less/Greater. 'items' is the number of 32-byte
+// (AVX2) or 64-byte (AVX-512) chunks starting at 'data', which need not be aligned.
+#ifdef REALM_COMPILER_AVX
+    template <class cond, Action action, size_t width, class Callback>
+    REALM_TARGET_AVX2 bool find_avx2(int64_t value, const char* data, size_t items, QueryState<int64_t>* state,
+                                     size_t baseindex, Callback callback) const;
+
+    template <class cond, Action action, size_t width, class Callback>
+    REALM_TARGET_AVX512 bool find_avx512(int64_t value, const char* data, size_t items, QueryState<int64_t>* state,
+                                         size_t baseindex, Callback callback) const;
+#endif
+
     template <size_t width>
     inline bool test_zero(uint64_t value) const; // Tests value for 0-elements
 
@@ -817,6 +844,7 @@ public:
         wtype_Bits = 0,
         wtype_Multiply = 1,
         wtype_Ignore = 2,
+        wtype_BitsWithBase = 3, // Like wtype_Bits, but followed by a 64-bit base added to every element
     };
 
     static bool get_is_inner_bptree_node_from_header(const char*) noexcept;
@@ -828,6 +856,10 @@ public:
 
     static Type get_type_from_header(const char*) noexcept;
 
+    /// The base of an array whose width type is wtype_BitsWithBase, or zero
+    /// for any other width type.
+    static int64_t get_base_from_header(const char*) noexcept;
+
     /// Get the number of bytes currently in use by this array. This
     /// includes the array header, but it does not include allocated
     /// bytes corresponding to excess capacity. The result is
@@ -944,11 +976,31 @@ private:
     void do_copy_on_write(size_t minimum_size = 0);
     void do_ensure_minimum_width(int_fast64_t);
 
+    // Turn a frame-of-reference array back into a plain wtype_Bits array. Must be done before any modification.
+    void expand_base();
+
+    // Translate a value into the domain of the stored elements of a frame-of-reference array, saturating if it
+    // falls outside of what int64_t can represent there. Saturation preserves the outcome of every comparison
+    // against a stored element, because those are at most 32 bits wide.
+    int64_t rebase(int64_t value) const noexcept;
+
+    template <size_t w>
+    int64_t get_with_base(size_t ndx) const noexcept;
+
+    template <size_t w>
+    void get_chunk_with_base(size_t ndx, int64_t res[8]) const noexcept;
+
+    template <class cond, Action action, size_t bitwidth, class Callback>
+    bool find_with_base(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
+                        Callback callback) const;
+
     template <size_t w>
     int64_t sum(size_t start, size_t end) const;
 
-    template <bool max, size_t w>
-    bool minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx) const;
+    size_t count_range(int64_t value, size_t start, size_t end) const noexcept;
+
+    template <bool max, bool skip_null, size_t w>
+    bool minmax(int64_t& result, size_t start, size_t end, size_t* return_ndx, int64_t null_value) const;
 
     template <size_t w>
     size_t find_gte(const int64_t target, size_t start, size_t end) const;
@@ -957,6 +1009,13 @@ private:
     size_t adjust_ge(size_t start, size_t end, int_fast64_t limit, int_fast64_t diff);
 
 protected:
+    // Variants of sum(), maximum() and minimum() for the leaves of ArrayIntNull, where elements equal to 'null_value'
+    // are nulls and must be ignored. sum_nonnull() reports the number of non-null elements in 'non_null_count', and
+    // maximum_nonnull()/minimum_nonnull() return false if the range holds only nulls.
+    int64_t sum_nonnull(int64_t null_value, size_t start, size_t end, size_t& non_null_count) const;
+    bool maximum_nonnull(int64_t null_value, int64_t& result, size_t start, size_t end, size_t* return_ndx) const;
+    bool minimum_nonnull(int64_t null_value, int64_t& result, size_t start, size_t end, size_t* return_ndx) const;
+
     /// The total size in bytes (including the header) of a new empty
     /// array. Must be a multiple of 8 (i.e., 64-bit aligned).
     static const size_t initial_capacity = 128;
@@ -1004,6 +1063,8 @@ protected:
     };
     template <size_t w>
     struct VTableForWidth;
+    template <size_t w>
+    struct VTableForWidthWithBase;
 
 protected:
     /// Takes a 64-bit value and returns the minimum number of bits needed
@@ -1047,9 +1108,13 @@ protected:
     bool m_is_inner_bptree_node; // This array is an inner node of B+-tree.
     bool m_has_refs;             // Elements whose first bit is zero are refs to subarrays.
     bool m_context_flag;         // Meaning depends on context.
+    bool m_has_base = false;     // Array is in the frame-of-reference form (wtype_BitsWithBase).
+    int64_t m_base = 0;          // Added to every stored element if m_has_base is set.
 
 private:
-    ref_type do_write_shallow(_impl::ArrayWriterBase&) const;
+    // The array data of \a persistent arrays stays unmodified until the
+    // writer is done, see ArrayWriterBase::write_persistent_array().
+    ref_type do_write_shallow(_impl::ArrayWriterBase&, bool persistent = false) const;
     ref_type do_write_deep(_impl::ArrayWriterBase&, bool only_if_modified) const;
     static size_t calc_byte_size(WidthType wtype, size_t size, uint_least8_t width) noexcept;
 
@@ -1409,6 +1474,11 @@ inline void Array::ensure_minimum_width(RefOrTagged ref_or_tagged)
     ensure_minimum_width(ref_or_tagged.m_value); // Throws
 }
 
+inline bool Array::has_base() const noexcept
+{
+    return m_has_base;
+}
+
 inline bool Array::is_inner_bptree_node() const noexcept
 {
     return m_is_inner_bptree_node;
@@ -1482,7 +1552,7 @@ inline ref_type Array::write(_impl::ArrayWriterBase& out, bool deep, bool only_i
         return m_ref;
 
     if (!deep || !m_has_refs)
-        return do_write_shallow(out); // Throws
+        return do_write_shallow(out, true); // Throws
 
     return do_write_deep(out, only_if_modified); // Throws
 }
@@ -1496,7 +1566,7 @@ inline ref_type Array::write(ref_type ref, Allocator& alloc, _impl::ArrayWriterB
     array.init_from_ref(ref);
 
     if (!array.m_has_refs)
-        return array.do_write_shallow(out); // Throws
+        return array.do_write_shallow(out, true); // Throws
 
     return array.do_write_deep(out, only_if_modified); // Throws
 }
@@ -1631,6 +1701,14 @@ inline size_t Array::get_capacity_from_header(const char* header) noexcept
     const uchar* h = reinterpret_cast<const uchar*>(header);
     return (size_t(h[0]) << 16) + (size_t(h[1]) << 8) + h[2];
 }
+inline int64_t Array::get_base_from_header(const char* header) noexcept
+{
+    if (get_wtype_from_header(header) != wtype_BitsWithBase)
+        return 0;
+    // The base occupies the last 8 bytes of the array
+    size_t byte_size = calc_byte_size(wtype_BitsWithBase, get_size_from_header(header), get_width_from_header(header));
+    return *reinterpret_cast<const int64_t*>(header + byte_size - 8);
+}
 
 
 inline char* Array::get_data_from_header(char* header) noexcept
@@ -1810,6 +1888,12 @@ inline size_t Array::calc_byte_size(WidthType wtype, size_t size, uint_least8_t
         case wtype_Ignore:
             num_bytes = size;
             break;
+        case wtype_BitsWithBase: {
+            REALM_ASSERT_3(size, <, 0x1000000);
+            size_t num_bits = size * width;
+            num_bytes = (num_bits + 7) >> 3;
+            break;
+        }
     }
 
     // Ensure 8-byte alignment
@@ -1817,6 +1901,10 @@ inline size_t Array::calc_byte_size(WidthType wtype, size_t size, uint_least8_t
 
     num_bytes += header_size;
 
+    // Room for the base
+    if (wtype == wtype_BitsWithBase)
+        num_bytes += 8;
+
     return num_bytes;
 }
 
@@ -1972,6 +2060,11 @@ inline bool Array::is_read_only() const noexcept
 
 inline void Array::copy_on_write()
 {
+    if (REALM_UNLIKELY(m_has_base)) {
+        // Always relocates the array
+        expand_base(); // Throws
+        return;
+    }
 #if REALM_ENABLE_MEMDEBUG
     // We want to relocate this array regardless if there is a need or not, in order to catch use-after-free bugs.
     // Only exception is inside GroupWriter::write_group() (see explanation at the definition of the m_no_relocation
@@ -2215,8 +2308,45 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
         end = nullable_array ? size() - 1 : size();
 
     if (nullable_array) {
-        // We were called by find() of a nullable array. So skip first entry, take nulls in count, etc, etc. Fixme:
-        // Huge speed optimizations are possible here! This is a very simple generic method.
+        // We were called by find() of a nullable array. So skip first entry, take nulls in count, etc, etc.
+
+        // Aggregates over all non-null elements, as done by Table::sum_int() and Query::sum_int() etc. on nullable
+        // columns, use the vectorized aggregate methods instead of the generic loop below, unless 'limit' could stop
+        // the search somewhere in this range
+        if (std::is_same<cond, NotNull>::value &&
+            (action == act_Sum || action == act_Max || action == act_Min || action == act_Count) && start2 < end &&
+            state->m_limit - state->m_match_count >= end - start2) {
+            const int64_t null_value = get(0);
+            size_t non_null_count;
+
+            if (action == act_Sum) {
+                int64_t res = sum_nonnull(null_value, start2 + 1, end + 1, non_null_count);
+                if (non_null_count > 0) {
+                    find_action<action, Callback>(start2 + baseindex, res, state, callback);
+                    // find_action will increment match count by 1, so add the remaining non-null elements
+                    state->m_match_count += non_null_count - 1;
+                }
+            }
+            else if (action == act_Max || action == act_Min) {
+                int64_t res;
+                size_t res_ndx;
+                bool found = action == act_Max ? maximum_nonnull(null_value, res, start2 + 1, end + 1, &res_ndx)
+                                               : minimum_nonnull(null_value, res, start2 + 1, end + 1, &res_ndx);
+                if (found) {
+                    non_null_count = end - start2 - count_range(null_value, start2 + 1, end + 1);
+                    find_action<action, Callback>(res_ndx - 1 + baseindex, res, state, callback);
+                    state->m_match_count += non_null_count - 1;
+                }
+            }
+            else {
+                non_null_count = end - start2 - count_range(null_value, start2 + 1, end + 1);
+                state->m_state += non_null_count;
+                state->m_match_count = size_t(state->m_state);
+            }
+            return true;
+        }
+
+        // Fixme: Huge speed optimizations are possible here! This is a very simple generic method.
         for (; start2 < end; start2++) {
             int64_t v = get<bitwidth>(start2 + 1);
             if (c(v, value, v == get(0), find_null)) {
@@ -2286,11 +2416,11 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
             int64_t res;
             size_t res_ndx = 0;
             if (action == act_Sum)
-                res = Array::sum(start2, end2);
+                res = sum<bitwidth>(start2, end2);
             if (action == act_Max)
-                Array::maximum(res, start2, end2, &res_ndx);
+                minmax<true, false, bitwidth>(res, start2, end2, &res_ndx, 0);
             if (action == act_Min)
-                Array::minimum(res, start2, end2, &res_ndx);
+                minmax<false, false, bitwidth>(res, start2, end2, &res_ndx, 0);
 
             find_action<action, Callback>(res_ndx + baseindex, res, state, callback);
             // find_action will increment match count by 1, so we need to `-1` from the number of elements that
@@ -2311,6 +2441,32 @@ bool Array::find_optimized(int64_t value, size_t start, size_t end, size_t basei
     // finder cannot handle this bitwidth
     REALM_ASSERT_3(m_width, !=, 0);
 
+#if defined(REALM_COMPILER_AVX)
+    // Prefer AVX-512 / AVX2 when the CPU has it and the payload is at least one 256-bit chunk in size. The vector
+    // kernels use unaligned loads, so only the remainder that doesn't fill a whole vector is left to compare().
+    if (m_width >= 8 && sseavx<2>() && (end - start2) * no0(bitwidth) / 8 >= sizeof(__m256i)) {
+        const size_t vector_size = sseavx<512>() ? sizeof(__m512i) : sizeof(__m256i);
+        const size_t items = (end - start2) * no0(bitwidth) / 8 / vector_size;
+        const size_t end2 = start2 + items * vector_size * 8 / no0(bitwidth);
+        const char* const a = m_data + start2 * no0(bitwidth) / 8;
+
+        if (items > 0) {
+            if (sseavx<512>()) {
+                if (!find_avx512<cond, action, bitwidth, Callback>(value, a, items, state, baseindex + start2,
+                                                                   callback))
+                    return false;
+            }
+            else {
+                if (!find_avx2<cond, action, bitwidth, Callback>(value, a, items, state, baseindex + start2,
+                                                                 callback))
+                    return false;
+            }
+        }
+
+        return compare<cond, action, bitwidth, Callback>(value, end2, end, baseindex, state, callback);
+    }
+#endif
+
 #if defined(REALM_COMPILER_SSE)
     // Only use SSE if payload is at least one SSE chunk (128 bits) in size. Also note taht SSE doesn't support
     // Less-than comparison for 64-bit values.
@@ -2683,7 +2839,7 @@ inline bool Array::compare_equality(int64_t value, size_t start, size_t end, siz
                 if (a >= 64 / no0(width))
                     break;
 
-                if (!find_action<action, Callback>(a + start + baseindex, get<width>(start + t), state, callback))
+                if (!find_action<action, Callback>(a + start + baseindex, get<width>(a + start), state, callback))
                     return false;
                 v2 >>= (t + 1) * width;
                 a += 1;
@@ -2732,10 +2888,47 @@ template <class cond, Action action, size_t bitwidth, class Callback>
 bool Array::find(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
                  Callback callback, bool nullable_array, bool find_null) const
 {
+    if (REALM_UNLIKELY(m_has_base)) {
+        REALM_ASSERT_DEBUG(!nullable_array);
+        return find_with_base<cond, action, bitwidth, Callback>(value, start, end, baseindex, state, callback);
+    }
     return find_optimized<cond, action, bitwidth, Callback>(value, start, end, baseindex, state, callback,
                                                             nullable_array, find_null);
 }
 
+// The search itself runs over the stored elements, so only the aggregates that depend on the values of the matches
+// need to have the base added back in. They are collected in a separate state for that purpose.
+template <class cond, Action action, size_t bitwidth, class Callback>
+bool Array::find_with_base(int64_t value, size_t start, size_t end, size_t baseindex, QueryState<int64_t>* state,
+                           Callback callback) const
+{
+    int64_t stored_value = rebase(value);
+    if (action != act_Sum && action != act_Max && action != act_Min)
+        return find_optimized<cond, action, bitwidth, Callback>(stored_value, start, end, baseindex, state, callback);
+
+    QueryState<int64_t> state_2;
+    state_2.init(action, nullptr, state->m_limit - state->m_match_count);
+    bool cont = find_optimized<cond, action, bitwidth, Callback>(stored_value, start, end, baseindex, &state_2,
+                                                                 callback);
+    if (state_2.m_match_count == 0)
+        return cont;
+
+    if (action == act_Sum) {
+        // Unsigned, so that overflow wraps the same way as when summing the elements one by one
+        state->m_state = int64_t(uint64_t(state->m_state) + uint64_t(state_2.m_state) +
+                                 uint64_t(m_base) * state_2.m_match_count);
+    }
+    else {
+        int64_t v = state_2.m_state + m_base;
+        if (action == act_Max ? v > state->m_state : v < state->m_state) {
+            state->m_state = v;
+            state->m_minmax_index = state_2.m_minmax_index;
+        }
+    }
+    state->m_match_count += state_2.m_match_count;
+    return cont;
+}
+
 #ifdef REALM_COMPILER_SSE
 // 'items' is the number of 16-byte SSE chunks. Returns index of packed element relative to first integer of first
 // chunk
@@ -2839,6 +3032,135 @@ REALM_FORCEINLINE bool Array::find_sse_intern(__m128i* action_data, __m128i* dat
 }
 #endif // REALM_COMPILER_SSE
 
+#ifdef REALM_COMPILER_AVX
+template <class cond, Action action, size_t width, class Callback>
+REALM_TARGET_AVX2 bool Array::find_avx2(int64_t value, const char* data, size_t items, QueryState<int64_t>* state,
+                                        size_t baseindex, Callback callback) const
+{
+    // Also instantiated for width < 8, but find_optimized() only calls it for width >= 8
+    const size_t bytes_per_element = no0(width / 8);
+    __m256i search;
+
+    if (width == 8)
+        search = _mm256_set1_epi8(static_cast<char>(value));
+    else if (width == 16)
+        search = _mm256_set1_epi16(static_cast<short int>(value));
+    else if (width == 32)
+        search = _mm256_set1_epi32(static_cast<int>(value));
+    else
+        search = _mm256_set1_epi64x(value);
+
+    // _mm256_movemask_epi8() yields one bit per byte, so keep only the bit of the most significant byte of each
+    // element. This gives find_action_pattern() exactly one set bit per match.
+    const uint32_t element_bits = uint32_t(lower_bits<width / 8>() << (bytes_per_element - 1));
+
+    for (size_t i = 0; i < items; ++i) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data) + i);
+        __m256i compare_result;
+
+        if (std::is_same<cond, Equal>::value || std::is_same<cond, NotEqual>::value) {
+            if (width == 8)
+                compare_result = _mm256_cmpeq_epi8(chunk, search);
+            else if (width == 16)
+                compare_result = _mm256_cmpeq_epi16(chunk, search);
+            else if (width == 32)
+                compare_result = _mm256_cmpeq_epi32(chunk, search);
+            else
+                compare_result = _mm256_cmpeq_epi64(chunk, search);
+        }
+        else {
+            // AVX2 has no signed less-than, so Less is computed as Greater with swapped operands
+            __m256i lhs = std::is_same<cond, Greater>::value ? chunk : search;
+            __m256i rhs = std::is_same<cond, Greater>::value ? search : chunk;
+            if (width == 8)
+                compare_result = _mm256_cmpgt_epi8(lhs, rhs);
+            else if (width == 16)
+                compare_result = _mm256_cmpgt_epi16(lhs, rhs);
+            else if (width == 32)
+                compare_result = _mm256_cmpgt_epi32(lhs, rhs);
+            else
+                compare_result = _mm256_cmpgt_epi64(lhs, rhs);
+        }
+
+        uint32_t resmask = uint32_t(_mm256_movemask_epi8(compare_result));
+        if (std::is_same<cond, NotEqual>::value)
+            resmask = ~resmask;
+        resmask &= element_bits;
+
+        if (resmask == 0)
+            continue;
+
+        size_t s = i * sizeof(__m256i) / bytes_per_element;
+        if (find_action_pattern<action, Callback>(s + baseindex, resmask, state, callback))
+            continue;
+
+        while (resmask != 0) {
+            size_t ndx = s + first_set_bit(resmask) / bytes_per_element;
+            if (!find_action<action, Callback>(ndx + baseindex, get_universal<width>(data, ndx), state, callback))
+                return false;
+            resmask &= resmask - 1;
+        }
+    }
+
+    return true;
+}
+
+template <class cond, Action action, size_t width, class Callback>
+REALM_TARGET_AVX512 bool Array::find_avx512(int64_t value, const char* data, size_t items,
+                                            QueryState<int64_t>* state, size_t baseindex, Callback callback) const
+{
+    // Also instantiated for width < 8, but find_optimized() only calls it for width >= 8
+    const size_t elements_per_chunk = sizeof(__m512i) / no0(width / 8);
+    __m512i search;
+
+    if (width == 8)
+        search = _mm512_set1_epi8(static_cast<char>(value));
+    else if (width == 16)
+        search = _mm512_set1_epi16(static_cast<short int>(value));
+    else if (width == 32)
+        search = _mm512_set1_epi32(static_cast<int>(value));
+    else
+        search = _mm512_set1_epi64(value);
+
+    // The AVX-512 compares write one mask bit per element, so no post-processing of the mask is needed
+    const int predicate = std::is_same<cond, Equal>::value
+                              ? _MM_CMPINT_EQ
+                              : std::is_same<cond, NotEqual>::value
+                                    ? _MM_CMPINT_NE
+                                    : std::is_same<cond, Greater>::value ? _MM_CMPINT_NLE : _MM_CMPINT_LT;
+
+    for (size_t i = 0; i < items; ++i) {
+        __m512i chunk = _mm512_loadu_si512(data + i * sizeof(__m512i));
+        uint64_t resmask;
+
+        if (width == 8)
+            resmask = _mm512_cmp_epi8_mask(chunk, search, predicate);
+        else if (width == 16)
+            resmask = _mm512_cmp_epi16_mask(chunk, search, predicate);
+        else if (width == 32)
+            resmask = _mm512_cmp_epi32_mask(chunk, search, predicate);
+        else
+            resmask = _mm512_cmp_epi64_mask(chunk, search, predicate);
+
+        if (resmask == 0)
+            continue;
+
+        size_t s = i * elements_per_chunk;
+        if (find_action_pattern<action, Callback>(s + baseindex, resmask, state, callback))
+            continue;
+
+        while (resmask != 0) {
+            size_t ndx = s + first_set_bit64(resmask);
+            if (!find_action<action, Callback>(ndx + baseindex, get_universal<width>(data, ndx), state, callback))
+                return false;
+            resmask &= resmask - 1;
+        }
+    }
+
+    return true;
+}
+#endif // REALM_COMPILER_AVX
+
 template <class cond, Action action, class Callback>
 bool Array::compare_leafs(const Array* foreign, size_t start, size_t end, size_t baseindex,
                           QueryState<int64_t>* state, Callback callback) const
@@ -2882,6 +3204,17 @@ bool Array::compare_leafs(const Array* foreign, size_t start, size_t end, size_t
         return true;
     }
 
+    if (REALM_UNLIKELY(m_has_base || foreign->m_has_base)) {
+        // The optimized versions below compare the stored elements directly
+        for (; start < end; ++start) {
+            v = get(start);
+            if (c(v, foreign->get(start)))
+                if (!find_action<action, Callback>(start + baseindex, v, state, callback))
+                    return false;
+        }
+        return true;
+    }
+
     bool r;
     REALM_TEMPEX4(r = compare_leafs, cond, action, m_width, Callback,
                   (foreign, start, end, baseindex, state, callback))
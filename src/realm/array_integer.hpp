@@ -439,17 +439,10 @@ inline size_t ArrayIntNull::upper_bound(int64_t value) const noexcept
 
 inline int64_t ArrayIntNull::sum(size_t start, size_t end) const
 {
-    // FIXME: Optimize
-    int64_t sum_of_range = 0;
     if (end == npos)
         end = size();
-    for (size_t i = start; i < end; ++i) {
-        value_type x = get(i);
-        if (x) {
-            sum_of_range += *x;
-        }
-    }
-    return sum_of_range;
+    size_t non_null_count;
+    return sum_nonnull(null_value(), start + 1, end + 1, non_null_count);
 }
 
 inline size_t ArrayIntNull::count(int64_t value) const noexcept
@@ -461,51 +454,23 @@ inline size_t ArrayIntNull::count(int64_t value) const noexcept
     return count_of_value;
 }
 
-// FIXME: Optimize
 template <bool find_max>
 inline bool ArrayIntNull::minmax_helper(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
 {
-    size_t best_index = 1;
-
-    if (end == npos) {
-        end = m_size;
-    }
-
-    ++start;
-
-    REALM_ASSERT(start < m_size && end <= m_size && start < end);
+    if (end == npos)
+        end = size();
 
-    if (m_size == 1) {
-        // empty array
+    if (start >= end) {
+        // empty range
         return false;
     }
 
-    if (m_width == 0) {
-        if (return_ndx)
-            *return_ndx = best_index - 1;
-        result = 0;
-        return true;
-    }
-
-    int64_t m = Array::get(start);
-
-    const int64_t null_val = null_value();
-    for (; start < end; ++start) {
-        const int64_t v = Array::get(start);
-        if (find_max ? v > m : v < m) {
-            if (v == null_val) {
-                continue;
-            }
-            m = v;
-            best_index = start;
-        }
-    }
-
-    result = m;
-    if (return_ndx) {
+    size_t best_index;
+    bool found = find_max ? maximum_nonnull(null_value(), result, start + 1, end + 1, &best_index)
+                          : minimum_nonnull(null_value(), result, start + 1, end + 1, &best_index);
+    if (found && return_ndx)
         *return_ndx = best_index - 1;
-    }
-    return true;
+    return found;
 }
 
 inline bool ArrayIntNull::maximum(int64_t& result, size_t start, size_t end, size_t* return_ndx) const
@@ -16,6 +16,12 @@
  *
  **************************************************************************/
 
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
 #include <realm/array_string_long.hpp>
 #include <realm/array_blob.hpp>
 #include <realm/impl/destroy_guard.hpp>
@@ -24,6 +30,190 @@
 using namespace realm;
 
 
+namespace {
+
+// The symbol table of a compressed leaf is stored in a blob as follows:
+//
+//   byte 0                    Number of symbols, N (at most 255)
+//   bytes 1 to N              Length of each symbol (1 to 8)
+//   bytes N+1 to 9*N          The symbols, each in an 8 byte slot
+//
+// Symbols are sorted by their first byte, and then by decreasing length, so
+// that the longest symbol matching at a given position is the first match
+// found among those starting with the same byte. Code 255 is an escape,
+// and is followed by the literal byte. Since the greedy encoding is a
+// function of the input, equal strings always have equal codes.
+class SymbolTable {
+public:
+    static const size_t max_symbols = 255;
+    static const size_t max_symbol_size = 8;
+    static const unsigned char escape = 255;
+
+    explicit SymbolTable(const char* data) noexcept
+        : m_num_symbols(static_cast<unsigned char>(data[0]))
+        , m_lengths(reinterpret_cast<const unsigned char*>(data + 1))
+        , m_symbols(data + 1 + m_num_symbols)
+    {
+    }
+
+    static size_t byte_size(size_t num_symbols) noexcept
+    {
+        return 1 + num_symbols * (1 + max_symbol_size);
+    }
+
+    /// Returns the number of code bytes written to \a out, which must have
+    /// room for 2 * \a size bytes.
+    size_t encode(const char* data, size_t size, char* out) const noexcept
+    {
+        const char* end = data + size;
+        char* out_begin = out;
+        while (data != end) {
+            size_t len;
+            size_t code = find_longest(data, size_t(end - data), len);
+            if (code == escape) {
+                *out++ = char(escape);
+                *out++ = *data;
+            }
+            else {
+                *out++ = char(code);
+            }
+            data += len;
+        }
+        return size_t(out - out_begin);
+    }
+
+    void decode(const char* codes, size_t size, std::vector<char>& out) const
+    {
+        const char* end = codes + size;
+        while (codes != end) {
+            unsigned char code = static_cast<unsigned char>(*codes++);
+            if (code == escape) {
+                out.push_back(*codes++); // Throws
+                continue;
+            }
+            const char* symbol = m_symbols + code * max_symbol_size;
+            out.insert(out.end(), symbol, symbol + m_lengths[code]); // Throws
+        }
+    }
+
+    /// Returns the code of the longest symbol that is a prefix of the
+    /// specified data, or `escape` if there is none. The number of input
+    /// bytes consumed is returned in \a len.
+    size_t find_longest(const char* data, size_t size, size_t& len) const noexcept
+    {
+        unsigned char first = static_cast<unsigned char>(*data);
+        // Binary search for the first symbol starting with `first`
+        size_t lo = 0, hi = m_num_symbols;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (static_cast<unsigned char>(m_symbols[mid * max_symbol_size]) < first) {
+                lo = mid + 1;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        for (size_t i = lo; i < m_num_symbols; ++i) {
+            const char* symbol = m_symbols + i * max_symbol_size;
+            if (static_cast<unsigned char>(symbol[0]) != first)
+                break;
+            size_t symbol_size = m_lengths[i];
+            if (symbol_size <= size && std::memcmp(symbol, data, symbol_size) == 0) {
+                len = symbol_size;
+                return i;
+            }
+        }
+        len = 1;
+        return escape;
+    }
+
+    size_t symbol_size(size_t code) const noexcept
+    {
+        return m_lengths[code];
+    }
+
+private:
+    const size_t m_num_symbols;
+    const unsigned char* const m_lengths;
+    const char* const m_symbols;
+};
+
+
+std::vector<char> serialize_symbol_table(std::vector<std::string>& symbols)
+{
+    std::sort(symbols.begin(), symbols.end(), [](const std::string& a, const std::string& b) {
+        if (a[0] != b[0])
+            return static_cast<unsigned char>(a[0]) < static_cast<unsigned char>(b[0]);
+        if (a.size() != b.size())
+            return a.size() > b.size();
+        return a < b;
+    });
+    size_t n = symbols.size();
+    std::vector<char> data(SymbolTable::byte_size(n), 0); // Throws
+    data[0] = char(n);
+    for (size_t i = 0; i != n; ++i) {
+        data[1 + i] = char(symbols[i].size());
+        std::copy(symbols[i].begin(), symbols[i].end(), data.begin() + 1 + n + i * SymbolTable::max_symbol_size);
+    }
+    return data;
+}
+
+
+// Construct a symbol table for the specified strings using the iterative
+// scheme of FSST: encode the sample with the current table, count how often
+// each symbol, each single byte and each pair of adjacent symbols occurs, and
+// keep the 255 candidates with the highest gain (count times length) for the
+// next round.
+std::vector<char> build_symbol_table(const std::vector<StringData>& sample)
+{
+    const int num_generations = 4;
+    std::vector<std::string> symbols;
+    std::vector<char> table = serialize_symbol_table(symbols); // Throws
+    for (int generation = 0; generation != num_generations; ++generation) {
+        SymbolTable current(table.data());
+        std::unordered_map<std::string, size_t> counts;
+        for (StringData str : sample) {
+            const char* data = str.data();
+            const char* end = data + str.size();
+            const char* prev = nullptr;
+            size_t prev_len = 0;
+            while (data != end) {
+                size_t len;
+                current.find_longest(data, size_t(end - data), len);
+                ++counts[std::string(data, len)]; // Throws
+                if (len > 1)
+                    ++counts[std::string(data, 1)]; // Throws
+                if (prev && prev_len + len <= SymbolTable::max_symbol_size)
+                    ++counts[std::string(prev, prev_len + len)]; // Throws
+                prev = data;
+                prev_len = len;
+                data += len;
+            }
+        }
+
+        std::vector<std::pair<size_t, std::string>> candidates;
+        candidates.reserve(counts.size()); // Throws
+        for (auto& entry : counts) {
+            // A single byte symbol saves a byte per occurrence over the escape
+            size_t gain = entry.second * entry.first.size();
+            candidates.emplace_back(gain, entry.first); // Throws
+        }
+        size_t num_symbols = std::min(candidates.size(), SymbolTable::max_symbols);
+        auto better = [](const std::pair<size_t, std::string>& a, const std::pair<size_t, std::string>& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        };
+        std::partial_sort(candidates.begin(), candidates.begin() + num_symbols, candidates.end(), better);
+        symbols.clear();
+        for (size_t i = 0; i != num_symbols; ++i)
+            symbols.push_back(std::move(candidates[i].second)); // Throws
+        table = serialize_symbol_table(symbols); // Throws
+    }
+    return table;
+}
+
+} // anonymous namespace
+
+
 void ArrayStringLong::init_from_mem(MemRef mem) noexcept
 {
     Array::init_from_mem(mem);
@@ -37,11 +227,144 @@ void ArrayStringLong::init_from_mem(MemRef mem) noexcept
         ref_type nulls_ref = get_as_ref(2);
         m_nulls.init_from_ref(nulls_ref);
     }
+
+    m_compressed = m_offsets.get_context_flag();
+    if (m_compressed) {
+        ref_type symbols_ref = get_as_ref(Array::size() - 1);
+        m_symbols.init_from_ref(symbols_ref);
+    }
+    std::vector<char>().swap(m_decoded);
+    std::vector<size_t>().swap(m_decoded_ends);
+}
+
+
+bool ArrayStringLong::compress()
+{
+    REALM_ASSERT(!m_compressed);
+
+    size_t n = size();
+    if (n == 0)
+        return false;
+
+    // Like FSST, build the symbol table from a sample of about 8KB
+    const size_t sample_size = 8192;
+    size_t stride = 1 + m_blob.size() / sample_size;
+    std::vector<StringData> sample;
+    for (size_t i = 0; i < n; i += stride)
+        sample.push_back(get(i)); // Throws
+    std::vector<char> table = build_symbol_table(sample); // Throws
+
+    SymbolTable symbols(table.data());
+    std::vector<char> codes;
+    std::vector<size_t> ends;
+    ends.reserve(n); // Throws
+    for (size_t i = 0; i != n; ++i) {
+        StringData value = get(i);
+        size_t pos = codes.size();
+        codes.resize(pos + 2 * value.size()); // Throws
+        codes.resize(pos + symbols.encode(value.data(), value.size(), codes.data() + pos));
+        ends.push_back(codes.size()); // Throws
+    }
+    if (codes.size() + table.size() >= m_blob.size())
+        return false;
+
+    Allocator& alloc = get_alloc();
+    ArrayInteger offsets(alloc);
+    ArrayBlob code_blob(alloc);
+    ArrayBlob symbol_blob(alloc);
+    _impl::ShallowArrayDestroyGuard offsets_dg(&offsets);
+    _impl::ShallowArrayDestroyGuard code_blob_dg(&code_blob);
+    _impl::ShallowArrayDestroyGuard symbol_blob_dg(&symbol_blob);
+    bool context_flag = true; // Marks the compressed form
+    offsets.create(type_Normal, context_flag); // Throws
+    for (size_t end : ends)
+        offsets.add(int64_t(end)); // Throws
+    code_blob.create();                          // Throws
+    code_blob.add(codes.data(), codes.size());   // Throws
+    symbol_blob.create();                        // Throws
+    symbol_blob.add(table.data(), table.size()); // Throws
+
+    Array::add(from_ref(symbol_blob.get_ref())); // Throws
+    symbol_blob_dg.release();
+    Array::set_as_ref(0, offsets.get_ref()); // Throws
+    offsets_dg.release();
+    Array::set_as_ref(1, code_blob.get_ref()); // Throws
+    code_blob_dg.release();
+    m_offsets.destroy();
+    m_blob.destroy();
+    init_from_mem(get_mem());
+    return true;
+}
+
+
+void ArrayStringLong::expand()
+{
+    REALM_ASSERT(m_compressed);
+
+    if (m_decoded_ends.size() != m_offsets.size())
+        decode_all(); // Throws
+
+    Allocator& alloc = get_alloc();
+    ArrayInteger offsets(alloc);
+    ArrayBlob blob(alloc);
+    _impl::ShallowArrayDestroyGuard offsets_dg(&offsets);
+    _impl::ShallowArrayDestroyGuard blob_dg(&blob);
+    offsets.create(type_Normal); // Throws
+    for (size_t end : m_decoded_ends)
+        offsets.add(int64_t(end)); // Throws
+    blob.create();                                // Throws
+    blob.add(m_decoded.data(), m_decoded.size()); // Throws
+
+    Array::set_as_ref(0, offsets.get_ref()); // Throws
+    offsets_dg.release();
+    Array::set_as_ref(1, blob.get_ref()); // Throws
+    blob_dg.release();
+    Array::truncate(Array::size() - 1);         // Throws
+    m_offsets.destroy();
+    m_blob.destroy();
+    m_symbols.destroy();
+    init_from_mem(get_mem());
+}
+
+
+void ArrayStringLong::decode_all() const
+{
+    m_decoded.clear();
+    m_decoded_ends.clear();
+
+    SymbolTable symbols(m_symbols.get(0));
+    size_t n = m_offsets.size();
+    m_decoded_ends.reserve(n);                // Throws
+    m_decoded.reserve(3 * m_blob.size() + n); // Throws
+    size_t begin = 0;
+    for (size_t i = 0; i != n; ++i) {
+        size_t end = to_size_t(m_offsets.get(i));
+        symbols.decode(m_blob.get(begin), end - begin, m_decoded); // Throws
+        m_decoded.push_back(0);                                    // Throws
+        m_decoded_ends.push_back(m_decoded.size());
+        begin = end;
+    }
+}
+
+
+StringData ArrayStringLong::get_compressed(size_t ndx) const noexcept
+{
+    // Decoding allocates memory. Running out of it here terminates the
+    // program, as this function cannot report it.
+    if (m_decoded_ends.size() != m_offsets.size())
+        decode_all();
+
+    size_t begin = 0 < ndx ? m_decoded_ends[ndx - 1] : 0;
+    size_t end = m_decoded_ends[ndx] - 1; // Discount the terminating zero
+    return StringData(m_decoded.data() + begin, end - begin);
 }
 
 
 void ArrayStringLong::add(StringData value)
 {
+    if (m_compressed)
+        expand(); // Throws
+
     bool add_zero_term = true;
     m_blob.add(value.data(), value.size(), add_zero_term);
     size_t end = value.size() + 1;
@@ -56,6 +379,9 @@ void ArrayStringLong::set(size_t ndx, StringData value)
 {
     REALM_ASSERT_3(ndx, <, m_offsets.size());
 
+    if (m_compressed)
+        expand(); // Throws
+
     size_t begin = 0 < ndx ? to_size_t(m_offsets.get(ndx - 1)) : 0;
     size_t end = to_size_t(m_offsets.get(ndx));
     bool add_zero_term = true;
@@ -72,6 +398,9 @@ void ArrayStringLong::insert(size_t ndx, StringData value)
 {
     REALM_ASSERT_3(ndx, <=, m_offsets.size());
 
+    if (m_compressed)
+        expand(); // Throws
+
     size_t pos = 0 < ndx ? to_size_t(m_offsets.get(ndx - 1)) : 0;
     bool add_zero_term = true;
 
@@ -86,6 +415,9 @@ void ArrayStringLong::erase(size_t ndx)
 {
     REALM_ASSERT_3(ndx, <, m_offsets.size());
 
+    if (m_compressed)
+        expand(); // Throws
+
     size_t begin = 0 < ndx ? to_size_t(m_offsets.get(ndx - 1)) : 0;
     size_t end = to_size_t(m_offsets.get(ndx));
 
@@ -111,6 +443,8 @@ void ArrayStringLong::set_null(size_t ndx)
 {
     if (m_nullable) {
         REALM_ASSERT_3(ndx, <, m_nulls.size());
+        if (m_compressed)
+            expand(); // Throws
         m_nulls.set(ndx, false);
     }
 }
@@ -139,6 +473,23 @@ size_t ArrayStringLong::find_first(StringData value, size_t begin, size_t end) c
     REALM_ASSERT_7(begin, <=, n, &&, end, <=, n);
     REALM_ASSERT_3(begin, <=, end);
 
+    char buffer[128];
+    if (m_compressed && !value.is_null() && 2 * value.size() <= sizeof buffer) {
+        // Equal strings have equal codes, so the search value is encoded
+        // once and compared against the codes of each string.
+        size_t size = SymbolTable(m_symbols.get(0)).encode(value.data(), value.size(), buffer);
+        size_t code_begin = 0 < begin ? to_size_t(m_offsets.get(begin - 1)) : 0;
+        for (size_t i = begin; i < end; ++i) {
+            size_t code_end = to_size_t(m_offsets.get(i));
+            if (code_end - code_begin == size && std::memcmp(m_blob.get(code_begin), buffer, size) == 0) {
+                if (!m_nullable || m_nulls.get(i) != 0)
+                    return i;
+            }
+            code_begin = code_end;
+        }
+        return not_found;
+    }
+
     for (size_t i = begin; i < end; ++i) {
         StringData value_2 = get(i);
         if (value_2 == value)
@@ -164,6 +515,8 @@ void ArrayStringLong::find_all(IntegerColumn& result, StringData value, size_t a
 
 StringData ArrayStringLong::get(const char* header, size_t ndx, Allocator& alloc, bool nullable) noexcept
 {
+    REALM_ASSERT_DEBUG(!is_compressed(header, alloc));
+
     ref_type offsets_ref;
     ref_type blob_ref;
     ref_type nulls_ref;
@@ -218,6 +571,10 @@ ref_type ArrayStringLong::bptree_leaf_insert(size_t ndx, StringData value, TreeI
     if (ndx == leaf_size) {
         new_leaf.add(value); // Throws
         state.m_split_offset = ndx;
+        // As for integer leaves, a leaf left behind by appends is likely to
+        // stay unmodified, so it is worth compressing.
+        if (get_alloc().allows_compact_leaves())
+            compress(); // Throws
     }
     else {
         for (size_t i = ndx; i != leaf_size; ++i)
@@ -303,6 +660,8 @@ void ArrayStringLong::to_dot(std::ostream& out, StringData title) const
     Array::to_dot(out, "stringlong_top");
     m_offsets.to_dot(out, "offsets");
     m_blob.to_dot(out, "blob");
+    if (m_compressed)
+        m_symbols.to_dot(out, "symbols");
 
     out << "}" << std::endl;
 }
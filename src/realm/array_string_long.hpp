@@ -19,6 +19,8 @@
 #ifndef REALM_ARRAY_STRING_LONG_HPP
 #define REALM_ARRAY_STRING_LONG_HPP
 
+#include <vector>
+
 #include <realm/array_blob.hpp>
 #include <realm/array_integer.hpp>
 
@@ -70,6 +72,21 @@ public:
     bool is_null(size_t ndx) const;
     void set_null(size_t ndx);
 
+    /// Replace the strings of this leaf by codes referring to a symbol table
+    /// of up to 255 frequent substrings of 1 to 8 bytes (as in FSST), stored
+    /// in an extra slot at the end of the top array. The conversion is only
+    /// carried out if it makes the leaf smaller, and in that case true is
+    /// returned.
+    ///
+    /// A compressed leaf decodes its strings into this accessor on first
+    /// access, so the StringData returned by get() stays valid until the
+    /// accessor is modified or reattached. Any modification expands the leaf
+    /// back to the plain form first.
+    bool compress();
+
+    bool is_compressed() const noexcept;
+    static bool is_compressed(const char* header, Allocator&) noexcept;
+
     size_t count(StringData value, size_t begin = 0, size_t end = npos) const noexcept;
     size_t find_first(StringData value, size_t begin = 0, size_t end = npos) const noexcept;
     void find_all(IntegerColumn& result, StringData value, size_t add_offset = 0, size_t begin = 0,
@@ -78,7 +95,7 @@ public:
     /// Get the specified element without the cost of constructing an
     /// array instance. If an array instance is already available, or
     /// you need to get multiple values, then this method will be
-    /// slower.
+    /// slower. Must not be used on a compressed leaf.
     static StringData get(const char* header, size_t ndx, Allocator&, bool nullable) noexcept;
 
     ref_type bptree_leaf_insert(size_t ndx, StringData, TreeInsertBase&);
@@ -101,10 +118,24 @@ public:
     bool update_from_parent(size_t old_baseline) noexcept;
 
 private:
+    // In the compressed form, the offsets array has its context flag set and
+    // holds the end of each string in the code blob (without terminating
+    // zeroes), and the last slot of the top array refers to the symbol table.
     ArrayInteger m_offsets;
     ArrayBlob m_blob;
     Array m_nulls;
+    ArrayBlob m_symbols;
     bool m_nullable;
+    bool m_compressed = false;
+
+    // Decoded strings of a compressed leaf, each followed by a zero, and the
+    // end of each of them in m_decoded.
+    mutable std::vector<char> m_decoded;
+    mutable std::vector<size_t> m_decoded_ends;
+
+    StringData get_compressed(size_t ndx) const noexcept;
+    void decode_all() const;
+    void expand();
 };
 
 
@@ -114,6 +145,7 @@ inline ArrayStringLong::ArrayStringLong(Allocator& allocator, bool nullable) noe
     , m_offsets(allocator)
     , m_blob(allocator)
     , m_nulls(nullable ? allocator : Allocator::get_default())
+    , m_symbols(allocator)
     , m_nullable(nullable)
 {
     m_offsets.set_parent(this, 0);
@@ -134,7 +166,7 @@ inline void ArrayStringLong::init_from_ref(ref_type ref) noexcept
     REALM_ASSERT(ref);
     char* header = get_alloc().translate(ref);
     init_from_mem(MemRef(header, ref, m_alloc));
-    m_nullable = (Array::size() == 3);
+    m_nullable = (Array::size() == (m_compressed ? 4 : 3));
 }
 
 inline void ArrayStringLong::init_from_parent() noexcept
@@ -160,6 +192,9 @@ inline StringData ArrayStringLong::get(size_t ndx) const noexcept
     if (m_nullable && m_nulls.get(ndx) == 0)
         return realm::null();
 
+    if (REALM_UNLIKELY(m_compressed))
+        return get_compressed(ndx);
+
     size_t begin, end;
     if (0 < ndx) {
         begin = to_size_t(m_offsets.get(ndx - 1));
@@ -174,10 +209,25 @@ inline StringData ArrayStringLong::get(size_t ndx) const noexcept
     return StringData(m_blob.get(begin), end - begin);
 }
 
+inline bool ArrayStringLong::is_compressed() const noexcept
+{
+    return m_compressed;
+}
+
+inline bool ArrayStringLong::is_compressed(const char* header, Allocator& alloc) noexcept
+{
+    ref_type offsets_ref = to_ref(Array::get(header, 0));
+    const char* offsets_header = alloc.translate(offsets_ref);
+    return Array::get_context_flag_from_header(offsets_header);
+}
+
 inline void ArrayStringLong::truncate(size_t new_size)
 {
     REALM_ASSERT_3(new_size, <, m_offsets.size());
 
+    if (m_compressed)
+        expand(); // Throws
+
     size_t blob_size = new_size ? to_size_t(m_offsets.get(new_size - 1)) : 0;
 
     m_offsets.truncate(new_size);
@@ -188,6 +238,8 @@ inline void ArrayStringLong::truncate(size_t new_size)
 
 inline void ArrayStringLong::clear()
 {
+    if (m_compressed)
+        expand(); // Throws
     m_blob.clear();
     m_offsets.clear();
     if (m_nullable)
@@ -200,6 +252,8 @@ inline void ArrayStringLong::destroy()
     m_offsets.destroy();
     if (m_nullable)
         m_nulls.destroy();
+    if (m_compressed)
+        m_symbols.destroy();
     Array::destroy();
 }
 
@@ -207,10 +261,9 @@ inline bool ArrayStringLong::update_from_parent(size_t old_baseline) noexcept
 {
     bool res = Array::update_from_parent(old_baseline);
     if (res) {
-        m_blob.update_from_parent(old_baseline);
-        m_offsets.update_from_parent(old_baseline);
-        if (m_nullable)
-            m_nulls.update_from_parent(old_baseline);
+        // The leaf may have been compressed or expanded, which changes the
+        // layout of the top array, so all subarrays are reattached.
+        init_from_mem(get_mem());
     }
     return res;
 }
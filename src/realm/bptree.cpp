@@ -19,6 +19,7 @@
 #include <realm/array_direct.hpp>
 #include <realm/bptree.hpp>
 #include <realm/array_integer.hpp>
+#include <realm/query_conditions.hpp>
 
 using namespace realm;
 
@@ -201,7 +202,7 @@ bool foreach_bptree_leaf(Array& node, size_t node_offset, size_t node_size, Hand
         }
     }
     REALM_ASSERT_3(node.size(), >=, 2);
-    size_t num_children = node.size() - 2;
+    size_t num_children = BpTreeNode::get_num_bptree_children_from_header(node.get_mem().get_addr());
     REALM_ASSERT_3(num_children, >=, 1); // invar:bptree-nonempty-inner
     BpTreeNode::NodeInfo child_info;
     child_info.m_parent = &node;
@@ -261,7 +262,7 @@ void simplified_foreach_bptree_leaf(Array& node, Handler handler) noexcept(noexc
     Allocator& alloc = node.get_alloc();
     size_t child_ndx = 0;
     REALM_ASSERT_3(node.size(), >=, 2);
-    size_t num_children = node.size() - 2;
+    size_t num_children = BpTreeNode::get_num_bptree_children_from_header(node.get_mem().get_addr());
     REALM_ASSERT_3(num_children, >=, 1); // invar:bptree-nonempty-inner
     BpTreeNode::NodeInfo child_info;
     child_info.m_parent = &node;
@@ -293,6 +294,12 @@ void simplified_foreach_bptree_leaf(Array& node, Handler handler) noexcept(noexc
 
 inline void destroy_inner_bptree_node(MemRef mem, int_fast64_t first_value, Allocator& alloc) noexcept
 {
+    const char* header = mem.get_addr();
+    if (BpTreeNode::has_bptree_summary_from_header(header)) {
+        size_t summary_ref_ndx = Array::get_size_from_header(header) - 2;
+        ref_type summary_ref = to_ref(Array::get(header, summary_ref_ndx));
+        alloc.free_(summary_ref, alloc.translate(summary_ref));
+    }
     alloc.free_(mem);
     if (first_value % 2 == 0) {
         // Node has offsets array
@@ -345,9 +352,8 @@ void elim_superfluous_bptree_root(Array* root, MemRef parent_mem, int_fast64_t p
         // Note also that 'root' may be destroy at this point.
     }
     else {
-        size_t child_size = Array::get_size_from_header(child_header);
-        REALM_ASSERT_3(child_size, >=, 2);
-        size_t num_grandchildren = child_size - 2;
+        REALM_ASSERT_3(Array::get_size_from_header(child_header), >=, 2);
+        size_t num_grandchildren = BpTreeNode::get_num_bptree_children_from_header(child_header);
         REALM_ASSERT_3(num_grandchildren, >=, 1); // invar:bptree-nonempty-inner
         if (num_grandchildren > 1) {
             // This child is an inner node, and is the closest one to
@@ -375,12 +381,93 @@ void elim_superfluous_bptree_root(Array* root, MemRef parent_mem, int_fast64_t p
     // nodes comprising eliminated B+-tree nodes must be freed. Our
     // job is to free those comprising that parent. It is crucial that
     // this part does not throw.
-    alloc.free_(parent_mem);
-    if (parent_first_value % 2 == 0) {
-        // Parent has offsets array
-        ref_type offsets_ref = to_ref(parent_first_value);
-        alloc.free_(offsets_ref, alloc.translate(offsets_ref));
+    destroy_inner_bptree_node(parent_mem, parent_first_value, alloc);
+}
+
+
+// Get the smallest and the largest value in the specified subtree of
+// an integer B+-tree. For an inner node, they are taken from its
+// summary, so it must have one.
+std::pair<int64_t, int64_t> get_bptree_subtree_bounds(MemRef mem, Allocator& alloc)
+{
+    const char* header = mem.get_addr();
+    if (Array::get_is_inner_bptree_node_from_header(header)) {
+        REALM_ASSERT(BpTreeNode::has_bptree_summary_from_header(header));
+        size_t summary_ref_ndx = Array::get_size_from_header(header) - 2;
+        const char* summary_header = alloc.translate(to_ref(Array::get(header, summary_ref_ndx)));
+        size_t summary_size = Array::get_size_from_header(summary_header);
+        REALM_ASSERT_3(summary_size, >=, 2);
+        int64_t min = Array::get(summary_header, 0);
+        int64_t max = Array::get(summary_header, 1);
+        for (size_t i = 2; i != summary_size; i += 2) {
+            min = std::min(min, Array::get(summary_header, i));
+            max = std::max(max, Array::get(summary_header, i + 1));
+        }
+        return std::make_pair(min, max);
     }
+    // Warning: Initializing leaf as Array.
+    Array leaf(alloc);
+    leaf.init_from_mem(mem);
+    int64_t min = 0, max = 0;
+    leaf.minimum(min);
+    leaf.maximum(max);
+    return std::make_pair(min, max);
+}
+
+
+// Returns the index of the first element in `[begin, end)` whose
+// subtree is not ruled out by the summaries, or `npos` if there is
+// none. `begin` must refer to an element in the specified subtree.
+template <class Cond>
+size_t find_bptree_candidate(const char* node_header, size_t node_offset, int64_t value, size_t begin, size_t end,
+                             Allocator& alloc) noexcept
+{
+    if (!BpTreeNode::has_bptree_summary_from_header(node_header))
+        return begin;
+    size_t node_size = Array::get_size_from_header(node_header);
+    size_t num_children = node_size - 3;
+    size_t node_end = node_offset + to_size_t(Array::get(node_header, node_size - 1) / 2);
+    const char* summary_header = alloc.translate(to_ref(Array::get(node_header, node_size - 2)));
+    int_fast64_t first_value = Array::get(node_header, 0);
+    const char* offsets_header = nullptr;
+    size_t elems_per_child = 0;
+    if (first_value % 2 != 0) {
+        elems_per_child = to_size_t(first_value / 2);
+    }
+    else {
+        offsets_header = alloc.translate(to_ref(first_value));
+    }
+
+    std::pair<size_t, size_t> p = find_bptree_child(first_value, begin - node_offset, alloc);
+    size_t child_ndx = p.first;
+    size_t child_offset = begin - p.second;
+    Cond cond;
+    while (child_ndx != num_children && child_offset < end) {
+        size_t child_end = node_end;
+        if (child_ndx != num_children - 1) {
+            if (offsets_header) {
+                child_end = node_offset + to_size_t(Array::get(offsets_header, child_ndx));
+            }
+            else {
+                child_end = child_offset + elems_per_child;
+            }
+        }
+        int64_t min = Array::get(summary_header, 2 * child_ndx);
+        int64_t max = Array::get(summary_header, 2 * child_ndx + 1);
+        if (cond.can_match(value, min, max)) {
+            size_t child_begin = std::max(begin, child_offset);
+            ref_type child_ref = to_ref(Array::get(node_header, 1 + child_ndx));
+            const char* child_header = alloc.translate(child_ref);
+            if (!Array::get_is_inner_bptree_node_from_header(child_header))
+                return child_begin;
+            size_t ndx = find_bptree_candidate<Cond>(child_header, child_offset, value, child_begin, end, alloc);
+            if (ndx != npos)
+                return ndx;
+        }
+        child_offset = child_end;
+        ++child_ndx;
+    }
+    return npos;
 }
 
 } // anonymous namespace
@@ -418,18 +505,42 @@ ref_type BpTreeNode::insert_bptree_child(Array& offsets, size_t orig_child_ndx,
     // after the original
     size_t orig_child_ref_ndx = 1 + orig_child_ndx;
     size_t insert_ndx = orig_child_ref_ndx + 1;
+    size_t num_children = get_num_bptree_children();
+
+    // The bounds of both halves of the split child are computed from
+    // their contents. When appending, the original child will most
+    // likely not be modified again, so this is where the bounds that
+    // have been widened by default values during insertion are made
+    // tight.
+    bool has_summary = has_bptree_summary();
+    Array summary(m_alloc);
+    std::pair<int64_t, int64_t> new_sibling_bounds;
+    if (has_summary) {
+        summary.set_parent(this, size() - 2);
+        summary.init_from_parent();
+        MemRef orig_child_mem(get_as_ref(orig_child_ref_ndx), m_alloc);
+        std::pair<int64_t, int64_t> orig_child_bounds = get_bptree_subtree_bounds(orig_child_mem, m_alloc);
+        summary.set(2 * orig_child_ndx, orig_child_bounds.first);      // Throws
+        summary.set(2 * orig_child_ndx + 1, orig_child_bounds.second); // Throws
+        new_sibling_bounds = get_bptree_subtree_bounds(MemRef(new_sibling_ref, m_alloc), m_alloc);
+    }
 
-    REALM_ASSERT_DEBUG(insert_ndx <= size() - 1);
-    if (REALM_LIKELY(size() < 1 + REALM_MAX_BPNODE_SIZE + 1)) {
+    REALM_ASSERT_DEBUG(insert_ndx <= 1 + num_children);
+    if (REALM_LIKELY(num_children < REALM_MAX_BPNODE_SIZE)) {
         // Case 1/2: This parent has space for the new child, so it
         // does not have to be split.
         insert(insert_ndx, new_sibling_ref); // Throws
-        // +2 because stored value is 1 + 2*total_elems_in_subtree
-        adjust(size() - 1, +2); // Throws
+        // 2 per element because stored value is 1 + 2*total_elems_in_subtree
+        adjust(size() - 1, 2 * int64_t(state.m_num_inserted)); // Throws
+        if (has_summary) {
+            summary.set_ndx_in_parent(size() - 2);
+            summary.insert(2 * (orig_child_ndx + 1), new_sibling_bounds.first);      // Throws
+            summary.insert(2 * (orig_child_ndx + 1) + 1, new_sibling_bounds.second); // Throws
+        }
         if (offsets.is_attached()) {
             size_t elem_ndx_offset = orig_child_ndx > 0 ? to_size_t(offsets.get(orig_child_ndx - 1)) : 0;
             offsets.insert(orig_child_ndx, elem_ndx_offset + state.m_split_offset); // Throws
-            offsets.adjust(orig_child_ndx + 1, offsets.size(), +1);                 // Throws
+            offsets.adjust(orig_child_ndx + 1, offsets.size(), int64_t(state.m_num_inserted)); // Throws
         }
         return 0; // Parent node was not split
     }
@@ -451,8 +562,10 @@ ref_type BpTreeNode::insert_bptree_child(Array& offsets, size_t orig_child_ndx,
     }
 
     Allocator& allocator = get_alloc();
-    Array new_sibling(allocator), new_offsets(allocator);
-    new_sibling.create(type_InnerBptreeNode); // Throws
+    Array new_sibling(allocator), new_offsets(allocator), new_summary(allocator);
+    new_sibling.create(type_InnerBptreeNode, has_summary); // Throws
+    if (has_summary)
+        new_summary.create(type_Normal); // Throws
     if (offsets.is_attached()) {
         new_offsets.set_parent(&new_sibling, 0);
         new_offsets.create(type_Normal);                  // Throws
@@ -471,6 +584,10 @@ ref_type BpTreeNode::insert_bptree_child(Array& offsets, size_t orig_child_ndx,
         new_split_offset = elem_ndx_offset + state.m_split_offset;
         new_split_size = elem_ndx_offset + state.m_split_size;
         new_sibling.add(new_sibling_ref); // Throws
+        if (has_summary) {
+            new_summary.add(new_sibling_bounds.first);  // Throws
+            new_summary.add(new_sibling_bounds.second); // Throws
+        }
     }
     else {
         // Case 2/2: The split child was not the last child of the
@@ -479,9 +596,7 @@ ref_type BpTreeNode::insert_bptree_child(Array& offsets, size_t orig_child_ndx,
         // the general form.
         REALM_ASSERT(new_offsets.is_attached());
         new_split_offset = elem_ndx_offset + state.m_split_size;
-        new_split_size = to_size_t(back() / 2) + 1;
-        REALM_ASSERT_3(size(), >=, 2);
-        size_t num_children = size() - 2;
+        new_split_size = to_size_t(back() / 2) + state.m_num_inserted;
         REALM_ASSERT_3(num_children, >=, 1); // invar:bptree-nonempty-inner
         // Move some refs over
         size_t child_refs_end = 1 + num_children;
@@ -493,14 +608,28 @@ ref_type BpTreeNode::insert_bptree_child(Array& offsets, size_t orig_child_ndx,
             size_t offset = to_size_t(offsets.get(i));
             new_offsets.add(offset - (new_split_offset - 1)); // Throws
         }
+        // Move some bounds over
+        size_t summary_begin = 2 * (orig_child_ndx + 1);
+        if (has_summary) {
+            for (size_t i = summary_begin; i != 2 * num_children; ++i)
+                new_summary.add(summary.get(i)); // Throws
+        }
         // Update original parent
         erase(insert_ndx + 1, child_refs_end);
         set(insert_ndx, from_ref(new_sibling_ref)); // Throws
         offsets.erase(orig_child_ndx + 1, offsets_end);
         offsets.set(orig_child_ndx, elem_ndx_offset + state.m_split_offset); // Throws
+        if (has_summary) {
+            summary.set_ndx_in_parent(size() - 2);
+            summary.truncate(summary_begin);            // Throws
+            summary.add(new_sibling_bounds.first);  // Throws
+            summary.add(new_sibling_bounds.second); // Throws
+        }
     }
     int_fast64_t v = new_split_offset;     // total_elems_in_subtree
     set(size() - 1, 1 + 2 * v);            // Throws
+    if (has_summary)
+        new_sibling.add(from_ref(new_summary.get_ref())); // Throws
     v = new_split_size - new_split_offset; // total_elems_in_subtree
     new_sibling.add(1 + 2 * v);            // Throws
     state.m_split_offset = new_split_offset;
@@ -513,7 +642,7 @@ void BpTreeNode::create_bptree_offsets(Array& offsets, int_fast64_t first_value)
     offsets.create(type_Normal); // Throws
     int_fast64_t elems_per_child = first_value / 2;
     int_fast64_t accum_num_elems = 0;
-    size_t num_children = size() - 2;
+    size_t num_children = get_num_bptree_children();
     for (size_t i = 0; i != num_children - 1; ++i) {
         accum_num_elems += elems_per_child;
         offsets.add(accum_num_elems); // Throws
@@ -528,7 +657,7 @@ bool BpTreeNode::do_erase_bptree_elem(size_t elem_ndx, EraseHandler& handler)
     size_t child_ndx;
     size_t ndx_in_child;
     if (elem_ndx == npos) {
-        size_t num_children = size() - 2;
+        size_t num_children = get_num_bptree_children();
         child_ndx = num_children - 1;
         ndx_in_child = npos;
     }
@@ -565,7 +694,7 @@ bool BpTreeNode::do_erase_bptree_elem(size_t elem_ndx, EraseHandler& handler)
         child.set_parent(this, child_ref_ndx);
         destroy_child = child.do_erase_bptree_elem(ndx_in_child, handler); // Throws
     }
-    size_t num_children = size() - 2;
+    size_t num_children = get_num_bptree_children();
     if (destroy_child) {
         if (num_children == 1)
             return true; // Destroy this node too
@@ -576,6 +705,14 @@ bool BpTreeNode::do_erase_bptree_elem(size_t elem_ndx, EraseHandler& handler)
         child_mem = MemRef(child_header, child_ref, m_alloc);
         erase(child_ref_ndx); // Throws
         destroy_singlet_bptree_branch(child_mem, m_alloc, handler);
+        // The bounds of the remaining children are left as they
+        // are. They cannot be narrowed without scanning the children.
+        if (has_bptree_summary()) {
+            Array summary(m_alloc);
+            summary.set_parent(this, size() - 2);
+            summary.init_from_parent();
+            summary.erase(2 * child_ndx, 2 * child_ndx + 2); // Throws
+        }
         // If the erased element is the last one, we did not attach
         // the offsets array above, even if one was preset. Since we
         // are removing a child, we have to do that now.
@@ -623,7 +760,8 @@ void BpTreeBase::replace_root(std::unique_ptr<Array> leaf)
     m_root = std::move(leaf);
 }
 
-void BpTreeBase::introduce_new_root(ref_type new_sibling_ref, TreeInsertBase& state, bool is_append)
+void BpTreeBase::introduce_new_root(ref_type new_sibling_ref, TreeInsertBase& state, bool is_append,
+                                    bool summarize)
 {
     // At this point the original root and its new sibling is either
     // both leaves, or both inner nodes on the same form, compact or
@@ -633,8 +771,12 @@ void BpTreeBase::introduce_new_root(ref_type new_sibling_ref, TreeInsertBase& st
 
     Array* orig_root = &root();
     Allocator& alloc = get_alloc();
+    // A summary can only be added if the children are leaves, or
+    // carry summaries themselves.
+    if (orig_root->is_inner_bptree_node())
+        summarize = summarize && orig_root->get_context_flag();
     std::unique_ptr<BpTreeNode> new_root(new BpTreeNode(alloc)); // Throws
-    new_root->create(Array::type_InnerBptreeNode);               // Throws
+    new_root->create(Array::type_InnerBptreeNode, summarize);    // Throws
     new_root->set_parent(orig_root->get_parent(), orig_root->get_ndx_in_parent());
     new_root->update_parent(); // Throws
     bool compact_form = is_append && (!orig_root->is_inner_bptree_node() || orig_root->get(0) % 2 != 0);
@@ -653,6 +795,18 @@ void BpTreeBase::introduce_new_root(ref_type new_sibling_ref, TreeInsertBase& st
     }
     new_root->add(orig_root->get_ref()); // Throws
     new_root->add(new_sibling_ref);      // Throws
+    if (summarize) {
+        std::pair<int64_t, int64_t> orig_root_bounds = get_bptree_subtree_bounds(orig_root->get_mem(), alloc);
+        std::pair<int64_t, int64_t> new_sibling_bounds =
+            get_bptree_subtree_bounds(MemRef(new_sibling_ref, alloc), alloc);
+        Array summary(alloc);
+        summary.create(Array::type_Normal);         // Throws
+        summary.add(orig_root_bounds.first);        // Throws
+        summary.add(orig_root_bounds.second);       // Throws
+        summary.add(new_sibling_bounds.first);      // Throws
+        summary.add(new_sibling_bounds.second);     // Throws
+        new_root->add(from_ref(summary.get_ref())); // Throws
+    }
     int_fast64_t v = state.m_split_size; // total_elems_in_tree
     new_root->add(1 + 2 * v);            // Throws
     replace_root(std::move(new_root));
@@ -673,6 +827,8 @@ void BpTreeNode::update_bptree_leaves(UpdateHandler& handler)
 {
     UpdateAdapter adapter(handler);
     simplified_foreach_bptree_leaf(*this, adapter); // Throws
+    if (has_bptree_summary())
+        refresh_bptree_summary(); // Throws
 }
 
 void BpTreeNode::update_bptree_elem(size_t elem_ndx, UpdateHandler& handler)
@@ -689,12 +845,81 @@ void BpTreeNode::update_bptree_elem(size_t elem_ndx, UpdateHandler& handler)
     bool child_is_leaf = !get_is_inner_bptree_node_from_header(child_header);
     if (child_is_leaf) {
         handler.update(child_mem, this, child_ref_ndx, ndx_in_child); // Throws
-        return;
     }
-    BpTreeNode child(m_alloc);
-    child.init_from_mem(child_mem);
-    child.set_parent(this, child_ref_ndx);
-    child.update_bptree_elem(ndx_in_child, handler); // Throws
+    else {
+        BpTreeNode child(m_alloc);
+        child.init_from_mem(child_mem);
+        child.set_parent(this, child_ref_ndx);
+        child.update_bptree_elem(ndx_in_child, handler); // Throws
+    }
+    if (has_bptree_summary()) {
+        std::pair<MemRef, size_t> leaf = get_bptree_leaf(elem_ndx);
+        int64_t value = Array::get(leaf.first.get_addr(), leaf.second);
+        widen_bptree_summary(child_ndx, value, value); // Throws
+    }
+}
+
+
+void BpTreeNode::widen_bptree_summary(size_t child_ndx, int64_t min, int64_t max)
+{
+    Array summary(m_alloc);
+    summary.set_parent(this, size() - 2);
+    summary.init_from_parent();
+    if (min < summary.get(2 * child_ndx))
+        summary.set(2 * child_ndx, min); // Throws
+    if (max > summary.get(2 * child_ndx + 1))
+        summary.set(2 * child_ndx + 1, max); // Throws
+}
+
+
+void BpTreeNode::refresh_bptree_summary()
+{
+    REALM_ASSERT(has_bptree_summary());
+    Array summary(m_alloc);
+    summary.set_parent(this, size() - 2);
+    summary.init_from_parent();
+    size_t num_children = get_num_bptree_children();
+    for (size_t i = 0; i != num_children; ++i) {
+        size_t child_ref_ndx = 1 + i;
+        MemRef child_mem(get_as_ref(child_ref_ndx), m_alloc);
+        if (get_is_inner_bptree_node_from_header(child_mem.get_addr())) {
+            BpTreeNode child(m_alloc);
+            child.init_from_mem(child_mem);
+            child.set_parent(this, child_ref_ndx);
+            child.refresh_bptree_summary(); // Throws
+            child_mem = child.get_mem();
+        }
+        std::pair<int64_t, int64_t> bounds = get_bptree_subtree_bounds(child_mem, m_alloc);
+        summary.set(2 * i, bounds.first);      // Throws
+        summary.set(2 * i + 1, bounds.second); // Throws
+    }
+}
+
+
+size_t BpTreeNode::find_bptree_candidate(int cond, int64_t value, size_t begin, size_t end) const noexcept
+{
+    REALM_ASSERT(is_inner_bptree_node());
+    if (begin >= end)
+        return end;
+    const char* header = get_mem().get_addr();
+    size_t ndx;
+    switch (cond) {
+        case cond_Equal:
+            ndx = ::find_bptree_candidate<Equal>(header, 0, value, begin, end, m_alloc);
+            break;
+        case cond_NotEqual:
+            ndx = ::find_bptree_candidate<NotEqual>(header, 0, value, begin, end, m_alloc);
+            break;
+        case cond_Greater:
+            ndx = ::find_bptree_candidate<Greater>(header, 0, value, begin, end, m_alloc);
+            break;
+        case cond_Less:
+            ndx = ::find_bptree_candidate<Less>(header, 0, value, begin, end, m_alloc);
+            break;
+        default:
+            return begin;
+    }
+    return ndx == npos ? end : ndx;
 }
 
 
@@ -740,7 +965,7 @@ void BpTreeNode::erase_bptree_elem(BpTreeNode* root, size_t elem_ndx, EraseHandl
     // If at this point, the root has only a single child left, the
     // root has become superfluous, and can be replaced by its single
     // child. This applies recursivly.
-    size_t num_children = root->size() - 2;
+    size_t num_children = root->get_num_bptree_children();
     if (num_children > 1)
         return;
 
@@ -22,6 +22,7 @@
 #include <memory> // std::unique_ptr
 #include <realm/array.hpp>
 #include <realm/array_basic.hpp>
+#include <realm/array_integer.hpp>
 #include <realm/column_type_traits.hpp>
 #include <realm/impl/destroy_guard.hpp>
 #include <realm/impl/output_stream.hpp>
@@ -76,6 +77,34 @@ public:
     std::pair<MemRef, size_t> get_bptree_leaf(size_t elem_ndx) const noexcept;
 
 
+    /// The inner nodes of an integer B+-tree may carry a summary of
+    /// the values stored in each of their children (a zone map). Such
+    /// a node has its context flag set, and an extra slot, just before
+    /// the one holding the total number of elements, that refers to an
+    /// array of `2 * num_children` integers; the smallest and the
+    /// largest value of each child subtree. The bounds are
+    /// conservative. No child holds a value outside of its bounds, but
+    /// bounds are not narrowed when values are overwritten or
+    /// erased. Either all, or none of the inner nodes of a tree carry
+    /// a summary.
+    bool has_bptree_summary() const noexcept;
+    static bool has_bptree_summary_from_header(const char* node_header) noexcept;
+
+    /// Get the number of children of this inner B+-tree node.
+    size_t get_num_bptree_children() const noexcept;
+    static size_t get_num_bptree_children_from_header(const char* node_header) noexcept;
+
+    /// Find the first element index in the range `[begin, end)` that
+    /// is not ruled out by the summaries in the B+-tree rooted at this
+    /// inner node. `cond` is one of the condition identifiers defined
+    /// in query_conditions.hpp, and the elements are compared against
+    /// \a value. Returns \a end if all elements in the range are ruled
+    /// out. Nothing is ruled out for conditions other than cond_Equal,
+    /// cond_NotEqual, cond_Greater, and cond_Less, or when the tree
+    /// carries no summaries.
+    size_t find_bptree_candidate(int cond, int64_t value, size_t begin, size_t end) const noexcept;
+
+
     class NodeInfo;
     class VisitHandler;
 
@@ -169,6 +198,16 @@ protected:
     ref_type insert_bptree_child(Array& offsets, size_t orig_child_ndx, ref_type new_sibling_ref,
                                  TreeInsertBase& state);
 
+    /// Widen the summary bounds of the specified child to include the
+    /// values being inserted.
+    template <class TreeTraits>
+    void update_bptree_summary(size_t child_ndx, const TreeInsert<TreeTraits>& state);
+    void widen_bptree_summary(size_t child_ndx, int64_t min, int64_t max);
+
+    /// Recompute the summary bounds of this node and all inner nodes
+    /// below it.
+    void refresh_bptree_summary();
+
     void ensure_bptree_offsets(Array& offsets);
     void create_bptree_offsets(Array& offsets, int_fast64_t first_value);
 
@@ -201,7 +240,12 @@ public:
     bool root_is_leaf() const noexcept;
     BpTreeNode& root_as_node();
     const BpTreeNode& root_as_node() const;
-    void introduce_new_root(ref_type new_sibling_ref, TreeInsertBase& state, bool is_append);
+    /// If \a summarize is true, and the original root is either a leaf
+    /// or an inner node with a summary, the new root is given a
+    /// summary too (see BpTreeNode::has_bptree_summary()). This is only
+    /// allowed for trees of plain integers.
+    void introduce_new_root(ref_type new_sibling_ref, TreeInsertBase& state, bool is_append,
+                            bool summarize = false);
     void replace_root(std::unique_ptr<Array> leaf);
 
 protected:
@@ -285,6 +329,13 @@ public:
     void set(size_t, T value);
     void set_null(size_t);
     void insert(size_t ndx, T value, size_t num_rows = 1);
+
+    /// Append the specified values to the end of the tree. Once the last
+    /// leaf is full, the remaining values are written to new leaves whose
+    /// width is computed up front, and each new leaf is attached to the
+    /// tree as a whole, rather than one element at a time.
+    void append(const T* values, size_t num_values);
+
     void erase(size_t ndx, bool is_last = false);
     void move_last_over(size_t ndx, size_t last_row_ndx);
     void clear();
@@ -294,6 +345,16 @@ public:
     size_t find_first(T value, size_t begin = 0, size_t end = npos) const;
     void find_all(IntegerColumn& out_indices, T value, size_t begin = 0, size_t end = npos) const;
 
+    /// See BpTreeNode::find_bptree_candidate().
+    size_t find_candidate(int cond, int64_t value, size_t begin, size_t end) const noexcept;
+
+    /// Let new root nodes carry a summary of the values in their
+    /// children (see BpTreeNode::has_bptree_summary()), provided that
+    /// the allocator allows compact leaves. Only for trees of plain
+    /// integers. Inner nodes of a tree that has summaries already
+    /// maintain them regardless of this setting.
+    void enable_summaries() noexcept;
+
     static MemRef create_leaf(Array::Type leaf_type, size_t size, T value, Allocator&);
 
     /// See LeafInfo for information about what to put in the inout_leaf
@@ -338,9 +399,12 @@ private:
 
     struct LeafValueInserter;
     struct LeafNullInserter;
+    struct LeafAppender;
 
     template <class TreeTraits>
     void bptree_insert(size_t row_ndx, BpTreeNode::TreeInsert<TreeTraits>& state, size_t num_rows);
+
+    bool m_summarize = false;
 };
 
 
@@ -503,6 +567,30 @@ inline size_t BpTreeNode::get_bptree_size_from_header(const char* root_header) n
     return size_t(v / 2); // v = 1 + 2*total_elems_in_tree
 }
 
+inline bool BpTreeNode::has_bptree_summary() const noexcept
+{
+    REALM_ASSERT_DEBUG(is_inner_bptree_node());
+    return get_context_flag();
+}
+
+inline bool BpTreeNode::has_bptree_summary_from_header(const char* node_header) noexcept
+{
+    REALM_ASSERT_DEBUG(get_is_inner_bptree_node_from_header(node_header));
+    return get_context_flag_from_header(node_header);
+}
+
+inline size_t BpTreeNode::get_num_bptree_children() const noexcept
+{
+    // Not counting the first slot (elems_per_child or offsets_ref), the
+    // summary ref (if any), and the last slot (total_elems_in_subtree)
+    return size() - (has_bptree_summary() ? 3 : 2);
+}
+
+inline size_t BpTreeNode::get_num_bptree_children_from_header(const char* node_header) noexcept
+{
+    return get_size_from_header(node_header) - (has_bptree_summary_from_header(node_header) ? 3 : 2);
+}
+
 inline void BpTreeNode::ensure_bptree_offsets(Array& offsets)
 {
     int_fast64_t first_value = get(0);
@@ -515,6 +603,92 @@ inline void BpTreeNode::ensure_bptree_offsets(Array& offsets)
     offsets.set_parent(this, 0);
 }
 
+namespace _impl {
+
+/// The values that are appended by BpTree<T>::append(). Each step of
+/// the append records the bounds of the values that it added, so that
+/// they can be merged into the summaries of the inner nodes above.
+template <class T>
+struct BpTreeAppendChunk {
+    const T* m_values;
+    size_t m_num_values;
+    int64_t m_min, m_max;
+};
+
+// Only trees of plain integers carry summaries, so this is where the
+// bounds of the inserted values are made available to them.
+inline bool get_bptree_summary_bounds(int64_t value, int64_t& min, int64_t& max) noexcept
+{
+    min = value;
+    max = value;
+    return true;
+}
+
+inline bool get_bptree_summary_bounds(const BpTreeAppendChunk<int64_t>& chunk, int64_t& min, int64_t& max) noexcept
+{
+    min = chunk.m_min;
+    max = chunk.m_max;
+    return true;
+}
+
+template <class V>
+inline bool get_bptree_summary_bounds(const V&, int64_t&, int64_t&) noexcept
+{
+    return false;
+}
+
+// Append values to a leaf. The width needed by all of them is
+// established first, so the existing elements are expanded at most
+// once.
+inline void append_to_bptree_leaf(ArrayInteger& leaf, const int64_t* values, size_t num_values, int64_t& min,
+                                  int64_t& max)
+{
+    REALM_ASSERT_DEBUG(num_values != 0);
+    min = values[0];
+    max = values[0];
+    for (size_t i = 1; i < num_values; ++i) {
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+    leaf.ensure_minimum_width(min); // Throws
+    leaf.ensure_minimum_width(max); // Throws
+    for (size_t i = 0; i < num_values; ++i)
+        leaf.add(values[i]); // Throws
+}
+
+// The null marker of a nullable leaf has to be moved along with the
+// width, so here the width grows one value at a time.
+template <class L, class T>
+inline void append_to_bptree_leaf(L& leaf, const T* values, size_t num_values, int64_t&, int64_t&)
+{
+    for (size_t i = 0; i < num_values; ++i)
+        leaf.add(values[i]); // Throws
+}
+
+// A leaf that has been filled up by an append will most likely stay
+// unmodified, which makes it a candidate for the frame-of-reference form
+// (see Array::bptree_leaf_insert()).
+inline void compress_full_bptree_leaf(ArrayInteger& leaf)
+{
+    if (leaf.get_alloc().allows_compact_leaves())
+        leaf.compress_with_base(); // Throws
+}
+
+template <class L>
+inline void compress_full_bptree_leaf(L&)
+{
+}
+
+} // namespace _impl
+
+template <class TreeTraits>
+void BpTreeNode::update_bptree_summary(size_t child_ndx, const TreeInsert<TreeTraits>& state)
+{
+    int64_t min = 0, max = 0;
+    bool is_integer = _impl::get_bptree_summary_bounds(state.m_value, min, max);
+    REALM_ASSERT(is_integer);
+    widen_bptree_summary(child_ndx, min, max); // Throws
+}
 
 template <class TreeTraits>
 ref_type BpTreeNode::bptree_append(TreeInsert<TreeTraits>& state)
@@ -549,7 +723,7 @@ ref_type BpTreeNode::bptree_append(TreeInsert<TreeTraits>& state)
     REALM_ASSERT_DEBUG(size() >= 1 + 1 + 1); // At least one child
 
     ArrayParent& childs_parent = *this;
-    size_t child_ref_ndx = size() - 2;
+    size_t child_ref_ndx = get_num_bptree_children();
     ref_type child_ref = get_as_ref(child_ref_ndx), new_sibling_ref;
     char* child_header = static_cast<char*>(m_alloc.translate(child_ref));
 
@@ -567,9 +741,11 @@ ref_type BpTreeNode::bptree_append(TreeInsert<TreeTraits>& state)
     }
 
     if (REALM_LIKELY(!new_sibling_ref)) {
-        // +2 because stored value is 1 + 2*total_elems_in_subtree
-        adjust(size() - 1, +2); // Throws
-        return 0;               // Child was not split, so parent was not split either
+        if (has_bptree_summary())
+            update_bptree_summary(child_ref_ndx - 1, state); // Throws
+        // 2 per element because stored value is 1 + 2*total_elems_in_subtree
+        adjust(size() - 1, 2 * int64_t(state.m_num_inserted)); // Throws
+        return 0; // Child was not split, so parent was not split either
     }
 
     Array offsets(m_alloc);
@@ -609,7 +785,7 @@ ref_type BpTreeNode::bptree_insert(size_t elem_ndx, TreeInsert<TreeTraits>& stat
         // essentially a matter of using the lower vs. the upper bound
         // when searching through the offsets array.
         child_ndx = offsets.lower_bound_int(elem_ndx);
-        REALM_ASSERT_3(child_ndx, <, size() - 2);
+        REALM_ASSERT_3(child_ndx, <, get_num_bptree_children());
         size_t elem_ndx_offset = child_ndx == 0 ? 0 : to_size_t(offsets.get(child_ndx - 1));
         elem_ndx_in_child = elem_ndx - elem_ndx_offset;
     }
@@ -631,10 +807,16 @@ ref_type BpTreeNode::bptree_insert(size_t elem_ndx, TreeInsert<TreeTraits>& stat
         new_sibling_ref = child.bptree_insert(elem_ndx_in_child, state); // Throws
     }
 
+    // If the child was split, the inserted value may have ended up in
+    // either half, but the bounds of the new sibling are computed from
+    // its contents by insert_bptree_child().
+    if (has_bptree_summary())
+        update_bptree_summary(child_ndx, state); // Throws
+
     if (REALM_LIKELY(!new_sibling_ref)) {
-        // +2 because stored value is 1 + 2*total_elems_in_subtree
-        adjust(size() - 1, +2); // Throws
-        offsets.adjust(child_ndx, offsets.size(), +1);
+        // 2 per element because stored value is 1 + 2*total_elems_in_subtree
+        adjust(size() - 1, 2 * int64_t(state.m_num_inserted)); // Throws
+        offsets.adjust(child_ndx, offsets.size(), int64_t(state.m_num_inserted));
         return 0; // Child was not split, so parent was not split either
     }
 
@@ -842,7 +1024,8 @@ void BpTree<T>::bptree_insert(size_t row_ndx, BpTreeNode::TreeInsert<TreeTraits>
 
         if (REALM_UNLIKELY(new_sibling_ref)) {
             bool is_append = row_ndx_2 == realm::npos;
-            introduce_new_root(new_sibling_ref, state, is_append);
+            bool summarize = m_summarize && get_alloc().allows_compact_leaves();
+            introduce_new_root(new_sibling_ref, state, is_append, summarize);
         }
     }
 }
@@ -893,6 +1076,92 @@ void BpTree<T>::insert(size_t row_ndx, T value, size_t num_rows)
     bptree_insert(row_ndx, inserter, num_rows);                            // Throws
 }
 
+template <class T>
+struct BpTree<T>::LeafAppender {
+    using value_type = _impl::BpTreeAppendChunk<T>;
+
+    // TreeTraits concept:
+    static ref_type leaf_insert(MemRef leaf_mem, ArrayParent& parent, size_t ndx_in_parent, Allocator& alloc,
+                                size_t ndx_in_leaf, BpTreeNode::TreeInsert<LeafAppender>& state)
+    {
+        REALM_ASSERT_DEBUG(ndx_in_leaf == npos);
+        static_cast<void>(ndx_in_leaf);
+        LeafType leaf{alloc};
+        leaf.init_from_mem(leaf_mem);
+        leaf.set_parent(&parent, ndx_in_parent);
+        return append_to_leaf(leaf, state); // Throws
+    }
+
+    // Fill up the specified leaf. If values remain after that, as many of
+    // them as will fit are put into a new leaf, which is then returned as
+    // the new sibling.
+    static ref_type append_to_leaf(LeafType& leaf, BpTreeNode::TreeInsert<LeafAppender>& state)
+    {
+        value_type& chunk = state.m_value;
+        size_t leaf_size = leaf.size();
+        REALM_ASSERT_DEBUG(leaf_size <= REALM_MAX_BPNODE_SIZE);
+        size_t num_in_leaf = std::min(size_t(REALM_MAX_BPNODE_SIZE - leaf_size), chunk.m_num_values);
+        size_t num_in_sibling = std::min(size_t(REALM_MAX_BPNODE_SIZE), chunk.m_num_values - num_in_leaf);
+        int64_t min = 0, max = 0;
+        if (num_in_leaf != 0)
+            _impl::append_to_bptree_leaf(leaf, chunk.m_values, num_in_leaf, min, max); // Throws
+
+        ref_type new_sibling_ref = 0;
+        if (num_in_sibling != 0) {
+            Allocator& alloc = leaf.get_alloc();
+            MemRef mem = create_leaf(Array::type_Normal, 0, T{}, alloc); // Throws
+            LeafType new_leaf{alloc};
+            new_leaf.init_from_mem(mem);
+            _impl::DeepArrayDestroyGuard dg(&new_leaf);
+            int64_t sibling_min = 0, sibling_max = 0;
+            _impl::append_to_bptree_leaf(new_leaf, chunk.m_values + num_in_leaf, num_in_sibling, sibling_min,
+                                         sibling_max); // Throws
+            _impl::compress_full_bptree_leaf(leaf);    // Throws
+            if (num_in_leaf == 0) {
+                min = sibling_min;
+                max = sibling_max;
+            }
+            else {
+                min = std::min(min, sibling_min);
+                max = std::max(max, sibling_max);
+            }
+            dg.release();
+            new_sibling_ref = new_leaf.get_ref();
+            state.m_split_offset = REALM_MAX_BPNODE_SIZE;
+            state.m_split_size = REALM_MAX_BPNODE_SIZE + num_in_sibling;
+        }
+        state.m_num_inserted = num_in_leaf + num_in_sibling;
+        chunk.m_values += state.m_num_inserted;
+        chunk.m_num_values -= state.m_num_inserted;
+        chunk.m_min = min;
+        chunk.m_max = max;
+        return new_sibling_ref;
+    }
+};
+
+template <class T>
+void BpTree<T>::append(const T* values, size_t num_values)
+{
+    BpTreeNode::TreeInsert<LeafAppender> state;
+    state.m_value.m_values = values;
+    state.m_value.m_num_values = num_values;
+    state.m_nullable = std::is_same<T, util::Optional<int64_t>>::value; // FIXME
+    while (state.m_value.m_num_values != 0) {
+        ref_type new_sibling_ref;
+        if (root_is_leaf()) {
+            new_sibling_ref = LeafAppender::append_to_leaf(root_as_leaf(), state); // Throws
+        }
+        else {
+            new_sibling_ref = root_as_node().bptree_append(state); // Throws
+        }
+        if (new_sibling_ref) {
+            bool is_append = true;
+            bool summarize = m_summarize && get_alloc().allows_compact_leaves();
+            introduce_new_root(new_sibling_ref, state, is_append, summarize); // Throws
+        }
+    }
+}
+
 template <class T>
 struct BpTree<T>::UpdateHandler : BpTreeNode::UpdateHandler {
     LeafType m_leaf;
@@ -1234,6 +1503,21 @@ void BpTree<T>::find_all(IntegerColumn& result, T value, size_t begin, size_t en
     }
 }
 
+template <class T>
+size_t BpTree<T>::find_candidate(int cond, int64_t value, size_t begin, size_t end) const noexcept
+{
+    if (root_is_leaf())
+        return begin;
+    return root_as_node().find_bptree_candidate(cond, value, begin, end);
+}
+
+template <class T>
+void BpTree<T>::enable_summaries() noexcept
+{
+    static_assert(std::is_same<T, int64_t>::value, "Only trees of plain integers can carry summaries");
+    m_summarize = true;
+}
+
 #if defined(REALM_DEBUG)
 template <class T>
 size_t BpTree<T>::verify_leaf(MemRef mem, Allocator& alloc)
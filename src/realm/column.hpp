@@ -590,6 +590,18 @@ public:
     /// and never directly through the specfied fallback accessor.
     void get_leaf(size_t ndx, size_t& ndx_in_leaf, LeafInfo& inout_leaf) const noexcept;
 
+    /// Find the first element index in `[begin, end)` that is not ruled
+    /// out by the per-subtree value bounds of the underlying B+-tree,
+    /// or  end if there is none. See
+    /// BpTreeNode::find_bptree_candidate().
+    size_t find_candidate(int cond, int64_t value, size_t begin, size_t end) const noexcept;
+
+    /// Enable per-subtree value bounds in the underlying B+-tree. This
+    /// is done for integer columns of tables only. Other users of
+    /// integer columns, like the search index, may rely on the context
+    /// flag of an inner root node being clear.
+    void enable_bptree_summaries() noexcept;
+
     // Getting and setting values
     T get(size_t ndx) const noexcept;
     bool is_null(size_t ndx) const noexcept override;
@@ -598,6 +610,9 @@ public:
     void set_null(size_t) override;
     void add(T value = T{});
     void insert(size_t ndx, T value = T{}, size_t num_rows = 1);
+    /// Same as calling add() for each of the specified values, but the
+    /// values are written to the leaves in bulk (see BpTree<T>::append()).
+    void append(const T* values, size_t num_values);
     void erase(size_t row_ndx);
     void erase(size_t row_ndx, bool is_last);
     void move_last_over(size_t row_ndx, size_t last_row_ndx);
@@ -1007,6 +1022,18 @@ void Column<T>::get_leaf(size_t ndx, size_t& ndx_in_leaf, LeafInfo& inout_leaf_i
     m_tree.get_leaf(ndx, ndx_in_leaf, inout_leaf_info);
 }
 
+template <class T>
+size_t Column<T>::find_candidate(int cond, int64_t value, size_t begin, size_t end) const noexcept
+{
+    return m_tree.find_candidate(cond, value, begin, end);
+}
+
+template <class T>
+void Column<T>::enable_bptree_summaries() noexcept
+{
+    m_tree.enable_summaries();
+}
+
 template <class T>
 StringData Column<T>::get_index_data(size_t ndx, StringIndex::StringConversionBuffer& buffer) const noexcept
 {
@@ -1319,6 +1346,19 @@ void Column<T>::insert(size_t row_ndx, T value, size_t num_rows)
     }
 }
 
+template <class T>
+void Column<T>::append(const T* values, size_t num_values)
+{
+    size_t column_size = this->size(); // Slow
+    m_tree.append(values, num_values); // Throws
+
+    if (has_search_index()) {
+        bool is_append = true;
+        for (size_t i = 0; i < num_values; ++i)
+            m_search_index->insert(column_size + i, values[i], 1, is_append); // Throws
+    }
+}
+
 template <class T>
 void Column<T>::erase_without_updating_index(size_t row_ndx, bool is_last)
 {
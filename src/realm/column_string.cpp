@@ -28,6 +28,7 @@
 #include <realm/column_string.hpp>
 #include <realm/index_string.hpp>
 #include <realm/table.hpp>
+#include <realm/util/scope_exit.hpp>
 
 using namespace realm;
 using namespace realm::util;
@@ -128,6 +129,7 @@ StringColumn::~StringColumn() noexcept
 
 void StringColumn::destroy() noexcept
 {
+    discard_compressed_leaves();
     ColumnBaseSimple::destroy();
     if (m_search_index)
         m_search_index->destroy();
@@ -173,12 +175,31 @@ StringData StringColumn::get(size_t ndx) const noexcept
     bool is_big = Array::get_context_flag_from_header(leaf_header);
     if (!is_big) {
         // Medimum strings
+        if (REALM_UNLIKELY(ArrayStringLong::is_compressed(leaf_header, alloc))) {
+            // Allocates on first access to the leaf
+            return get_compressed_leaf(p.first).get(ndx_in_leaf);
+        }
         return ArrayStringLong::get(leaf_header, ndx_in_leaf, alloc, m_nullable);
     }
     // Big strings
     return ArrayBigBlobs::get_string(leaf_header, ndx_in_leaf, alloc, m_nullable);
 }
 
+const ArrayStringLong& StringColumn::get_compressed_leaf(MemRef mem) const
+{
+    std::unique_ptr<ArrayStringLong>& leaf = m_compressed_leaves[mem.get_ref()]; // Throws
+    if (!leaf) {
+        leaf.reset(new ArrayStringLong(m_array->get_alloc(), m_nullable)); // Throws
+        leaf->init_from_mem(mem);
+    }
+    return *leaf;
+}
+
+void StringColumn::discard_compressed_leaves() noexcept
+{
+    m_compressed_leaves.clear();
+}
+
 bool StringColumn::is_null(size_t ndx) const noexcept
 {
 #ifdef REALM_DEBUG
@@ -262,6 +283,7 @@ void StringColumn::set_ndx_in_parent(size_t ndx_in_parent) noexcept
 
 void StringColumn::update_from_parent(size_t old_baseline) noexcept
 {
+    discard_compressed_leaves();
     if (root_is_leaf()) {
         bool long_strings = m_array->has_refs();
         if (!long_strings) {
@@ -371,6 +393,10 @@ void StringColumn::set(size_t ndx, StringData value)
 {
     REALM_ASSERT_DEBUG(ndx < size());
 
+    // Values obtained from compressed leaves may be the input to this
+    // modification, so they are only discarded afterwards.
+    auto discard = util::make_scope_exit([&]() noexcept { discard_compressed_leaves(); });
+
     // We must modify the search index before modifying the column, because we
     // need to be able to abort the operation if the modification of the search
     // index fails due to a unique constraint violation.
@@ -516,6 +542,8 @@ void StringColumn::do_erase(size_t ndx, bool is_last)
     REALM_ASSERT_3(ndx, <, size());
     REALM_ASSERT_3(is_last, ==, (ndx == size() - 1));
 
+    auto discard = util::make_scope_exit([&]() noexcept { discard_compressed_leaves(); });
+
     // Update search index
     // (it is important here that we do it before actually setting
     //  the value, or the index would not be able to find the correct
@@ -558,6 +586,8 @@ void StringColumn::do_move_last_over(size_t row_ndx, size_t last_row_ndx)
     REALM_ASSERT_3(row_ndx, <=, last_row_ndx);
     REALM_ASSERT_3(last_row_ndx + 1, ==, size());
 
+    auto discard = util::make_scope_exit([&]() noexcept { discard_compressed_leaves(); });
+
     // FIXME: ExceptionSafety: The current implementation of this
     // function is not exception-safe, and it is hard to see how to
     // repair it.
@@ -657,6 +687,8 @@ void StringColumn::do_swap_rows(size_t row_ndx_1, size_t row_ndx_2)
 
 void StringColumn::do_clear()
 {
+    auto discard = util::make_scope_exit([&]() noexcept { discard_compressed_leaves(); });
+
     if (root_is_leaf()) {
         bool long_strings = m_array->has_refs();
         if (!long_strings) {
@@ -1096,6 +1128,9 @@ void StringColumn::do_insert(size_t row_ndx, StringData value, size_t num_rows,
 void StringColumn::bptree_insert(size_t row_ndx, StringData value, size_t num_rows)
 {
     REALM_ASSERT(row_ndx == realm::npos || row_ndx < size());
+
+    auto discard = util::make_scope_exit([&]() noexcept { discard_compressed_leaves(); });
+
     ref_type new_sibling_ref = 0;
     BpTreeNode::TreeInsert<StringColumn> state;
     for (size_t i = 0; i != num_rows; ++i) {
@@ -1414,6 +1449,7 @@ ref_type StringColumn::write(size_t slice_offset, size_t slice_size, size_t tabl
 
 void StringColumn::refresh_accessor_tree(size_t col_ndx, const Spec& spec)
 {
+    discard_compressed_leaves();
     ColumnBaseSimple::refresh_accessor_tree(col_ndx, spec);
     refresh_root_accessor(); // Throws
 
@@ -19,6 +19,7 @@
 #ifndef REALM_COLUMN_STRING_HPP
 #define REALM_COLUMN_STRING_HPP
 
+#include <map>
 #include <memory>
 #include <realm/array_string.hpp>
 #include <realm/array_string_long.hpp>
@@ -36,7 +37,8 @@ class StringIndex;
 /// the root of the column is the root of the B+-tree. Leaf nodes are
 /// either of type ArrayString (array of small strings),
 /// ArrayStringLong (array of medium strings), or ArrayBigBlobs (array
-/// of big strings).
+/// of big strings). Medium string leaves may be compressed, see
+/// ArrayStringLong::compress().
 ///
 /// A string column can optionally be equipped with a search index. If
 /// it is, then the root ref of the index is stored in
@@ -145,6 +147,15 @@ private:
     std::unique_ptr<StringIndex> m_search_index;
     bool m_nullable;
 
+    // Accessors for the compressed medium string leaves that get() has been
+    // reading from, by leaf ref. A compressed leaf is decoded into its
+    // accessor, so these are kept until the column is modified or refreshed,
+    // as that is how long the returned StringData must stay valid.
+    mutable std::map<ref_type, std::unique_ptr<ArrayStringLong>> m_compressed_leaves;
+
+    const ArrayStringLong& get_compressed_leaf(MemRef) const;
+    void discard_compressed_leaves() noexcept;
+
     LeafType get_block(size_t ndx, ArrayParent**, size_t& off, bool use_retval = false) const;
 
     /// If you are appending and have the size of the column readily available,
@@ -370,6 +370,31 @@ void TimestampColumn::add(const Timestamp& ts)
     }
 }
 
+void TimestampColumn::append(const Timestamp* values, size_t num_values)
+{
+    size_t column_size = size(); // Slow
+
+    // Split the values into their two parts one leaf at a time
+    util::Optional<int64_t> seconds[REALM_MAX_BPNODE_SIZE];
+    int64_t nanoseconds[REALM_MAX_BPNODE_SIZE];
+    for (size_t begin = 0; begin < num_values; begin += REALM_MAX_BPNODE_SIZE) {
+        size_t n = std::min(num_values - begin, size_t(REALM_MAX_BPNODE_SIZE));
+        for (size_t i = 0; i < n; ++i) {
+            const Timestamp& ts = values[begin + i];
+            bool ts_is_null = ts.is_null();
+            seconds[i] = ts_is_null ? util::none : util::make_optional(ts.get_seconds());
+            nanoseconds[i] = ts_is_null ? 0 : ts.get_nanoseconds();
+        }
+        m_seconds->append(seconds, n);         // Throws
+        m_nanoseconds->append(nanoseconds, n); // Throws
+    }
+
+    if (has_search_index()) {
+        for (size_t i = 0; i < num_values; ++i)
+            m_search_index->insert(column_size + i, values[i], 1, true); // Throws
+    }
+}
+
 Timestamp TimestampColumn::get(size_t row_ndx) const noexcept
 {
     util::Optional<int64_t> seconds = m_seconds->get(row_ndx);
@@ -85,6 +85,9 @@ public:
     void leaf_to_dot(MemRef, ArrayParent*, size_t ndx_in_parent, std::ostream&) const override;
 
     void add(const Timestamp& ts = Timestamp{});
+    /// Same as calling add() for each of the specified values, but the
+    /// values are written to the leaves in bulk (see BpTree<T>::append()).
+    void append(const Timestamp* values, size_t num_values);
     Timestamp get(size_t row_ndx) const noexcept;
     void set(size_t row_ndx, const Timestamp& ts);
     bool compare(const TimestampColumn& c) const noexcept;
@@ -91,6 +91,9 @@ const char* LogicError::what() const noexcept
             return "Column does not exist";
         case subtable_of_subtable_index:
             return "Search index on a subtable of a subtable is not yet supported";
+        case mixed_group_commit:
+            return "Group commit setting (as passed to the SharedGroup constructor) was "
+                   "not consistent across the session";
     }
     return "Unknown error";
 }
@@ -225,7 +225,11 @@ public:
         column_does_not_exist,
 
         /// You can not add index on a subtable of a subtable
-        subtable_of_subtable_index
+        subtable_of_subtable_index,
+
+        /// Group commit setting (as passed to the SharedGroup constructor) was
+        /// not consistent across the session.
+        mixed_group_commit
     };
 
     LogicError(ErrorKind message);
@@ -66,7 +66,7 @@ Group::Group()
 {
     init_array_parents();
     m_alloc.attach_empty(); // Throws
-    m_file_format_version = get_target_file_format_version_for_session(0, Replication::hist_None);
+    set_file_format_version(get_target_file_format_version_for_session(0, Replication::hist_None));
     ref_type top_ref = 0; // Instantiate a new empty group
     bool create_group_when_missing = true;
     attach(top_ref, create_group_when_missing); // Throws
@@ -82,6 +82,7 @@ int Group::get_file_format_version() const noexcept
 void Group::set_file_format_version(int file_format) noexcept
 {
     m_file_format_version = file_format;
+    m_alloc.m_allow_compact_leaves = (file_format >= 10);
 }
 
 
@@ -115,7 +116,10 @@ int Group::get_target_file_format_version_for_session(int current_file_format_ve
     if (requested_history_type == Replication::hist_None && current_file_format_version == 8)
         return 8;
 
-    return 9;
+    if (requested_history_type == Replication::hist_None && current_file_format_version == 9)
+        return 9;
+
+    return 10;
 }
 
 
@@ -126,7 +130,7 @@ void Group::upgrade_file_format(int target_file_format_version)
     // Be sure to revisit the following upgrade logic when a new file format
     // version is introduced. The following assert attempt to help you not
     // forget it.
-    REALM_ASSERT_EX(target_file_format_version == 9, target_file_format_version);
+    REALM_ASSERT_EX(target_file_format_version == 10, target_file_format_version);
 
     int current_file_format_version = get_file_format_version();
     REALM_ASSERT(current_file_format_version < target_file_format_version);
@@ -134,7 +138,7 @@ void Group::upgrade_file_format(int target_file_format_version)
     // SharedGroup::do_open() must ensure this. Be sure to revisit the
     // following upgrade logic when SharedGroup::do_open() is changed (or
     // vice versa).
-    REALM_ASSERT_EX(current_file_format_version >= 2 && current_file_format_version <= 8,
+    REALM_ASSERT_EX(current_file_format_version >= 2 && current_file_format_version <= 9,
                     current_file_format_version);
 
     // Upgrade from version prior to 5 (datetime -> timestamp)
@@ -167,6 +171,9 @@ void Group::upgrade_file_format(int target_file_format_version)
 
     // Upgrading to version 9 doesn't require changing anything.
 
+    // Upgrading to version 10 doesn't require changing anything either. Leaves
+    // are only stored in the frame-of-reference form from then on.
+
     // NOTE: Additional future upgrade steps go here.
 
     set_file_format_version(target_file_format_version);
@@ -177,12 +184,12 @@ void Group::open(ref_type top_ref, const std::string& file_path)
     SlabAlloc::DetachGuard dg(m_alloc);
 
     // Select file format if it is still undecided.
-    m_file_format_version = m_alloc.get_committed_file_format_version();
+    set_file_format_version(m_alloc.get_committed_file_format_version());
 
     bool file_format_ok = false;
     // In non-shared mode (Realm file opened via a Group instance) this version
     // of the core library is only able to open Realms using file format version
-    // 6, 7, 8 or 9. These versions can be read without an upgrade.
+    // 6, 7, 8, 9 or 10. These versions can be read without an upgrade.
     // Since a Realm file cannot be upgraded when opened in this mode
     // (we may be unable to write to the file), no earlier versions can be opened.
     // Please see Group::get_file_format_version() for information about the
@@ -195,6 +202,7 @@ void Group::open(ref_type top_ref, const std::string& file_path)
         case 7:
         case 8:
         case 9:
+        case 10:
             file_format_ok = true;
             break;
     }
@@ -1784,13 +1792,15 @@ void Group::refresh_dirty_accessors()
 {
     m_top.get_alloc().bump_global_version();
 
-    // Refresh all remaining dirty table accessors
+    // Refresh all remaining dirty table accessors. Tables that were not
+    // touched by the changes are left alone, unless their arrays were moved
+    // (see SharedGroupOptions::compaction_budget), which does not mark them.
     size_t num_tables = m_table_accessors.size();
     for (size_t table_ndx = 0; table_ndx != num_tables; ++table_ndx) {
         if (Table* table = m_table_accessors[table_ndx]) {
             typedef _impl::TableFriend tf;
             tf::set_ndx_in_parent(*table, table_ndx);
-            if (tf::is_marked(*table)) {
+            if (tf::is_marked(*table) || table->m_top.get_ref() != m_tables.get_as_ref(table_ndx)) {
                 tf::refresh_accessor_tree(*table); // Throws
                 bool bump_global = false;
                 tf::bump_version(*table, bump_global);
@@ -2159,7 +2169,7 @@ void Group::verify() const
     // Check the concistency of the allocation of the mutable memory that has
     // been marked as free
     for (const auto& free_block : m_alloc.m_free_space) {
-        mem_usage_2.add_mutable(free_block.ref, free_block.size);
+        mem_usage_2.add_mutable(free_block.first, free_block.second.size);
     }
     mem_usage_2.canonicalize();
     mem_usage_1.add(mem_usage_2);
@@ -764,6 +764,13 @@ private:
     ///
     ///   9 Replication instruction values shuffled, instr_MoveRow added.
     ///
+    ///  10 Integer arrays may use the frame-of-reference form
+    ///     (Array::wtype_BitsWithBase). Full integer column leaves are stored
+    ///     in that form when it is smaller. Medium string leaves
+    ///     (ArrayStringLong) may be compressed with a symbol table. Inner
+    ///     B+-tree nodes of integer columns may carry a summary of the
+    ///     value range of each child (BpTreeNode::has_bptree_summary()).
+    ///
     /// IMPORTANT: When introducing a new file format version, be sure to review
     /// the file validity checks in Group::open() and SharedGroup::do_open, the file
     /// format selection logic in
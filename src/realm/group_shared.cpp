@@ -19,10 +19,12 @@
 #include <algorithm>
 #include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <fcntl.h>
 #include <iostream>
 #include <mutex>
 #include <sstream>
+#include <system_error>
 #include <type_traits>
 #include <random>
 
@@ -39,6 +41,7 @@
 #include <realm/disable_sync_to_disk.hpp>
 
 #ifndef _WIN32
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/time.h>
 #include <unistd.h>
@@ -57,12 +60,6 @@ using Durability = SharedGroupOptions::Durability;
 
 namespace {
 
-// Constants controlling the amount of uncommited writes in flight:
-#ifdef REALM_ASYNC_DAEMON
-const uint16_t max_write_slots = 100;
-const uint16_t relaxed_sync_threshold = 50;
-#endif
-
 // value   change
 // --------------------
 //  4      Unknown
@@ -76,7 +73,7 @@ const uint16_t relaxed_sync_threshold = 50;
 //  9      Fair write transactions requires an additional condition variable,
 //         `write_fairness`
 // 10      Introducing SharedInfo::history_schema_version.
-const uint_fast16_t g_shared_info_version = 10;
+const uint_fast16_t g_shared_info_version = 16;
 
 // The following functions are carefully designed for minimal overhead
 // in case of contention among read transactions. In case of contention,
@@ -195,6 +192,38 @@ void atomic_dec(std::atomic<T>& counter)
     counter.fetch_sub(1, std::memory_order_release);
 }
 
+// The current time of the steady clock in nanoseconds, as stored in SharedInfo
+uint64_t steady_clock_now() noexcept
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+}
+
+#ifndef _WIN32
+
+void close_change_fd(int fd) noexcept
+{
+    ::close(fd);
+}
+
+// Make a change notification descriptor readable. If the pipe is full, it
+// already is.
+void signal_change_fd(int fd) noexcept
+{
+    char c = 0;
+    ssize_t ret = ::write(fd, &c, 1);
+    static_cast<void>(ret);
+}
+
+#else
+
+void close_change_fd(int) noexcept
+{
+}
+
+#endif
+
 // nonblocking ringbuffer
 class Ringbuffer {
 public:
@@ -210,16 +239,97 @@ public:
     // at a time tries to perform cleanup. This is ensured by doing the cleanup
     // as part of write transactions, where mutual exclusion is assured by the
     // write mutex.
+    //
+    // The count of each entry is split into shards, each on its own cache
+    // line. A reader only updates the shard assigned to its thread (see
+    // get_reader_shard()), so that threads starting and ending read
+    // transactions at the same time rarely contend for a cache line. Each
+    // shard follows the protocol described above on its own. An entry is
+    // free when all of its shards are.
+    static const int num_shards = 16;
+    static const size_t cache_line_size = 64;
+
+    struct Shard {
+        mutable std::atomic<uint32_t> count;
+        char padding[cache_line_size - sizeof(std::atomic<uint32_t>)];
+    };
+
     struct ReadCount {
         uint64_t version;
         uint64_t filesize;
         uint64_t current_top;
-        // The count field acts as synchronization point for accesses to the above
-        // fields. A succesfull inc implies acquire with regard to memory consistency.
-        // Release is triggered by explicitly storing into count whenever a
-        // new entry has been initialized.
-        mutable std::atomic<uint32_t> count;
+        // The time (steady clock, nanoseconds) at which the version was
+        // committed, and the amount of space freed by that commit. Used by the
+        // version retention policy.
+        uint64_t commit_time;
+        uint64_t released_bytes;
         uint32_t next;
+        // Keep the fields above, which are read by every reader, off the cache
+        // lines of the shards
+        char padding[cache_line_size - 5 * sizeof(uint64_t) - sizeof(uint32_t)];
+        // The count fields act as synchronization points for accesses to the
+        // above fields. A succesfull inc implies acquire with regard to memory
+        // consistency. Release is triggered by explicitly storing into the
+        // counts whenever a new entry has been initialized.
+        Shard shards[num_shards];
+
+        // Add a reader through the specified shard. Fails if the entry is
+        // free, or being freed, or has been invalidated.
+        bool try_lock(uint_fast32_t shard) const noexcept
+        {
+            return atomic_double_inc_if_even(shards[shard].count);
+        }
+
+        void unlock(uint_fast32_t shard) const noexcept
+        {
+            atomic_double_dec(shards[shard].count);
+        }
+
+        // Mark the entry as free, if no shard has any readers. Otherwise leave
+        // it unchanged, and fail.
+        bool try_free() const noexcept
+        {
+            for (int i = 0; i < num_shards; ++i) {
+                if (!atomic_one_if_zero(shards[i].count)) {
+                    while (i > 0)
+                        shards[--i].count.fetch_sub(1, std::memory_order_relaxed);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Make a free entry available to readers
+        void make_available() const noexcept
+        {
+            for (const Shard& shard : shards)
+                atomic_dec(shard.count);
+        }
+
+        void init_count(uint32_t value) noexcept
+        {
+            for (Shard& shard : shards)
+                shard.count.store(value, std::memory_order_relaxed);
+        }
+
+        void invalidate() const noexcept
+        {
+            for (const Shard& shard : shards)
+                shard.count.fetch_or(1, std::memory_order_relaxed);
+        }
+
+        bool is_invalidated(uint_fast32_t shard) const noexcept
+        {
+            return (shards[shard].count.load(std::memory_order_relaxed) & 1) != 0;
+        }
+
+        uint_fast32_t get_num_readers() const noexcept
+        {
+            uint_fast32_t n = 0;
+            for (const Shard& shard : shards)
+                n += shard.count.load(std::memory_order_relaxed) / 2;
+            return n;
+        }
     };
 
     Ringbuffer() noexcept
@@ -227,13 +337,15 @@ public:
         entries = init_readers_size;
         for (int i = 0; i < init_readers_size; i++) {
             data[i].version = 1;
-            data[i].count.store(1, std::memory_order_relaxed);
+            data[i].init_count(1);
             data[i].current_top = 0;
             data[i].filesize = 0;
+            data[i].commit_time = 0;
+            data[i].released_bytes = 0;
             data[i].next = i + 1;
         }
         old_pos = 0;
-        data[0].count.store(0, std::memory_order_relaxed);
+        data[0].init_count(0);
         data[init_readers_size - 1].next = 0;
         put_pos.store(0, std::memory_order_release);
     }
@@ -243,13 +355,13 @@ public:
         uint_fast32_t i = old_pos;
         std::cout << "--- " << std::endl;
         while (i != put_pos.load()) {
-            std::cout << "  used " << i << " : " << data[i].count.load() << " | " << data[i].version << std::endl;
+            std::cout << "  used " << i << " : " << data[i].get_num_readers() << " | " << data[i].version << std::endl;
             i = data[i].next;
         }
-        std::cout << "  LAST " << i << " : " << data[i].count.load() << " | " << data[i].version << std::endl;
+        std::cout << "  LAST " << i << " : " << data[i].get_num_readers() << " | " << data[i].version << std::endl;
         i = data[i].next;
         while (i != old_pos) {
-            std::cout << "  free " << i << " : " << data[i].count.load() << " | " << data[i].version << std::endl;
+            std::cout << "  free " << i << " : " << data[i].get_num_readers() << " | " << data[i].version << std::endl;
             i = data[i].next;
         }
         std::cout << "--- Done" << std::endl;
@@ -261,9 +373,11 @@ public:
         // dump();
         for (uint_fast32_t i = entries; i < new_entries; i++) {
             data[i].version = 1;
-            data[i].count.store(1, std::memory_order_relaxed);
+            data[i].init_count(1);
             data[i].current_top = 0;
             data[i].filesize = 0;
+            data[i].commit_time = 0;
+            data[i].released_bytes = 0;
             data[i].next = i + 1;
         }
         data[new_entries - 1].next = old_pos;
@@ -310,12 +424,12 @@ public:
     ReadCount& reinit_last() noexcept
     {
         ReadCount& r = data[last()];
-        // r.count is an atomic<> due to other usage constraints. Right here, we're
+        // The counts are atomic<> due to other usage constraints. Right here, we're
         // operating under mutex protection, so the use of an atomic store is immaterial
-        // and just forced on us by the type of r.count.
-        // You'll find the full discussion of how r.count is operated and why it must be
-        // an atomic earlier in this file.
-        r.count.store(0, std::memory_order_relaxed);
+        // and just forced on us by their type.
+        // You'll find the full discussion of how the counts are operated and why they
+        // must be atomic earlier in this file.
+        r.init_count(0);
         return r;
     }
 
@@ -345,7 +459,7 @@ public:
 
     void use_next() noexcept
     {
-        atomic_dec(get_next().count); // .store_release(0);
+        get_next().make_available();
         put_pos.store(next(), std::memory_order_release);
     }
 
@@ -356,13 +470,36 @@ public:
         // dump();
         while (old_pos.load(std::memory_order_relaxed) != put_pos.load(std::memory_order_relaxed)) {
             const ReadCount& r = get(old_pos.load(std::memory_order_relaxed));
-            if (!atomic_one_if_zero(r.count))
+            if (!r.try_free())
                 break;
             auto next_ndx = get(old_pos.load(std::memory_order_relaxed)).next;
             old_pos.store(next_ndx, std::memory_order_relaxed);
         }
     }
 
+    // Take the oldest entry out of the ring, even though it is in use, so that
+    // the versions after it are the oldest ones. Its counts are made odd, which
+    // no entry held by a reader otherwise has. This prevents it from being
+    // locked again, and tells its readers that it has been invalidated. As
+    // they release it, the counts remain odd. The entry is not reused in the
+    // current session. Like cleanup(), this must only be done by one thread
+    // at a time.
+    void invalidate_oldest() noexcept
+    {
+        uint_fast32_t idx = old_pos.load(std::memory_order_relaxed);
+        REALM_ASSERT(idx != put_pos.load(std::memory_order_relaxed));
+        ReadCount& r = data[idx];
+        r.invalidate();
+
+        // Unlink it. Its predecessor is the last free entry, or the last used
+        // one if the ring is full.
+        uint_fast32_t prev = put_pos.load(std::memory_order_relaxed);
+        while (data[prev].next != idx)
+            prev = data[prev].next;
+        data[prev].next = r.next;
+        old_pos.store(r.next, std::memory_order_relaxed);
+    }
+
 private:
     // number of entries. Access synchronized through put_pos.
     uint32_t entries;
@@ -380,6 +517,21 @@ private:
     ReadCount data[init_readers_size];
 };
 
+// Shard + 1 of the ringbuffer counts used by read transactions started by
+// this thread, or zero if not yet assigned
+REALM_THREAD_LOCAL uint_fast32_t t_reader_shard = 0;
+
+std::atomic<uint_fast32_t> g_next_reader_shard(0);
+
+// Threads are assigned shards round robin, so that up to
+// Ringbuffer::num_shards threads of a process never share one
+uint_fast32_t get_reader_shard() noexcept
+{
+    if (REALM_UNLIKELY(t_reader_shard == 0))
+        t_reader_shard = g_next_reader_shard.fetch_add(1, std::memory_order_relaxed) % Ringbuffer::num_shards + 1;
+    return t_reader_shard - 1;
+}
+
 } // anonymous namespace
 
 
@@ -484,17 +636,21 @@ struct alignas(8) SharedGroup::SharedInfo {
     /// sync agent can be started.
     uint8_t sync_agent_present = 0; // Offset 40
 
-    /// Set when a participant decides to start the daemon, cleared by the
-    /// daemon when it decides to exit. Participants check during open() and
-    /// start the daemon if running in async mode.
+    /// Set when a participant decides to start the thread that flushes the
+    /// Realm file with Durability::Async, cleared by that thread when it
+    /// exits. Participants check during open(), and before each write
+    /// transaction, and start the thread if it is not running.
     uint8_t daemon_started = 0; // Offset 41
 
-    /// Set by the daemon when it is ready to handle commits. Participants must
-    /// wait during open() on 'daemon_becomes_ready' for this to become true.
-    /// Cleared by the daemon when it decides to exit.
+    /// Set by the flushing thread when it is ready to handle commits.
+    /// Participants must wait on 'daemon_becomes_ready' for this to become
+    /// true. Cleared by the thread when it exits.
     uint8_t daemon_ready = 0; // Offset 42
 
-    uint8_t filler_1;  // Offset 43
+    /// Set (1) if the session uses group commit (see
+    /// SharedGroupOptions::enable_group_commit). Must match across all session
+    /// participants.
+    uint8_t group_commit = 0; // Offset 43
 
     /// Stores a history schema version (as returned by
     /// Replication::get_history_schema_version()). Must match across all
@@ -508,6 +664,7 @@ struct alignas(8) SharedGroup::SharedInfo {
     InterprocessMutex::SharedPart shared_balancemutex;
 #endif
     InterprocessMutex::SharedPart shared_controlmutex;
+    InterprocessMutex::SharedPart shared_flushmutex;
     // FIXME: windows pthread support for condvar not ready
     InterprocessCondVar::SharedPart room_to_write;
     InterprocessCondVar::SharedPart work_to_do;
@@ -517,6 +674,73 @@ struct alignas(8) SharedGroup::SharedInfo {
     std::atomic<uint32_t> next_ticket;
     uint32_t next_served = 0;
 
+    /// With group commit, Durability::Log or Durability::Async, the latest
+    /// version that the file header selects on stable storage. Versions after
+    /// it are visible to readers, but not yet durable in the Realm file.
+    /// Guarded by the controlmutex.
+    uint64_t durable_version = 0;
+
+    /// The top ref of the latest version (latest_version_number). Guarded by
+    /// the controlmutex.
+    uint64_t latest_top_ref = 0;
+
+    /// With group commit, the number of commits and the number of flushes of
+    /// the file done in the current session. Guarded by the controlmutex.
+    uint64_t num_group_commits = 0;
+    uint64_t num_group_flushes = 0;
+
+    /// With Durability::Log, the end of the records in each segment of the
+    /// write-ahead log, and the segment that commits append to. Guarded by the
+    /// writemutex, except that the end of the inactive segment is reset by the
+    /// checkpointer, which holds the flushmutex.
+    uint64_t log_end[_impl::WriteAheadLog::num_segments] = {0, 0};
+    uint8_t log_active_segment = 0;
+
+    /// With Durability::Log, set (1) by the session initiator if the
+    /// write-ahead log holds changesets that must be replayed before anybody
+    /// else may write, and cleared when they have been. log_replay_failed is
+    /// set (1) if the replay fails. Guarded by the controlmutex.
+    uint8_t log_replay_pending = 0;
+    uint8_t log_replay_failed = 0;
+
+    /// With Durability::Async, set (1) by the SharedGroup that started the
+    /// flushing thread to ask it to flush the latest version and exit. Guarded
+    /// by the balancemutex.
+    uint8_t daemon_stop = 0;
+
+    /// With Durability::Async, the number of write transactions that can be
+    /// started before the flushing thread has caught up, and the longest time
+    /// it waits between flushes (see SharedGroupOptions). Set by the session
+    /// initiator.
+    uint16_t max_unflushed_versions = 0;
+    uint32_t max_flush_delay_ms = 0;
+
+    /// With Durability::Async, the time (steady clock, nanoseconds) of the
+    /// oldest commit that has not yet been flushed, or zero if all commits are
+    /// flushed. Guarded by the controlmutex.
+    uint64_t oldest_unflushed_commit_time = 0;
+
+    /// The version retention policy (see
+    /// SharedGroupOptions::max_retained_versions). Set by the session
+    /// initiator. Zero means no limit.
+    uint64_t max_retained_versions = 0;
+    uint64_t max_retained_bytes = 0;
+    uint32_t max_pinned_age_ms = 0;
+    uint32_t filler_3 = 0;
+
+    /// The number of versions invalidated by the version retention policy in
+    /// the current session. Guarded by the controlmutex.
+    uint64_t num_invalidated_versions = 0;
+
+    /// The ids of the SharedGroups that have a change notification descriptor
+    /// (see SharedGroup::get_change_notification_fd()), zero in unused slots,
+    /// and the number of used slots. Slots of processes that crash are not
+    /// reclaimed until the session ends. Guarded by the controlmutex.
+    static const int max_change_subscribers = 64;
+    uint32_t num_change_subscribers = 0;
+    uint32_t filler_4 = 0;
+    uint64_t change_subscribers[max_change_subscribers] = {};
+
     // IMPORTANT: The ringbuffer MUST be the last field in SharedInfo - see above.
     Ringbuffer readers;
 
@@ -532,6 +756,8 @@ struct alignas(8) SharedGroup::SharedInfo {
         r.filesize = file_size;
         r.version = initial_version;
         r.current_top = top_ref;
+        r.commit_time = steady_clock_now();
+        r.released_bytes = 0;
     }
 
     uint_fast64_t get_current_version_unchecked() const
@@ -549,6 +775,7 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
     , shared_balancemutex() // Throws
 #endif
     , shared_controlmutex() // Throws
+    , shared_flushmutex()   // Throws
 {
     durability = static_cast<uint16_t>(dura); // durability level is fixed from creation
     REALM_ASSERT(!util::int_cast_has_overflow<decltype(history_type)>(ht + 0));
@@ -615,8 +842,8 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
                   std::is_same<decltype(daemon_started), uint8_t>::value &&
                   offsetof(SharedInfo, daemon_ready) == 42 &&
                   std::is_same<decltype(daemon_ready), uint8_t>::value &&
-                  offsetof(SharedInfo, filler_1) == 43 &&
-                  std::is_same<decltype(filler_1), uint8_t>::value &&
+                  offsetof(SharedInfo, group_commit) == 43 &&
+                  std::is_same<decltype(group_commit), uint8_t>::value &&
                   offsetof(SharedInfo, history_schema_version) == 44 &&
                   std::is_same<decltype(history_schema_version), uint16_t>::value &&
                   offsetof(SharedInfo, filler_2) == 46 &&
@@ -630,101 +857,6 @@ SharedGroup::SharedInfo::SharedInfo(Durability dura, Replication::HistoryType ht
 }
 
 
-namespace {
-
-#ifdef REALM_ASYNC_DAEMON
-
-void spawn_daemon(const std::string& file)
-{
-    // determine maximum number of open descriptors
-    errno = 0;
-    int m = int(sysconf(_SC_OPEN_MAX));
-    if (m < 0) {
-        if (errno) {
-            int err = errno; // Eliminate any risk of clobbering
-            throw std::runtime_error(get_errno_msg("'sysconf(_SC_OPEN_MAX)' failed: ", err));
-        }
-        throw std::runtime_error("'sysconf(_SC_OPEN_MAX)' failed with no reason");
-    }
-
-    int pid = fork();
-    if (0 == pid) { // child process:
-
-        // close all descriptors:
-        int i;
-        for (i = m - 1; i >= 0; --i)
-            close(i);
-#ifdef REALM_ENABLE_LOGFILE
-        // FIXME: Do we want to always open the log file? Should it be configurable?
-        i = ::open((file + ".log").c_str(), O_RDWR | O_CREAT | O_APPEND | O_SYNC, S_IRWXU);
-#else
-        i = ::open("/dev/null", O_RDWR);
-#endif
-        if (i >= 0) {
-            int j = dup(i);
-            static_cast<void>(j);
-        }
-#ifdef REALM_ENABLE_LOGFILE
-        std::cerr << "Detaching" << std::endl;
-#endif
-        // detach from current session:
-        setsid();
-
-        // start commit daemon executable
-        // Note that getenv (which is not thread safe) is called in a
-        // single threaded context. This is ensured by the fork above.
-        const char* async_daemon = getenv("REALM_ASYNC_DAEMON");
-        if (!async_daemon) {
-#ifndef REALM_DEBUG
-            async_daemon = REALM_INSTALL_LIBEXECDIR "/realmd";
-#else
-            async_daemon = REALM_INSTALL_LIBEXECDIR "/realmd-dbg";
-#endif
-        }
-        execl(async_daemon, async_daemon, file.c_str(), static_cast<char*>(0));
-
-// if we continue here, exec has failed so return error
-// if exec succeeds, we don't come back here.
-#if REALM_ANDROID
-        _exit(1);
-#else
-        _Exit(1);
-#endif
-        // child process ends here
-    }
-    else if (pid > 0) { // parent process, fork succeeded:
-
-        // use childs exit code to catch and report any errors:
-        int status;
-        int pid_changed;
-        do {
-            pid_changed = waitpid(pid, &status, 0);
-        } while (pid_changed == -1 && errno == EINTR);
-        if (pid_changed != pid) {
-            std::cerr << "Waitpid returned pid = " << pid_changed << " and status = " << std::hex << status
-                      << std::endl;
-            throw std::runtime_error("call to waitpid failed");
-        }
-        if (!WIFEXITED(status))
-            throw std::runtime_error("failed starting async commit (exit)");
-        if (WEXITSTATUS(status) == 1) {
-            // FIXME: Or `ld` could not find a required shared library
-            throw std::runtime_error("async commit daemon not found");
-        }
-        if (WEXITSTATUS(status) == 2)
-            throw std::runtime_error("async commit daemon failed");
-        if (WEXITSTATUS(status) == 3)
-            throw std::runtime_error("wrong db given to async daemon");
-    }
-    else { // Parent process, fork failed!
-
-        throw std::runtime_error("Failed to spawn async commit");
-    }
-}
-#endif
-
-
-} // anonymous namespace
 
 #if REALM_HAVE_STD_FILESYSTEM
 std::string SharedGroupOptions::sys_tmp_dir = std::filesystem::temp_directory_path().u8string();
@@ -770,6 +902,9 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
     m_lockfile_path = path + ".lock";
     try_make_dir(m_coordination_dir);
     m_key = options.encryption_key;
+    m_temp_dir = options.temp_dir;
+    m_compaction_budget = options.compaction_budget;
+    m_compaction_threshold = options.compaction_threshold;
     m_lockfile_prefix = m_coordination_dir + "/access_control";
     SlabAlloc& alloc = m_group.m_alloc;
 
@@ -783,12 +918,25 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
     Replication::HistoryType openers_hist_type = Replication::hist_None;
     int openers_hist_schema_version = 0;
     bool opener_is_sync_agent = false;
+    bool group_commit = options.enable_group_commit && options.durability == Durability::Full;
     if (Replication* repl = m_group.get_replication()) {
         openers_hist_type = repl->get_history_type();
         openers_hist_schema_version = repl->get_history_schema_version();
         opener_is_sync_agent = repl->is_sync_agent();
     }
 
+    if (options.durability == Durability::Log) {
+        // The write-ahead log consists of the changesets recorded for the
+        // history, and it is not encrypted
+        if (openers_hist_type == Replication::hist_None)
+            throw LogicError(LogicError::no_history);
+        if (options.encryption_key)
+            throw std::runtime_error("Durability::Log is not supported for encrypted Realms");
+        m_log.open(path); // Throws
+        m_log_checkpoint_size = options.log_checkpoint_size;
+    }
+    bool replay_log_needed = false;
+
     int current_file_format_version;
     int target_file_format_version;
     int stored_hist_schema_version = -1; // Signals undetermined
@@ -978,6 +1126,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
         m_balancemutex.set_shared_part(info->shared_balancemutex, m_lockfile_prefix, "balance");
 #endif
         m_controlmutex.set_shared_part(info->shared_controlmutex, m_lockfile_prefix, "control");
+        m_flushmutex.set_shared_part(info->shared_flushmutex, m_lockfile_prefix, "flush");
 
         // even though fields match wrt alignment and size, there may still be incompatibilities
         // between implementations, so lets ask one of the mutexes if it thinks it'll work.
@@ -1025,6 +1174,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             cfg.clear_file = (options.durability == Durability::MemOnly && begin_new_session);
 
             cfg.encryption_key = options.encryption_key;
+            cfg.huge_pages = options.enable_huge_pages;
             ref_type top_ref;
             try {
                 top_ref = alloc.attach_file(path, cfg); // Throws
@@ -1039,6 +1189,11 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             // compact()). This could render the mappings (partially) undefined.
             SlabAlloc::DetachGuard alloc_detach_guard(alloc);
 
+#if REALM_METRICS
+            if (m_metrics)
+                m_metrics->set_page_size(alloc.get_effective_page_size());
+#endif // REALM_METRICS
+
             // Determine target file format version for session (upgrade
             // required if greater than file format version of attached file).
             using gf = _impl::GroupFriend;
@@ -1047,7 +1202,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             bool file_format_ok = false;
             // In shared mode (Realm file opened via a SharedGroup instance) this
             // version of the core library is able to open Realms using file format
-            // versions from 2 to 9. Please see Group::get_file_format_version() for
+            // versions from 2 to 10. Please see Group::get_file_format_version() for
             // information about the individual file format versions.
             switch (current_file_format_version) {
                 case 0:
@@ -1061,6 +1216,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 case 7:
                 case 8:
                 case 9:
+                case 10:
                     file_format_ok = true;
                     break;
             }
@@ -1144,10 +1300,43 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 info->number_of_versions = 1;
 
                 info->latest_version_number = version;
+                info->latest_top_ref = top_ref;
+
+                // Group commit is only meaningful when commits are flushed
+                info->group_commit = uint8_t(group_commit);
+                info->durable_version = version;
+                info->num_group_commits = 0;
+                info->num_group_flushes = 0;
+
+                info->max_unflushed_versions =
+                    uint16_t(std::min(std::max(options.max_unflushed_versions, 1u), 0xFFFFu));
+                info->max_flush_delay_ms = uint32_t(std::max(options.max_flush_delay_ms, 1u));
+
+                info->max_retained_versions = options.max_retained_versions;
+                info->max_retained_bytes = options.max_retained_bytes;
+                info->max_pinned_age_ms = uint32_t(options.max_pinned_age_ms);
+                info->num_invalidated_versions = 0;
 
                 SharedInfo* r_info = m_reader_map.get_addr();
                 size_t file_size = alloc.get_baseline();
                 r_info->init_versioning(top_ref, file_size, version);
+
+                if (options.durability == Durability::Log) {
+                    // Changesets of versions that were committed during a
+                    // previous session, but did not make it into the Realm
+                    // file, are replayed once this session is set up. Until
+                    // then, other participants must wait to write.
+                    std::map<version_type, std::string> changesets;
+                    m_log.read_changesets(version, changesets); // Throws
+                    if (changesets.empty()) {
+                        for (int i = 0; i < _impl::WriteAheadLog::num_segments; ++i)
+                            m_log.truncate(i); // Throws
+                    }
+                    else {
+                        info->log_replay_pending = 1;
+                        replay_log_needed = true;
+                    }
+                }
             }
             else { // Not the session initiator
                 // Durability setting must be consistent across a session. An
@@ -1157,11 +1346,18 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 if (Durability(info->durability) != options.durability)
                     throw LogicError(LogicError::mixed_durability);
 
+                // Likewise for group commit, as all participants must take
+                // part in the flushing
+                if (bool(info->group_commit) != group_commit)
+                    throw LogicError(LogicError::mixed_group_commit);
+
                 // History type must be consistent across a session. An
                 // inconsistency is a logic error, as the user is required to
                 // make sure that all possible concurrent session participants
-                // use the same history type for the same Realm file.
-                if (info->history_type != openers_hist_type)
+                // use the same history type for the same Realm file. The
+                // thread that flushes the file with Durability::Async does not
+                // use the history, and therefore does not have one.
+                if (!is_backend && info->history_type != openers_hist_type)
                     throw LogicError(LogicError::mixed_history_type);
 
                 // History schema version must be consistent across a
@@ -1169,7 +1365,7 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 // required to make sure that all possible concurrent session
                 // participants use the same history schema version for the same
                 // Realm file.
-                if (info->history_schema_version != openers_hist_schema_version)
+                if (!is_backend && info->history_schema_version != openers_hist_schema_version)
                     throw LogicError(LogicError::mixed_history_schema_version);
 #ifdef _WIN32
                 uint64_t pid = GetCurrentProcessId();
@@ -1227,30 +1423,38 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
                 m_work_to_do.set_shared_part(info->work_to_do, m_lockfile_prefix, "work_ready", options.temp_dir);
                 m_room_to_write.set_shared_part(info->room_to_write, m_lockfile_prefix, "allow_write",
                                                 options.temp_dir);
-                // In async mode, we need to make sure the daemon is running and ready:
-                if (!is_backend) {
-                    while (info->daemon_ready == 0) {
-                        if (info->daemon_started == 0) {
-                            spawn_daemon(path);
-                            info->daemon_started = 1;
-                        }
-                        // FIXME: It might be more robust to sleep a little, then restart the loop
-                        // std::cerr << "Waiting for daemon" << std::endl;
-                        m_daemon_becomes_ready.wait(m_controlmutex, 0);
-                        // std::cerr << " - notified" << std::endl;
-                    }
-                }
             }
-// std::cerr << "daemon should be ready" << std::endl;
 #endif // REALM_ASYNC_DAEMON
 
             // Set initial version so we can track if other instances
             // change the db
             m_read_lock.m_version = get_version_of_latest_snapshot();
 
+            m_change_subscriber_fds.assign(SharedInfo::max_change_subscribers, {0, -1}); // Throws
+
+            // Keep the change notification descriptor across compact()
+            if (m_change_fd != -1)
+                register_change_subscriber(); // Throws
+
             // make our presence noted:
             ++info->num_participants;
 
+#ifdef REALM_ASYNC_DAEMON
+            // In async mode, we need to make sure that the Realm file is being
+            // flushed in the background. The flushing thread joins the session
+            // as another participant, so this must be done after our presence
+            // is noted, or it would think that it begins a new session.
+            if (options.durability == Durability::Async && !is_backend) {
+                try {
+                    start_async_commits(); // Throws
+                }
+                catch (...) {
+                    --info->num_participants;
+                    throw;
+                }
+            }
+#endif // REALM_ASYNC_DAEMON
+
             if (opener_is_sync_agent) {
                 REALM_ASSERT(!info->sync_agent_present);
                 info->sync_agent_present = 1; // Set to true
@@ -1272,10 +1476,9 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
 // std::cerr << "open completed" << std::endl;
 
 #ifdef REALM_ASYNC_DAEMON
-    if (options.durability == Durability::Async) {
-        if (is_backend) {
-            do_async_commits();
-        }
+    if (is_backend) {
+        do_async_commits(); // Throws
+        return;
     }
 #else
     static_cast<void>(is_backend);
@@ -1299,9 +1502,13 @@ void SharedGroup::do_open(const std::string& path, bool no_create_file, bool is_
             // the stored file format version is zero regardless of the version
             // of the core library used.
             gf::set_file_format_version(m_group, target_file_format_version);
+            if (replay_log_needed)
+                replay_log(); // Throws
         }
         else {
             gf::set_file_format_version(m_group, current_file_format_version);
+            if (replay_log_needed)
+                replay_log(); // Throws
             upgrade_file_format(options.allow_file_format_upgrade, target_file_format_version,
                                 stored_hist_schema_version, openers_hist_schema_version); // Throws
         }
@@ -1324,7 +1531,20 @@ bool SharedGroup::compact()
     if (m_transact_stage != transact_Ready) {
         throw std::runtime_error(m_db_path + ": compact is not supported whithin a transaction");
     }
+#ifdef REALM_ASYNC_DAEMON
+    // The thread that flushes the Realm file with Durability::Async is a
+    // session participant of its own, so it must be stopped. If compaction
+    // is not possible, it is started again by the next write transaction.
+    if (m_async_commit_thread.joinable())
+        stop_async_commits(); // Throws
+#endif
     Durability dura;
+    bool group_commit;
+    unsigned int max_flush_delay_ms;
+    unsigned int max_unflushed_versions;
+    uint64_t max_retained_versions;
+    uint64_t max_retained_bytes;
+    unsigned int max_pinned_age_ms;
     std::string tmp_path = m_db_path + ".tmp_compaction_space";
     {
         SharedInfo* info = m_file_map.get_addr();
@@ -1370,6 +1590,12 @@ bool SharedGroup::compact()
         }
         end_read();
         dura = Durability(info->durability);
+        group_commit = (info->group_commit != 0);
+        max_flush_delay_ms = info->max_flush_delay_ms;
+        max_unflushed_versions = info->max_unflushed_versions;
+        max_retained_versions = info->max_retained_versions;
+        max_retained_bytes = info->max_retained_bytes;
+        max_pinned_age_ms = info->max_pinned_age_ms;
         // We need to release any shared mapping *before* releasing the control mutex.
         // When someone attaches to the new database file, they *must* *not* see and
         // reuse any existing memory mapping of the stale file.
@@ -1387,6 +1613,16 @@ bool SharedGroup::compact()
     new_options.durability = dura;
     new_options.encryption_key = m_key;
     new_options.allow_file_format_upgrade = false;
+    new_options.enable_group_commit = group_commit;
+    new_options.log_checkpoint_size = m_log_checkpoint_size;
+    new_options.max_flush_delay_ms = max_flush_delay_ms;
+    new_options.max_unflushed_versions = max_unflushed_versions;
+    new_options.temp_dir = m_temp_dir;
+    new_options.compaction_budget = m_compaction_budget;
+    new_options.compaction_threshold = m_compaction_threshold;
+    new_options.max_retained_versions = max_retained_versions;
+    new_options.max_retained_bytes = max_retained_bytes;
+    new_options.max_pinned_age_ms = max_pinned_age_ms;
     do_open(m_db_path, true, false, new_options);
     return true;
 }
@@ -1398,6 +1634,114 @@ uint_fast64_t SharedGroup::get_number_of_versions()
     return info->number_of_versions;
 }
 
+std::vector<SharedGroup::RetainedVersion> SharedGroup::get_retained_versions()
+{
+    if (m_transact_stage == transact_Writing)
+        throw LogicError(LogicError::wrong_transact_state);
+
+    // Entries are only taken out of the ring buffer, and reused, by writers
+    std::lock_guard<InterprocessMutex> lock(m_writemutex); // Throws
+    SharedInfo* r_info = m_reader_map.get_addr();
+    if (grow_reader_mapping(r_info->readers.get_num_entries())) // Throws
+        r_info = m_reader_map.get_addr();
+    const Ringbuffer& readers = r_info->readers;
+
+    std::vector<const Ringbuffer::ReadCount*> entries;
+    for (const auto* r = &readers.get_oldest(); r != &readers.get_last(); r = &readers.get(r->next))
+        entries.push_back(r); // Throws
+
+    // Walk backwards, so that the space freed by the later commits can be
+    // accumulated
+    std::vector<RetainedVersion> versions;
+    uint64_t now = steady_clock_now();
+    uint_fast64_t retained_bytes = 0;
+    for (auto i = entries.rbegin(); i != entries.rend(); ++i) {
+        const Ringbuffer::ReadCount& r = **i;
+        const Ringbuffer::ReadCount& next = readers.get(r.next);
+        retained_bytes += next.released_bytes;
+        uint_fast32_t num_readers = r.get_num_readers();
+        if (num_readers == 0)
+            continue; // Not in use
+        uint_fast64_t pinned_age_ms = now > next.commit_time ? (now - next.commit_time) / 1000000 : 0;
+        versions.push_back({r.version, num_readers, pinned_age_ms, retained_bytes}); // Throws
+    }
+    std::reverse(versions.begin(), versions.end());
+    return versions;
+}
+
+uint_fast64_t SharedGroup::get_number_of_invalidated_versions()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+    return info->num_invalidated_versions;
+}
+
+bool SharedGroup::is_read_lock_invalidated()
+{
+    if (m_transact_stage != transact_Reading)
+        return false;
+    grow_reader_mapping(m_read_lock.m_reader_idx); // Throws
+    SharedInfo* r_info = m_reader_map.get_addr();
+    const Ringbuffer::ReadCount& r = r_info->readers.get(m_read_lock.m_reader_idx);
+    return r.is_invalidated(m_read_lock.m_reader_shard);
+}
+
+void SharedGroup::enforce_retention_policy(version_type new_version)
+{
+    m_invalidated_versions.clear();
+    SharedInfo* info = m_file_map.get_addr();
+    uint_fast64_t max_versions = info->max_retained_versions;
+    uint_fast64_t max_bytes = info->max_retained_bytes;
+    uint_fast64_t max_age = uint_fast64_t(info->max_pinned_age_ms) * 1000000;
+    if (max_versions == 0 && max_bytes == 0 && max_age == 0)
+        return;
+
+    // The caller has mapped the entire ring buffer
+    SharedInfo* r_info = m_reader_map.get_addr();
+    Ringbuffer& readers = r_info->readers;
+    uint64_t now = steady_clock_now();
+    for (;;) {
+        // The policy only ever applies to the oldest version in use, because
+        // the versions after it retain fewer versions and bytes, and have been
+        // pinned for a shorter time
+        readers.cleanup();
+        const Ringbuffer::ReadCount& oldest = readers.get_oldest();
+        if (&oldest == &readers.get_last())
+            break;
+        const Ringbuffer::ReadCount& next = readers.get(oldest.next);
+        bool violated = (max_versions != 0 && new_version - oldest.version + 1 > max_versions);
+        if (!violated && max_age != 0)
+            violated = (now > next.commit_time && now - next.commit_time > max_age);
+        if (!violated && max_bytes != 0) {
+            uint_fast64_t retained_bytes = 0;
+            for (const auto* r = &next;; r = &readers.get(r->next)) {
+                retained_bytes += r->released_bytes;
+                if (r == &readers.get_last())
+                    break;
+            }
+            violated = (retained_bytes > max_bytes);
+        }
+        if (!violated)
+            break;
+
+        uint_fast32_t num_readers = oldest.get_num_readers();
+        if (num_readers == 0)
+            continue; // Released in the meantime, so cleanup() can take it
+        m_invalidated_versions.emplace_back(oldest.version, num_readers); // Throws
+        readers.invalidate_oldest();
+    }
+}
+
+void SharedGroup::report_invalidated_versions()
+{
+    std::vector<std::pair<version_type, uint_fast32_t>> versions;
+    versions.swap(m_invalidated_versions);
+    if (m_invalidation_callback) {
+        for (const auto& version : versions)
+            m_invalidation_callback(version.first, version.second); // Throws
+    }
+}
+
 SharedGroup::~SharedGroup() noexcept
 {
     close();
@@ -1406,6 +1750,13 @@ SharedGroup::~SharedGroup() noexcept
 void SharedGroup::close() noexcept
 {
     close_internal(std::unique_lock<InterprocessMutex>(m_controlmutex, std::defer_lock));
+
+    // compact() reopens through close_internal(), and keeps the descriptor
+    if (m_change_fd != -1) {
+        close_change_fd(m_change_fd);
+        m_change_fd = -1;
+        File::try_remove(get_change_fifo_path(m_change_subscriber_id));
+    }
 }
 
 void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexcept
@@ -1425,6 +1776,16 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
     }
     m_group.detach();
     set_transact_stage(transact_Ready);
+#ifdef REALM_ASYNC_DAEMON
+    // Other session participants take over the flushing when they next write
+    if (m_async_commit_thread.joinable()) {
+        try {
+            stop_async_commits(); // Throws
+        }
+        catch (...) {
+        } // ignored on purpose.
+    }
+#endif
     SharedInfo* info = m_file_map.get_addr();
     {
         bool is_sync_agent = false;
@@ -1434,6 +1795,21 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
         if (!lock.owns_lock())
             lock.lock();
 
+        // The last participant of a session with Durability::Log makes the
+        // Realm file durable, so that the next session does not have to
+        // replay the write-ahead log. If that fails, the next session will.
+        if (info->num_participants == 1 && m_log.is_open() && !info->log_replay_pending &&
+            m_group.m_alloc.is_attached()) {
+            try {
+                GroupWriter::commit_top_ref(m_group.m_alloc.get_file(), ref_type(info->latest_top_ref),
+                                            info->file_format_version); // Throws
+                for (int i = 0; i < _impl::WriteAheadLog::num_segments; ++i)
+                    m_log.truncate(i); // Throws
+            }
+            catch (...) {
+            } // ignored on purpose.
+        }
+
         if (m_group.m_alloc.is_attached())
             m_group.m_alloc.detach();
 
@@ -1442,6 +1818,7 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
             info->sync_agent_present = 0; // Set to false
         }
 
+        unregister_change_subscriber();
         --info->num_participants;
         bool end_of_session = info->num_participants == 0;
         // std::cerr << "closing" << std::endl;
@@ -1469,6 +1846,11 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
 #endif
     m_new_commit_available.close();
     m_pick_next_writer.close();
+    for (auto& subscriber : m_change_subscriber_fds) {
+        if (subscriber.second != -1)
+            close_change_fd(subscriber.second);
+    }
+    m_change_subscriber_fds.clear();
 
     // On Windows it is important that we unmap before unlocking, else a SetEndOfFile() call from another thread may
     // interleave which is not permitted on Windows. It is permitted on *nix.
@@ -1477,6 +1859,7 @@ void SharedGroup::close_internal(std::unique_lock<InterprocessMutex> lock) noexc
     m_file.unlock();
     // info->~SharedInfo(); // DO NOT Call destructor
     m_file.close();
+    m_log.close();
 }
 
 bool SharedGroup::has_changed()
@@ -1510,6 +1893,128 @@ void SharedGroup::enable_wait_for_change()
     m_wait_for_change_enabled = true;
 }
 
+
+int SharedGroup::get_change_notification_fd()
+{
+#ifndef _WIN32
+    REALM_ASSERT(is_attached());
+    if (m_change_fd != -1)
+        return m_change_fd;
+
+    // The id must be unique among the subscribers of the session, as it names
+    // the pipe
+    static std::atomic<uint32_t> next_id(0);
+    uint_fast64_t id = (uint_fast64_t(getpid()) << 32) | ++next_id;
+    std::string path = get_change_fifo_path(id);
+    if (mkfifo(path.c_str(), 0600) == -1 && errno != EEXIST)
+        throw std::system_error(errno, std::system_category(), path);
+    int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+        int err = errno;
+        File::try_remove(path);
+        throw std::system_error(err, std::system_category(), path);
+    }
+    m_change_fd = fd;
+    m_change_subscriber_id = id;
+    try {
+        SharedInfo* info = m_file_map.get_addr();
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+        register_change_subscriber();                            // Throws
+        // Do not miss the commits made since the last transaction
+        if (m_read_lock.m_version != info->latest_version_number)
+            signal_change_fd(fd);
+    }
+    catch (...) {
+        close_change_fd(fd);
+        m_change_fd = -1;
+        File::try_remove(path);
+        throw;
+    }
+    return fd;
+#else
+    throw std::runtime_error("Change notification descriptors are not supported on this platform");
+#endif
+}
+
+
+bool SharedGroup::consume_change_notification()
+{
+    REALM_ASSERT(m_change_fd != -1);
+#ifndef _WIN32
+    char buffer[64];
+    while (::read(m_change_fd, buffer, sizeof buffer) > 0) {
+    }
+#endif
+    return has_changed();
+}
+
+
+std::string SharedGroup::get_change_fifo_path(uint_fast64_t id) const
+{
+    return m_lockfile_prefix + ".change." + std::to_string(id);
+}
+
+
+void SharedGroup::register_change_subscriber()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    for (uint64_t& subscriber : info->change_subscribers) {
+        if (subscriber == 0) {
+            subscriber = m_change_subscriber_id;
+            ++info->num_change_subscribers;
+            return;
+        }
+    }
+    throw std::runtime_error(m_db_path + ": Too many change notification descriptors");
+}
+
+
+void SharedGroup::unregister_change_subscriber() noexcept
+{
+    if (m_change_fd == -1)
+        return;
+    SharedInfo* info = m_file_map.get_addr();
+    for (uint64_t& subscriber : info->change_subscribers) {
+        if (subscriber == m_change_subscriber_id) {
+            subscriber = 0;
+            --info->num_change_subscribers;
+            return;
+        }
+    }
+}
+
+
+void SharedGroup::notify_change_subscribers() noexcept
+{
+#ifndef _WIN32
+    SharedInfo* info = m_file_map.get_addr();
+    if (info->num_change_subscribers == 0)
+        return;
+    for (int i = 0; i < SharedInfo::max_change_subscribers; ++i) {
+        uint_fast64_t id = info->change_subscribers[i];
+        std::pair<uint_fast64_t, int>& subscriber = m_change_subscriber_fds[i];
+        if (subscriber.first != id) {
+            if (subscriber.second != -1)
+                close_change_fd(subscriber.second);
+            subscriber = {id, -1};
+            if (id != 0) {
+                // Open the pipe for reading too, so that writing to it never
+                // raises SIGPIPE, even if the subscriber has died. If the
+                // subscriber is gone, there is nobody to notify.
+                try {
+                    std::string path = get_change_fifo_path(id); // Throws
+                    subscriber.second = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+                }
+                catch (...) {
+                }
+            }
+        }
+        if (subscriber.second != -1)
+            signal_change_fd(subscriber.second);
+    }
+#endif
+}
+
 void SharedGroup::set_transact_stage(SharedGroup::TransactStage stage) noexcept
 {
 #if REALM_METRICS
@@ -1518,21 +2023,32 @@ void SharedGroup::set_transact_stage(SharedGroup::TransactStage stage) noexcept
         size_t free_space = m_free_space;
         size_t num_objects = m_group.m_total_rows;
         size_t num_available_versions = static_cast<size_t>(get_number_of_versions());
+        size_t translation_hits = m_group.m_alloc.get_translation_hits();
+        size_t translation_misses = m_group.m_alloc.get_translation_misses();
 
         if (stage == transact_Reading) {
             if (m_transact_stage == transact_Writing) {
-                m_metrics->end_write_transaction(total_size, free_space, num_objects, num_available_versions);
+                m_metrics->end_write_transaction(total_size, free_space, num_objects, num_available_versions,
+                                                 translation_hits, translation_misses);
             }
             m_metrics->start_read_transaction();
         } else if (stage == transact_Writing) {
             if (m_transact_stage == transact_Reading) {
-                m_metrics->end_read_transaction(total_size, free_space, num_objects, num_available_versions);
+                m_metrics->end_read_transaction(total_size, free_space, num_objects, num_available_versions,
+                                                translation_hits, translation_misses);
             }
             m_metrics->start_write_transaction();
+            m_metrics->report_lock_wait_time(m_write_lock_wait_time);
         } else if (stage == transact_Ready) {
-            m_metrics->end_read_transaction(total_size, free_space, num_objects, num_available_versions);
-            m_metrics->end_write_transaction(total_size, free_space, num_objects, num_available_versions);
+            m_metrics->end_read_transaction(total_size, free_space, num_objects, num_available_versions,
+                                            translation_hits, translation_misses);
+            m_metrics->end_write_transaction(total_size, free_space, num_objects, num_available_versions,
+                                             translation_hits, translation_misses);
         }
+        // The translations done while beginning a transaction are counted
+        // toward it, so the counters are only reset when one ends
+        if (m_transact_stage != transact_Ready)
+            m_group.m_alloc.reset_translation_stats();
     }
 #endif
 
@@ -1540,9 +2056,85 @@ void SharedGroup::set_transact_stage(SharedGroup::TransactStage stage) noexcept
 }
 
 #ifdef REALM_ASYNC_DAEMON
+void SharedGroup::start_async_commits()
+{
+    SharedInfo* info = m_file_map.get_addr();
+
+    // A thread started earlier by this SharedGroup may have exited on its own
+    // after a failure.
+    if (m_async_commit_error) {
+        m_async_commit_thread.join(); // Throws
+        m_async_commit_error = nullptr;
+    }
+
+    while (info->daemon_ready == 0) {
+        if (info->daemon_started == 0) {
+            if (m_async_commit_thread.joinable())
+                m_async_commit_thread.join(); // Throws
+            m_async_commit_thread.start([this] { run_async_commits(); }); // Throws
+            info->daemon_started = 1;
+        }
+        m_daemon_becomes_ready.wait(m_controlmutex, 0);
+        if (m_async_commit_error) {
+            m_async_commit_thread.join(); // Throws
+            std::exception_ptr error = m_async_commit_error;
+            m_async_commit_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+
+void SharedGroup::stop_async_commits()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    m_balancemutex.lock(); // Throws
+    info->daemon_stop = 1;
+    m_work_to_do.notify();
+    m_balancemutex.unlock();
+
+    m_async_commit_thread.join(); // Throws
+    m_async_commit_error = nullptr;
+
+    m_balancemutex.lock(); // Throws
+    info->daemon_stop = 0;
+    m_balancemutex.unlock();
+}
+
+
+void SharedGroup::run_async_commits() noexcept
+{
+    try {
+        // The thread has a SharedGroup of its own, which participates in the
+        // session like any other, but never binds the Group accessor to a
+        // snapshot.
+        SharedGroup committer((unattached_tag()));
+        SharedGroupOptions options;
+        options.durability = Durability::Async;
+        options.encryption_key = m_key;
+        options.allow_file_format_upgrade = false;
+        options.temp_dir = m_temp_dir;
+        bool no_create = true;
+        bool is_backend = true;
+        committer.do_open(m_db_path, no_create, is_backend, options); // Throws
+    }
+    catch (...) {
+        // Let the SharedGroup that started the thread know, and let another
+        // one start a new thread, if this one got as far as becoming ready.
+        SharedInfo* info = m_file_map.get_addr();
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex);
+        m_async_commit_error = std::current_exception();
+        info->daemon_started = 0;
+        info->daemon_ready = 0;
+        m_daemon_becomes_ready.notify_all();
+    }
+}
+
+
 void SharedGroup::do_async_commits()
 {
     bool shutdown = false;
+    bool stop = false;
     SharedInfo* info = m_file_map.get_addr();
 
     // We always want to keep a read lock on the last version
@@ -1555,7 +2147,7 @@ void SharedGroup::do_async_commits()
     // we must treat version and version_index the same way:
     {
         std::lock_guard<InterprocessMutex> lock(m_controlmutex);
-        info->free_write_slots = max_write_slots;
+        info->free_write_slots = info->max_unflushed_versions;
         info->daemon_ready = 1;
         m_daemon_becomes_ready.notify_all();
     }
@@ -1572,18 +2164,21 @@ void SharedGroup::do_async_commits()
         }
 
         bool is_same;
+        uint64_t grab_time;
         ReadLockInfo next_read_lock = m_read_lock;
         {
-            // detect if we're the last "client", and if so, shutdown (must be under lock):
+            // detect if we have been asked to stop, and if so, whether we have
+            // caught up (must be under lock):
             std::lock_guard<InterprocessMutex> lock2(m_writemutex);
             std::lock_guard<InterprocessMutex> lock(m_controlmutex);
             version_type old_version = next_read_lock.m_version;
             VersionID version_id = VersionID(); // Latest available snapshot
             grab_read_lock(next_read_lock, version_id);
+            grab_time = steady_clock_now();
             is_same = (next_read_lock.m_version == old_version);
-            if (is_same && (shutdown || info->num_participants == 1)) {
+            if (is_same && (shutdown || stop)) {
 #ifdef REALM_ENABLE_LOGFILE
-                std::cerr << "Daemon exiting nicely" << std::endl << std::endl;
+                std::cerr << "Async commits exiting nicely" << std::endl << std::endl;
 #endif
                 release_read_lock(next_read_lock);
                 release_read_lock(m_read_lock);
@@ -1599,11 +2194,19 @@ void SharedGroup::do_async_commits()
             std::cerr << "Syncing from version " << m_read_lock.m_version << " to " << next_read_lock.m_version
                       << std::endl;
 #endif
-            GroupWriter writer(m_group);
-            writer.commit(next_read_lock.m_top_ref);
+            // The Group accessor is detached, so the file header is updated
+            // directly
+            GroupWriter::commit_top_ref(m_group.m_alloc.get_file(), next_read_lock.m_top_ref,
+                                        info->file_format_version); // Throws
 #ifdef REALM_ENABLE_LOGFILE
             std::cerr << "..and Done" << std::endl;
 #endif
+            // Versions committed after the read lock was grabbed are still
+            // unflushed
+            std::lock_guard<InterprocessMutex> lock(m_controlmutex);
+            info->durable_version = next_read_lock.m_version;
+            bool caught_up = (info->latest_version_number == next_read_lock.m_version);
+            info->oldest_unflushed_commit_time = (caught_up ? 0 : grab_time);
         }
 
         // Now we can release the version that was previously commited
@@ -1616,20 +2219,21 @@ void SharedGroup::do_async_commits()
         // We have caught up with the writers, let them know that there are
         // now free write slots, wakeup any that has been suspended.
         uint16_t free_write_slots = info->free_write_slots;
-        info->free_write_slots = max_write_slots;
+        info->free_write_slots = info->max_unflushed_versions;
         if (free_write_slots <= 0) {
             m_room_to_write.notify_all();
         }
 
         // If we have plenty of write slots available, relax and wait a bit before syncing
-        if (free_write_slots > relaxed_sync_threshold) {
+        stop = (info->daemon_stop != 0);
+        if (!stop && free_write_slots > info->max_unflushed_versions / 2) {
             timespec ts;
             timeval tv;
             // clock_gettime(CLOCK_REALTIME, &ts); <- would like to use this, but not there on mac
             gettimeofday(&tv, nullptr);
-            ts.tv_sec = tv.tv_sec;
-            ts.tv_nsec = tv.tv_usec * 1000;
-            ts.tv_nsec += 10000000;         // 10 msec
+            uint64_t delay_nsec = uint64_t(info->max_flush_delay_ms) * 1000000;
+            ts.tv_sec = tv.tv_sec + time_t(delay_nsec / 1000000000);
+            ts.tv_nsec = tv.tv_usec * 1000 + long(delay_nsec % 1000000000);
             if (ts.tv_nsec >= 1000000000) { // overflow
                 ts.tv_nsec -= 1000000000;
                 ts.tv_sec += 1;
@@ -1637,6 +2241,7 @@ void SharedGroup::do_async_commits()
 
             // no timeout support if the condvars are only emulated, so this will assert
             m_work_to_do.wait(m_balancemutex, &ts);
+            stop = (info->daemon_stop != 0);
         }
         m_balancemutex.unlock();
     }
@@ -1747,12 +2352,19 @@ void SharedGroup::release_read_lock(ReadLockInfo& read_lock) noexcept
     grow_reader_mapping(read_lock.m_reader_idx);
     SharedInfo* r_info = m_reader_map.get_addr();
     const Ringbuffer::ReadCount& r = r_info->readers.get(read_lock.m_reader_idx);
-    atomic_double_dec(r.count); // <-- most of the exec time spent here
+    r.unlock(read_lock.m_reader_shard); // <-- most of the exec time spent here
 }
 
 
 void SharedGroup::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
 {
+    grab_read_lock(read_lock, version_id, get_reader_shard()); // Throws
+}
+
+
+void SharedGroup::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id, uint_fast32_t shard)
+{
+    read_lock.m_reader_shard = shard;
     if (version_id.version == std::numeric_limits<version_type>::max()) {
         for (;;) {
             SharedInfo* r_info = m_reader_map.get_addr();
@@ -1765,7 +2377,7 @@ void SharedGroup::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
             const Ringbuffer::ReadCount& r = r_info->readers.get(read_lock.m_reader_idx);
             // if the entry is stale and has been cleared by the cleanup process,
             // we need to start all over again. This is extremely unlikely, but possible.
-            if (!atomic_double_inc_if_even(r.count)) // <-- most of the exec time spent here!
+            if (!r.try_lock(shard)) // <-- most of the exec time spent here!
                 continue;
             read_lock.m_version = r.version;
             read_lock.m_top_ref = to_size_t(r.current_top);
@@ -1786,7 +2398,7 @@ void SharedGroup::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
 
         // if the entry is stale and has been cleared by the cleanup process,
         // the requested version is no longer available
-        while (!atomic_double_inc_if_even(r.count)) { // <-- most of the exec time spent here!
+        while (!r.try_lock(shard)) { // <-- most of the exec time spent here!
             // we failed to lock the version. This could be because the version
             // is being cleaned up, but also because the cleanup is probing for access
             // to it. If it's being probed, the tail ptr of the ringbuffer will point
@@ -1798,7 +2410,7 @@ void SharedGroup::grab_read_lock(ReadLockInfo& read_lock, VersionID version_id)
         // we managed to lock an entry in the ringbuffer, but it may be so old that
         // the version doesn't match the specific request. In that case we must release and fail
         if (r.version != version_id.version) {
-            atomic_double_dec(r.count); // <-- release
+            r.unlock(shard); // <-- release
             throw BadVersion();
         }
         read_lock.m_version = r.version;
@@ -1928,6 +2540,13 @@ SharedGroup::version_type SharedGroup::commit()
     do_end_read();
     m_read_lock = lock_after_commit;
     set_transact_stage(transact_Ready);
+
+    if (m_file_map.get_addr()->group_commit)
+        flush_group_commit(new_version); // Throws
+    if (m_log_checkpoint_due)
+        checkpoint_log(); // Throws
+    if (!m_invalidated_versions.empty())
+        report_invalidated_versions(); // Throws
     return new_version;
 }
 
@@ -1959,12 +2578,16 @@ void SharedGroup::rollback() noexcept
 SharedGroup::VersionID SharedGroup::pin_version()
 {
     REALM_ASSERT(m_transact_stage != transact_Ready);
+    if (is_read_lock_invalidated()) // Throws
+        throw ReadLockInvalidated();
 
     // Get current version
     VersionID version_id(m_read_lock.m_version, m_read_lock.m_reader_idx);
 
+    // The pin may be released by a different thread, and the token does not
+    // record the shard, so pins always go through the first one
     ReadLockInfo read_lock;
-    grab_read_lock(read_lock, version_id); // Throws
+    grab_read_lock(read_lock, version_id, 0); // Throws
 
     return version_id;
 }
@@ -2016,9 +2639,15 @@ bool SharedGroup::do_try_begin_write()
     // In the non-blocking case, we will only succeed if there is no contention for
     // the write mutex. For this case we are trivially fair and can ignore the
     // fairness machinery.
+#if REALM_METRICS
+    MetricTimer lock_timer;
+#endif // REALM_METRICS
     bool got_the_lock = m_writemutex.try_lock();
     if (got_the_lock) {
         finish_begin_write();
+#if REALM_METRICS
+        m_write_lock_wait_time = lock_timer.get_elapsed_time();
+#endif // REALM_METRICS
     }
     return got_the_lock;
 }
@@ -2026,6 +2655,9 @@ bool SharedGroup::do_try_begin_write()
 
 void SharedGroup::do_begin_write()
 {
+#if REALM_METRICS
+    MetricTimer lock_timer;
+#endif // REALM_METRICS
     SharedInfo* info = m_file_map.get_addr();
 
     // Get write lock - the write lock is held until do_end_write().
@@ -2084,6 +2716,9 @@ void SharedGroup::do_begin_write()
     // should take this situation into account by comparing with '>' instead of '!='
     info->next_served = my_ticket;
     finish_begin_write();
+#if REALM_METRICS
+    m_write_lock_wait_time = lock_timer.get_elapsed_time();
+#endif // REALM_METRICS
 }
 
 void SharedGroup::finish_begin_write()
@@ -2094,17 +2729,52 @@ void SharedGroup::finish_begin_write()
         throw std::runtime_error("Crash of other process detected, session restart required");
     }
 
+    if (info->log_replay_pending && !m_log_replaying) {
+        // The session initiator has yet to replay the write-ahead log
+        m_writemutex.unlock();
+        bool replay_failed;
+        {
+            std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+            while (info->log_replay_pending && !info->log_replay_failed)
+                m_new_commit_available.wait(m_controlmutex, 0);
+            replay_failed = (info->log_replay_failed != 0);
+        }
+        if (replay_failed)
+            throw std::runtime_error("Replay of write-ahead log failed, session restart required");
+        m_writemutex.lock(); // Throws
+    }
+
 #ifdef REALM_ASYNC_DAEMON
     if (info->durability == static_cast<uint16_t>(Durability::Async)) {
 
+        // If the SharedGroup that flushed the Realm file in the background has
+        // been closed, this one takes over
+        if (info->daemon_ready == 0) {
+            try {
+                std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+                start_async_commits();                                   // Throws
+            }
+            catch (...) {
+                m_writemutex.unlock();
+                throw;
+            }
+        }
+
         m_balancemutex.lock(); // Throws
 
-        // if we are running low on write slots, kick the sync daemon
-        if (info->free_write_slots < relaxed_sync_threshold)
+        // if we are running low on write slots, kick the flushing thread
+        if (info->free_write_slots < info->max_unflushed_versions / 2)
             m_work_to_do.notify();
-        // if we are out of write slots, wait for the sync daemon to catch up
+        // if we are out of write slots, wait for the flushing thread to catch
+        // up. It needs the write mutex to do so.
         while (info->free_write_slots <= 0) {
-            m_room_to_write.wait(m_balancemutex, 0);
+            m_writemutex.unlock();
+            while (info->free_write_slots <= 0) {
+                m_room_to_write.wait(m_balancemutex, 0);
+            }
+            m_balancemutex.unlock();
+            m_writemutex.lock();   // Throws
+            m_balancemutex.lock(); // Throws
         }
 
         info->free_write_slots--;
@@ -2133,11 +2803,30 @@ Replication::version_type SharedGroup::do_commit()
     version_type current_version = r_info->get_current_version_unchecked();
     version_type new_version = current_version + 1;
     if (Replication* repl = m_group.get_replication()) {
+#if REALM_METRICS
+        std::unique_ptr<MetricTimer> history_timer = Metrics::report_history_write_time(m_group);
+#endif // REALM_METRICS
+
+        // With Durability::Log, the changeset is captured for the write-ahead
+        // log while it is still available, that is, before the commit
+        // operation is initiated.
+        bool log_changeset = (m_log.is_open() && !m_log_replaying);
+        if (log_changeset) {
+            BinaryData changeset = get_history()->get_uncommitted_changes();
+            char* record_data = m_log.prepare_record(changeset.size()); // Throws
+            std::copy(changeset.data(), changeset.data() + changeset.size(), record_data);
+        }
+
         // If Replication::prepare_commit() fails, then the entire transaction
         // fails. The application then has the option of terminating the
         // transaction with a call to SharedGroup::rollback(), which in turn
         // must call Replication::abort_transact().
         new_version = repl->prepare_commit(current_version); // Throws
+        if (log_changeset)
+            m_log.finalize_record(new_version);
+#if REALM_METRICS
+        history_timer.reset();
+#endif // REALM_METRICS
         try {
             low_level_commit(new_version); // Throws
         }
@@ -2181,6 +2870,12 @@ SharedGroup::version_type SharedGroup::commit_and_continue_as_read()
 
     set_transact_stage(transact_Reading);
 
+    if (m_file_map.get_addr()->group_commit)
+        flush_group_commit(version); // Throws
+    if (m_log_checkpoint_due)
+        checkpoint_log(); // Throws
+    if (!m_invalidated_versions.empty())
+        report_invalidated_versions(); // Throws
     return version;
 }
 
@@ -2225,21 +2920,124 @@ SharedGroup::version_type SharedGroup::get_version_of_latest_snapshot()
         // now (double) increment the read count so that no-one cleans up the entry
         // while we read it.
         const Ringbuffer::ReadCount& r = r_info->readers.get(index);
-        if (!atomic_double_inc_if_even(r.count)) {
+        uint_fast32_t shard = get_reader_shard();
+        if (!r.try_lock(shard)) {
 
             continue;
         }
         version_type version = r.version;
         // release the entry again:
-        atomic_double_dec(r.count);
+        r.unlock(shard);
         return version;
     }
 }
 
 
+void SharedGroup::flush_group_commit(version_type version)
+{
+    SharedInfo* info = m_file_map.get_addr();
+
+    // Writers that commit while a flush is in progress queue up here. The first
+    // of them flushes on behalf of all of them, and the rest find that their
+    // versions have become durable in the meantime.
+    std::lock_guard<InterprocessMutex> flush_lock(m_flushmutex); // Throws
+    version_type latest_version;
+    ref_type latest_top_ref;
+    {
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+        if (info->durable_version >= version)
+            return;
+        latest_version = info->latest_version_number;
+        latest_top_ref = ref_type(info->latest_top_ref);
+    }
+
+    GroupWriter::commit_top_ref(m_group.m_alloc.get_file(), latest_top_ref,
+                                info->file_format_version); // Throws
+
+    std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+    info->durable_version = latest_version;
+    ++info->num_group_flushes;
+}
+
+
+void SharedGroup::get_group_commit_stats(uint_fast64_t& num_commits, uint_fast64_t& num_flushes)
+{
+    SharedInfo* info = m_file_map.get_addr();
+    std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+    num_commits = info->num_group_commits;
+    num_flushes = info->num_group_flushes;
+}
+
+
+void SharedGroup::replay_log()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    m_log_replaying = true;
+    try {
+        WriteTransaction wt(*this); // Throws
+        std::map<version_type, std::string> changesets;
+        m_log.read_changesets(m_read_lock.m_version, changesets); // Throws
+        for (const auto& entry : changesets) {
+            _impl::SimpleNoCopyInputStream in(entry.second.data(), entry.second.size());
+            Replication::apply_changeset(in, wt.get_group()); // Throws
+        }
+        wt.commit(); // Throws
+    }
+    catch (...) {
+        m_log_replaying = false;
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex);
+        info->log_replay_failed = 1;
+        m_new_commit_available.notify_all();
+        throw;
+    }
+    m_log_replaying = false;
+}
+
+
+void SharedGroup::checkpoint_log()
+{
+    SharedInfo* info = m_file_map.get_addr();
+    m_log_checkpoint_due = false;
+
+    std::unique_lock<InterprocessMutex> flush_lock(m_flushmutex, std::try_to_lock); // Throws
+    if (!flush_lock.owns_lock())
+        return;
+
+    // Let further commits go to the other segment. It is empty unless a
+    // previous checkpoint failed part way, in which case its records are
+    // simply appended to, and covered by a later checkpoint.
+    int segment;
+    version_type version;
+    ref_type top_ref;
+    {
+        std::lock_guard<InterprocessMutex> write_lock(m_writemutex); // Throws
+        segment = info->log_active_segment;
+        if (info->log_end[segment] < m_log_checkpoint_size)
+            return; // Somebody else got there first
+        info->log_active_segment = uint8_t(1 - segment);
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+        version = info->latest_version_number;
+        top_ref = ref_type(info->latest_top_ref);
+    }
+
+    // All versions logged in the old segment are now made durable in the
+    // Realm file, after which the segment is no longer needed
+    GroupWriter::commit_top_ref(m_group.m_alloc.get_file(), top_ref,
+                                info->file_format_version); // Throws
+    {
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+        info->durable_version = version;
+    }
+    m_log.truncate(segment); // Throws
+    info->log_end[segment] = 0;
+}
+
+
 void SharedGroup::low_level_commit(uint_fast64_t new_version)
 {
     SharedInfo* info = m_file_map.get_addr();
+    bool group_commit = (info->group_commit != 0);
+    bool write_ahead_log = (Durability(info->durability) == Durability::Log);
 
     // Version of oldest snapshot currently (or recently) bound in a transaction
     // of the current session.
@@ -2254,6 +3052,7 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
             r_info = m_reader_map.get_addr();
         }
         r_info->readers.cleanup();
+        enforce_retention_policy(new_version); // Throws
         const Ringbuffer::ReadCount& rc = r_info->readers.get_oldest();
         oldest_version = rc.version;
 
@@ -2263,6 +3062,16 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
             hist->set_oldest_bound_version(oldest_version); // Throws
     }
 
+    // With group commit or Durability::Log, the file header may still select
+    // an older version than the oldest bound snapshot. The space used by that
+    // version must not be reused until a later version has been made durable,
+    // or a crash could leave the file header pointing to overwritten data.
+    uint_fast64_t oldest_version_to_keep = oldest_version;
+    if (group_commit || write_ahead_log) {
+        std::lock_guard<InterprocessMutex> lock(m_controlmutex); // Throws
+        oldest_version_to_keep = std::min(oldest_version, uint_fast64_t(info->durable_version));
+    }
+
     // Do the actual commit
     REALM_ASSERT(m_group.m_top.is_attached());
     REALM_ASSERT(oldest_version <= new_version);
@@ -2272,26 +3081,54 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
 #endif // REALM_METRICS
     // info->readers.dump();
     GroupWriter out(m_group); // Throws
-    out.set_versions(new_version, oldest_version);
+    out.set_versions(new_version, oldest_version_to_keep);
+    out.set_compaction(m_compaction_budget, m_compaction_threshold);
     // Recursively write all changed arrays to end of file
     ref_type new_top_ref = out.write_group(); // Throws
     m_free_space = out.get_free_space();
     m_used_space = out.get_file_size() - m_free_space;
+    size_t released_bytes = out.get_released_bytes();
     // std::cout << "Writing version " << new_version << ", Topptr " << new_top_ref
     //     << " Read lock at version " << oldest_version << std::endl;
     switch (Durability(info->durability)) {
         case Durability::Full:
-            out.commit(new_top_ref); // Throws
+            // With group commit, the flush is done by flush_group_commit()
+            // after the write mutex has been released.
+            if (!group_commit)
+                out.commit(new_top_ref); // Throws
+            break;
+        case Durability::Log:
+            if (m_log_replaying) {
+                // The replayed changesets are now durable in the Realm file,
+                // and the log can start over
+                out.commit(new_top_ref); // Throws
+                for (int i = 0; i < _impl::WriteAheadLog::num_segments; ++i) {
+                    m_log.truncate(i); // Throws
+                    info->log_end[i] = 0;
+                }
+                info->log_active_segment = 0;
+            }
+            else {
+                // The Realm file is made durable later by checkpoint_log()
+                int segment = info->log_active_segment;
+                info->log_end[segment] = m_log.append_record(segment, info->log_end[segment]); // Throws
+                m_log_checkpoint_due = (info->log_end[segment] >= m_log_checkpoint_size);
+            }
             break;
         case Durability::MemOnly:
-        case Durability::Async:
             // In Durability::MemOnly mode, we just use the file as backing for
             // the shared memory. So we never actually flush the data to disk
             // (the OS may do so opportinisticly, or when swapping). So in this
             // mode the file on disk may very likely be in an invalid state.
             break;
+        case Durability::Async:
+            // The Realm file is flushed later by do_async_commits()
+            break;
     }
     size_t new_file_size = out.get_file_size();
+#if REALM_METRICS
+    std::unique_ptr<MetricTimer> notify_timer = Metrics::report_notify_time(m_group);
+#endif // REALM_METRICS
     // Update reader info. If this fails in any way, the ringbuffer may be corrupted.
     // This can lead to other readers seing invalid data which is likely to cause them
     // to crash. Other writers *must* be prevented from writing any further updates
@@ -2315,6 +3152,8 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
         r.current_top = new_top_ref;
         r.filesize = new_file_size;
         r.version = new_version;
+        r.commit_time = steady_clock_now();
+        r.released_bytes = released_bytes;
         r_info->readers.use_next();
     }
     // At this point, the ringbuffer has been succesfully updated, and the next writer
@@ -2323,9 +3162,29 @@ void SharedGroup::low_level_commit(uint_fast64_t new_version)
     {
         std::lock_guard<InterprocessMutex> lock(m_controlmutex);
         info->number_of_versions = new_version - oldest_version + 1;
+        info->num_invalidated_versions += m_invalidated_versions.size();
         info->latest_version_number = new_version;
+        info->latest_top_ref = new_top_ref;
+        if (group_commit)
+            ++info->num_group_commits;
+        if (m_log_replaying) {
+            info->durable_version = new_version;
+            info->log_replay_pending = 0;
+        }
+        if (Durability(info->durability) == Durability::Async) {
+            uint64_t now = steady_clock_now();
+            if (info->oldest_unflushed_commit_time == 0)
+                info->oldest_unflushed_commit_time = now;
+#if REALM_METRICS
+            if (m_metrics) {
+                double lag = double(now - info->oldest_unflushed_commit_time) / 1e9;
+                m_metrics->report_flush_lag(size_t(new_version - info->durable_version), lag);
+            }
+#endif // REALM_METRICS
+        }
 
         m_new_commit_available.notify_all();
+        notify_change_subscribers();
     }
 }
 
@@ -2410,5 +3269,12 @@ std::vector<std::pair<std::string, bool>> SharedGroup::get_core_files(const std:
     std::vector<std::pair<std::string, bool>> files;
     files.emplace_back(std::make_pair(realm_path, false));
     files.emplace_back(std::make_pair(realm_path + ".management", true));
+    // The write-ahead log only exists if the Realm has been used with
+    // Durability::Log
+    for (int i = 0; i < _impl::WriteAheadLog::num_segments; ++i) {
+        std::string log_path = realm_path + ".wal." + std::to_string(i);
+        if (File::exists(log_path))
+            files.emplace_back(std::make_pair(log_path, false));
+    }
     return files;
 }
@@ -19,8 +19,10 @@
 #ifndef REALM_GROUP_SHARED_HPP
 #define REALM_GROUP_SHARED_HPP
 
+#include <exception>
 #include <functional>
 #include <limits>
+#include <vector>
 #include <realm/util/features.h>
 #include <realm/util/thread.hpp>
 #include <realm/util/interprocess_condvar.hpp>
@@ -29,6 +31,7 @@
 #include <realm/group_shared_options.hpp>
 #include <realm/handover_defs.hpp>
 #include <realm/impl/transact_log.hpp>
+#include <realm/impl/write_ahead_log.hpp>
 #include <realm/metrics/metrics.hpp>
 #include <realm/replication.hpp>
 #include <realm/version_id.hpp>
@@ -271,6 +274,29 @@ public:
 
     /// re-enable waiting for change
     void enable_wait_for_change();
+
+    /// Get a file descriptor that becomes readable when the database is
+    /// changed, for use with poll(), epoll or select() in an event loop,
+    /// instead of blocking a thread in wait_for_change(). Commits made by any
+    /// session participant, in this or other processes, make it readable. It
+    /// becomes readable right away if the database has changed since this
+    /// SharedGroup last started a transaction. Only the processes that have
+    /// asked for a descriptor are woken by commits.
+    ///
+    /// The descriptor is owned by the SharedGroup, and remains valid until the
+    /// SharedGroup is closed. Calling this function again returns the same
+    /// descriptor. When it is readable, call consume_change_notification().
+    ///
+    /// Throws std::runtime_error if too many SharedGroups in the session have
+    /// a descriptor, or on Windows, which is not supported. Throws
+    /// std::system_error if the named pipe behind it cannot be created next to
+    /// the lock file.
+    int get_change_notification_fd();
+
+    /// Make the descriptor returned by get_change_notification_fd() unreadable
+    /// until the next commit, and return has_changed(). Commits made after
+    /// this call are never missed, but a notification may be spurious.
+    bool consume_change_notification();
     // Transactions:
 
     using version_type = _impl::History::version_type;
@@ -280,6 +306,12 @@ public:
     /// bound (or tethered) snapshot.
     struct BadVersion;
 
+    /// Thrown by advance_read(), promote_to_write() and pin_version() if the
+    /// snapshot bound by the current read transaction has been invalidated by
+    /// the version retention policy (see
+    /// SharedGroupOptions::max_retained_versions).
+    struct ReadLockInvalidated;
+
     /// \defgroup group_shared_transactions
     //@{
 
@@ -390,6 +422,38 @@ public:
     /// a read transaction will not immediately release any versions.
     uint_fast64_t get_number_of_versions();
 
+    /// A version that is kept alive by read transactions or pinned versions,
+    /// even though it is no longer the latest. `retained_bytes` is the amount
+    /// of space that has been freed by later commits, and which can therefore
+    /// not be reused until this version, and any older ones, are released.
+    /// `pinned_age_ms` is the time since the version was superseded.
+    struct RetainedVersion {
+        version_type version;
+        uint_fast32_t num_read_locks;
+        uint_fast64_t pinned_age_ms;
+        uint_fast64_t retained_bytes;
+    };
+
+    /// Report the versions that are kept alive by read locks, oldest first.
+    /// This waits for any write transaction in progress to end, so it must not
+    /// be called while this SharedGroup is in a write transaction.
+    std::vector<RetainedVersion> get_retained_versions();
+
+    /// Report the number of versions that have been invalidated by the version
+    /// retention policy in the current session.
+    uint_fast64_t get_number_of_invalidated_versions();
+
+    /// Returns true if the snapshot bound by the current read transaction has
+    /// been invalidated by the version retention policy. The transaction must
+    /// then be ended.
+    bool is_read_lock_invalidated();
+
+    /// Report the number of commits, and the number of times the file was
+    /// flushed to stable storage to make them durable, in the current session
+    /// with group commit (SharedGroupOptions::enable_group_commit). Each flush
+    /// involves two fsyncs. Both numbers are zero without group commit.
+    void get_group_commit_stats(uint_fast64_t& num_commits, uint_fast64_t& num_flushes);
+
     /// Compact the database file.
     /// - The method will throw if called inside a transaction.
     /// - The method will throw if called in unattached state.
@@ -554,6 +618,7 @@ private:
     struct ReadLockInfo {
         uint_fast64_t m_version = std::numeric_limits<version_type>::max();
         uint_fast32_t m_reader_idx = 0;
+        uint_fast32_t m_reader_shard = 0;
         ref_type m_top_ref = 0;
         size_t m_file_size = 0;
     };
@@ -574,23 +639,55 @@ private:
     std::string m_db_path;
     std::string m_coordination_dir;
     const char* m_key;
+    std::string m_temp_dir;
+    // See SharedGroupOptions::compaction_budget
+    size_t m_compaction_budget = 0;
+    double m_compaction_threshold = 0;
     TransactStage m_transact_stage;
     util::InterprocessMutex m_writemutex;
 #ifdef REALM_ASYNC_DAEMON
     util::InterprocessMutex m_balancemutex;
 #endif
     util::InterprocessMutex m_controlmutex;
+    util::InterprocessMutex m_flushmutex;
 #ifdef REALM_ASYNC_DAEMON
     util::InterprocessCondVar m_room_to_write;
     util::InterprocessCondVar m_work_to_do;
     util::InterprocessCondVar m_daemon_becomes_ready;
+
+    // With Durability::Async, the thread that flushes the Realm file in the
+    // background, if this SharedGroup started it, and the exception it
+    // failed with, if any.
+    util::Thread m_async_commit_thread;
+    std::exception_ptr m_async_commit_error;
 #endif
     util::InterprocessCondVar m_new_commit_available;
     util::InterprocessCondVar m_pick_next_writer;
     std::function<void(int, int)> m_upgrade_callback;
 
+    // See SharedGroupOptions::invalidation_callback. The versions invalidated
+    // by the latest commit are reported once the write lock is released.
+    std::function<void(uint_fast64_t, uint_fast32_t)> m_invalidation_callback;
+    std::vector<std::pair<version_type, uint_fast32_t>> m_invalidated_versions;
+
+    // The change notification descriptor (see get_change_notification_fd()),
+    // and the id under which it is registered in SharedInfo. When committing,
+    // the other subscribers are notified through descriptors opened on demand
+    // and cached here by slot, along with the id they were opened for.
+    int m_change_fd = -1;
+    uint_fast64_t m_change_subscriber_id = 0;
+    std::vector<std::pair<uint_fast64_t, int>> m_change_subscriber_fds;
+
+    // With Durability::Log
+    _impl::WriteAheadLog m_log;
+    size_t m_log_checkpoint_size = 0;
+    bool m_log_replaying = false;
+    bool m_log_checkpoint_due = false;
+
 #if REALM_METRICS
     std::shared_ptr<metrics::Metrics> m_metrics;
+    // Time spent acquiring the write lock for the current write transaction
+    double m_write_lock_wait_time = 0;
 #endif // REALM_METRICS
 
     void do_open(const std::string& file, bool no_create, bool is_backend, const SharedGroupOptions options);
@@ -620,12 +717,27 @@ private:
     /// this function fails. Also, why is it useful to promise anything about
     /// detection of bad versions? Can we really promise enough to make such a
     /// promise useful to the caller?
+    ///
+    /// The read lock is registered in the ringbuffer count shard of the
+    /// calling thread, unless a shard is specified.
     void grab_read_lock(ReadLockInfo&, VersionID);
+    void grab_read_lock(ReadLockInfo&, VersionID, uint_fast32_t shard);
 
     // Release a specific read lock. The read lock MUST have been obtained by a
     // call to grab_read_lock().
     void release_read_lock(ReadLockInfo&) noexcept;
 
+    // Invalidate the oldest read locks while they violate the version
+    // retention policy, and record the versions in m_invalidated_versions.
+    void enforce_retention_policy(version_type new_version);
+    void report_invalidated_versions();
+
+    std::string get_change_fifo_path(uint_fast64_t id) const;
+    // Must be called with the controlmutex held
+    void register_change_subscriber();
+    void unregister_change_subscriber() noexcept;
+    void notify_change_subscribers() noexcept;
+
     void do_begin_read(VersionID, bool writable);
     void do_end_read() noexcept;
     /// return true if write transaction can commence, false otherwise.
@@ -650,7 +762,30 @@ private:
     // Must be called only by someone that has a lock on the write
     // mutex.
     void low_level_commit(uint_fast64_t new_version);
-
+    void flush_group_commit(version_type);
+
+    /// With Durability::Log, apply the changesets that a previous session
+    /// left in the write-ahead log, but not in the Realm file. Done by the
+    /// session initiator before other session participants may write.
+    void replay_log();
+
+    /// With Durability::Log, make the Realm file durable up to the latest
+    /// version, and empty the segment of the write-ahead log that holds the
+    /// changesets of that and earlier versions. Does nothing if another
+    /// checkpoint is in progress.
+    void checkpoint_log();
+
+    /// With Durability::Async, start the background thread that flushes the
+    /// Realm file, unless it is already running in this or another
+    /// SharedGroup, and wait until it is ready. Must be called with the
+    /// controlmutex locked.
+    void start_async_commits();
+
+    /// Let the background thread started by this SharedGroup flush the latest
+    /// version, and wait for it to exit.
+    void stop_async_commits();
+
+    void run_async_commits() noexcept;
     void do_async_commits();
 
     /// Upgrade file format and/or history schema
@@ -802,9 +937,17 @@ private:
 struct SharedGroup::BadVersion : std::exception {
 };
 
+struct SharedGroup::ReadLockInvalidated : std::exception {
+    const char* what() const noexcept override
+    {
+        return "Read transaction was invalidated by the version retention policy";
+    }
+};
+
 inline SharedGroup::SharedGroup(const std::string& file, bool no_create, const SharedGroupOptions options)
     : m_group(Group::shared_tag())
     , m_upgrade_callback(std::move(options.upgrade_callback))
+    , m_invalidation_callback(std::move(options.invalidation_callback))
 {
     open(file, no_create, options); // Throws
 }
@@ -817,6 +960,7 @@ inline SharedGroup::SharedGroup(unattached_tag) noexcept
 inline SharedGroup::SharedGroup(Replication& repl, const SharedGroupOptions options)
     : m_group(Group::shared_tag())
     , m_upgrade_callback(std::move(options.upgrade_callback))
+    , m_invalidation_callback(std::move(options.invalidation_callback))
 {
     open(repl, options); // Throws
 }
@@ -961,6 +1105,9 @@ inline void SharedGroup::advance_read(O* observer, VersionID version_id)
     if (!hist)
         throw LogicError(LogicError::no_history);
 
+    if (is_read_lock_invalidated()) // Throws
+        throw ReadLockInvalidated();
+
     do_advance_read(observer, version_id, *hist); // Throws
 }
 
@@ -976,6 +1123,10 @@ inline void SharedGroup::promote_to_write(O* observer)
 
     do_begin_write(); // Throws
     try {
+        // No read lock can be invalidated while the write lock is held
+        if (is_read_lock_invalidated()) // Throws
+            throw ReadLockInvalidated();
+
         VersionID version = VersionID();                                  // Latest
         bool history_updated = do_advance_read(observer, version, *hist); // Throws
 
@@ -1151,17 +1302,6 @@ public:
         sg.rollback_and_continue_as_read(obs); // Throws
     }
 
-    static void async_daemon_open(SharedGroup& sg, const std::string& file)
-    {
-        bool no_create = true;
-        bool is_backend = true;
-        SharedGroupOptions options;
-        options.durability = SharedGroupOptions::Durability::Async;
-        options.encryption_key = nullptr;
-        options.allow_file_format_upgrade = false;
-        sg.do_open(file, no_create, is_backend, options); // Throws
-    }
-
     static int get_file_format_version(const SharedGroup& sg) noexcept
     {
         return sg.get_file_format_version();
@@ -19,6 +19,8 @@
 #ifndef REALM_GROUP_SHARED_OPTIONS_HPP
 #define REALM_GROUP_SHARED_OPTIONS_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -31,7 +33,8 @@ struct SharedGroupOptions {
     enum class Durability : uint16_t {
         Full,
         MemOnly,
-        Async ///< Not yet supported on windows.
+        Async, ///< Commits are flushed in the background. Not yet supported on windows.
+        Log    ///< Commits append their changesets to a write-ahead log.
     };
 
     explicit SharedGroupOptions(Durability level = Durability::Full, const char* key = nullptr,
@@ -45,7 +48,16 @@ struct SharedGroupOptions {
         , upgrade_callback(file_upgrade_callback)
         , temp_dir(temp_directory)
         , enable_metrics(track_metrics)
-
+        , enable_huge_pages(false)
+        , enable_group_commit(false)
+        , log_checkpoint_size(default_log_checkpoint_size)
+        , max_flush_delay_ms(default_max_flush_delay_ms)
+        , max_unflushed_versions(default_max_unflushed_versions)
+        , compaction_budget(0)
+        , compaction_threshold(default_compaction_threshold)
+        , max_retained_versions(0)
+        , max_pinned_age_ms(0)
+        , max_retained_bytes(0)
     {
     }
 
@@ -56,10 +68,30 @@ struct SharedGroupOptions {
         , upgrade_callback(std::function<void(int, int)>())
         , temp_dir(sys_tmp_dir)
         , enable_metrics(false)
+        , enable_huge_pages(false)
+        , enable_group_commit(false)
+        , log_checkpoint_size(default_log_checkpoint_size)
+        , max_flush_delay_ms(default_max_flush_delay_ms)
+        , max_unflushed_versions(default_max_unflushed_versions)
+        , compaction_budget(0)
+        , compaction_threshold(default_compaction_threshold)
+        , max_retained_versions(0)
+        , max_pinned_age_ms(0)
+        , max_retained_bytes(0)
     {
     }
 
     /// The persistence level of the Realm file. See Durability.
+    ///
+    /// With Durability::Log, a commit writes its changes to the Realm file as
+    /// usual, but does not flush them to stable storage. Instead, it appends
+    /// the changeset of the transaction to a write-ahead log next to the Realm
+    /// file, and flushes only that. The Realm file is flushed in batches by
+    /// checkpoints, see \ref log_checkpoint_size. If the process crashes,
+    /// changes that were logged, but did not make it into the Realm file, are
+    /// replayed from the log when the Realm file is opened again. Requires a
+    /// history (Replication object), as that is where the changesets come
+    /// from, and is not supported for encrypted Realm files.
     Durability durability;
 
     /// The key to encrypt and decrypt the Realm file with, or nullptr to
@@ -95,6 +127,94 @@ struct SharedGroupOptions {
     /// A prerequisite is compiling with REALM_METRICS=ON.
     bool enable_metrics;
 
+    /// Place the mappings of the Realm file and the memory used for changes
+    /// in write transactions at addresses that allow them to be backed by
+    /// transparent huge pages, and advise the system to do so. This reduces
+    /// the number of TLB misses when large Realm files are scanned, at the
+    /// cost of some extra memory. It has no effect on systems that do not
+    /// support transparent huge pages (currently only Linux does), and it is
+    /// decided by the first SharedGroup that maps the file in this process
+    /// whether the file mappings are affected.
+    bool enable_huge_pages;
+
+    /// Let write transactions that commit at about the same time share the
+    /// flush of the Realm file to stable storage. A commit releases the write
+    /// lock as soon as its changes are visible to other SharedGroups, and then
+    /// waits until they are durable. One waiting committer flushes on behalf of
+    /// all commits made up to that point. commit() still returns only when the
+    /// changes are durable. Only has an effect with Durability::Full, and must
+    /// be the same for all SharedGroups that use the Realm file at the same time.
+    bool enable_group_commit;
+
+    /// With Durability::Log, the size that the active segment of the
+    /// write-ahead log must reach before a commit goes on to checkpoint it. A
+    /// checkpoint flushes the Realm file to stable storage and empties the
+    /// log. It happens after the committer has released the write lock, so
+    /// other writers can proceed in the meantime.
+    size_t log_checkpoint_size;
+
+    static constexpr size_t default_log_checkpoint_size = 4 * 1024 * 1024;
+
+    /// With Durability::Async, commits return as soon as their changes are
+    /// visible to other SharedGroups, and a background thread flushes the
+    /// Realm file to stable storage. The thread runs in the first process that
+    /// writes to the Realm file, and is handed over to another SharedGroup if
+    /// the one that started it is closed.
+    ///
+    ///  max_flush_delay_ms is the longest time the background thread waits
+    /// between flushes while writers are not falling behind. 
+    /// max_unflushed_versions is the number of write transactions that can be
+    /// started before their changes have been flushed. When it is reached,
+    /// further writers wait for the background thread to catch up, and when
+    /// half of it is reached, the thread is woken up early. Both are decided
+    /// by the SharedGroup that starts the session.
+    unsigned int max_flush_delay_ms;
+    unsigned int max_unflushed_versions;
+
+    static constexpr unsigned int default_max_flush_delay_ms = 10;
+    static constexpr unsigned int default_max_unflushed_versions = 100;
+
+    /// Compact the Realm file incrementally, as part of ordinary write
+    /// transactions. When more than \ref compaction_threshold of the file is
+    /// free space, each commit moves unmodified arrays from the end of the file
+    /// into free space closer to the beginning, until it has moved
+    /// compaction_budget bytes. The space they occupied is freed like that of
+    /// modified arrays, and becomes reusable when no reader uses the versions
+    /// that refer to it any longer. Unlike SharedGroup::compact(), this
+    /// requires no exclusive access to the file. Zero disables it.
+    size_t compaction_budget;
+
+    /// The fraction of the file that must be free space for commits to
+    /// compact the file. See \ref compaction_budget.
+    double compaction_threshold;
+
+    static constexpr double default_compaction_threshold = 0.5;
+
+    /// Bound how much old versions can be kept alive by read transactions and
+    /// pinned versions (SharedGroup::pin_version()) that are never ended. As
+    /// long as a version is in use, no space that it refers to can be reused,
+    /// so the file grows with every commit.
+    ///
+    /// When a commit finds that the oldest version in use is older than the
+    /// latest by more than max_retained_versions versions, has been superseded
+    /// by a newer version for more than max_pinned_age_ms milliseconds, or
+    /// keeps more than max_retained_bytes bytes of freed space from being
+    /// reused, it invalidates the read locks on that version, and lets the
+    /// space be reused. An invalidated read transaction must be ended. Its
+    /// accessors must not be used. advance_read(), promote_to_write() and
+    /// pin_version() throw SharedGroup::ReadLockInvalidated. The latest version
+    /// is never invalidated. Zero means no limit, which is the default. The
+    /// limits are decided by the SharedGroup that starts the session.
+    uint64_t max_retained_versions;
+    unsigned int max_pinned_age_ms;
+    uint64_t max_retained_bytes;
+
+    /// Optionally called by the committing SharedGroup, after the write lock
+    /// has been released, for every version invalidated by the limits above.
+    /// The parameters are the version and the number of read locks that were
+    /// held on it.
+    std::function<void(uint_fast64_t, uint_fast32_t)> invalidation_callback;
+
     /// sys_tmp_dir will be used if the temp_dir is empty when creating SharedGroupOptions.
     /// It must be writable and allowed to create pipe/fifo file on it.
     /// set_sys_tmp_dir is not a thread-safe call and it is only supposed to be called once
@@ -17,6 +17,8 @@
  **************************************************************************/
 
 #include <algorithm>
+#include <exception>
+#include <thread>
 
 #ifdef REALM_DEBUG
 #include <iostream>
@@ -24,9 +26,11 @@
 
 #include <realm/util/miscellaneous.hpp>
 #include <realm/util/safe_int_ops.hpp>
+#include <realm/util/thread.hpp>
 #include <realm/group_writer.hpp>
 #include <realm/group_shared.hpp>
 #include <realm/alloc_slab.hpp>
+#include <realm/impl/destroy_guard.hpp>
 #include <realm/disable_sync_to_disk.hpp>
 #include <realm/metrics/metric_timer.hpp>
 
@@ -158,8 +162,13 @@ GroupWriter::GroupWriter(Group& group)
     , m_free_lengths(m_alloc)
     , m_free_versions(m_alloc)
     , m_current_version(0)
+    , m_readlock_version(0)
 {
     m_map_windows.reserve(num_map_windows);
+    // Encrypted mappings must be sync'ed to get the data encrypted and written
+    // to the file at all
+    util::File& file = m_alloc.get_file();
+    m_use_writeback = util::File::is_writeback_supported() && !file.get_encryption_key();
 
     Array& top = m_group.m_top;
     bool is_shared = m_group.m_is_shared;
@@ -245,9 +254,59 @@ void GroupWriter::sync_all_mappings()
 {
     for (const auto& window : m_map_windows) {
         window->sync();
+        ++m_num_sync_calls;
     }
 }
 
+void GroupWriter::add_dirty_range(ref_type pos, size_t size)
+{
+    m_bytes_written += size;
+    if (!m_use_writeback)
+        return;
+    // Consecutive writes are mostly sequential, so extend the last range
+    // where possible to keep the list short
+    if (!m_dirty_ranges.empty()) {
+        auto& last = m_dirty_ranges.back();
+        if (last.first + last.second == pos) {
+            last.second += size;
+            return;
+        }
+    }
+    m_dirty_ranges.emplace_back(pos, size);
+}
+
+void GroupWriter::flush_dirty_ranges()
+{
+    if (!m_use_writeback) {
+        sync_all_mappings();
+        return;
+    }
+
+    util::File& file = m_alloc.get_file();
+    if (!m_dirty_ranges.empty()) {
+        std::sort(m_dirty_ranges.begin(), m_dirty_ranges.end());
+        size_t mask = util::page_size() - 1;
+        ref_type begin = m_dirty_ranges.front().first & ~mask;
+        ref_type end = begin;
+        for (const auto& range : m_dirty_ranges) {
+            ref_type range_begin = range.first & ~mask;
+            ref_type range_end = (range.first + range.second + mask) & ~mask;
+            if (range_begin > end) {
+                file.start_writeback(begin, end - begin); // Throws
+                ++m_num_sync_calls;
+                begin = range_begin;
+            }
+            end = std::max(end, range_end);
+        }
+        file.start_writeback(begin, end - begin); // Throws
+        ++m_num_sync_calls;
+        m_dirty_ranges.clear();
+    }
+
+    file.sync_data(); // Throws
+    ++m_num_sync_calls;
+}
+
 // Get a window matching a request, either creating a new window or reusing an
 // existing one (possibly extended to accomodate the new request). Maintain a
 // cache of open windows which are sync'ed and closed following a least recently
@@ -264,7 +323,10 @@ GroupWriter::MapWindow* GroupWriter::get_window(ref_type start_ref, size_t size)
     }
     // no window found, make room for a new one at the top
     if (m_map_windows.size() == num_map_windows) {
-        m_map_windows.back()->sync();
+        if (!m_use_writeback) {
+            m_map_windows.back()->sync();
+            ++m_num_sync_calls;
+        }
         m_map_windows.pop_back();
     }
     auto new_window = std::make_unique<MapWindow>(m_alloc.get_file(), start_ref, size);
@@ -278,12 +340,22 @@ ref_type GroupWriter::write_group()
     std::unique_ptr<MetricTimer> fsync_timer = Metrics::report_write_time(m_group);
 #endif // REALM_METRICS
 
-    merge_free_space(); // Throws
+#if REALM_METRICS
+    std::unique_ptr<MetricTimer> free_list_timer = Metrics::report_free_list_time(m_group);
+#endif // REALM_METRICS
+
+    read_in_freelist(); // Throws
+    trim_free_tail();   // Throws
+    if (m_compaction_budget != 0)
+        start_compaction();
+
+#if REALM_METRICS
+    free_list_timer.reset();
+    std::unique_ptr<MetricTimer> serialization_timer = Metrics::report_serialization_time(m_group);
+#endif // REALM_METRICS
 
     Array& top = m_group.m_top;
     bool is_shared = m_group.m_is_shared;
-    REALM_ASSERT_3(m_free_positions.size(), ==, m_free_lengths.size());
-    REALM_ASSERT(!is_shared || m_free_versions.size() == m_free_lengths.size());
 
     // Recursively write all changed arrays (but not 'top' and free-lists yet,
     // as they are going to change along the way.) If free space is available in
@@ -292,8 +364,16 @@ ref_type GroupWriter::write_group()
     // commit), as that would lead to clobbering of the previous database
     // version.
     bool deep = true, only_if_modified = true;
-    ref_type names_ref = m_group.m_table_names.write(*this, deep, only_if_modified); // Throws
-    ref_type tables_ref = m_group.m_tables.write(*this, deep, only_if_modified);     // Throws
+    ref_type names_ref;
+    ref_type tables_ref;
+    if (m_compaction_limit != 0) {
+        names_ref = write_and_relocate(m_group.m_table_names.get_ref()); // Throws
+        tables_ref = write_and_relocate(m_group.m_tables.get_ref());     // Throws
+    }
+    else {
+        names_ref = m_group.m_table_names.write(*this, deep, only_if_modified); // Throws
+        tables_ref = m_group.m_tables.write(*this, deep, only_if_modified);     // Throws
+    }
 
     int_fast64_t value_1 = from_ref(names_ref);
     int_fast64_t value_2 = from_ref(tables_ref);
@@ -310,19 +390,34 @@ ref_type GroupWriter::write_group()
         REALM_ASSERT(is_shared);
         if (ref_type history_ref = top.get_as_ref(8)) {
             Allocator& alloc = top.get_alloc();
-            ref_type new_history_ref = Array::write(history_ref, alloc, *this, only_if_modified); // Throws
+            ref_type new_history_ref;
+            if (m_compaction_limit != 0) {
+                new_history_ref = write_and_relocate(history_ref); // Throws
+            }
+            else {
+                new_history_ref = Array::write(history_ref, alloc, *this, only_if_modified); // Throws
+            }
             int_fast64_t value_3 = from_ref(new_history_ref);
             top.set(8, value_3); // Throws
         }
     }
 
+    // All changed arrays except for the ones written below have now been
+    // assigned a position, so they can be copied to the file
+    flush_deferred_writes(); // Throws
+
+#if REALM_METRICS
+    serialization_timer.reset();
+    free_list_timer = Metrics::report_free_list_time(m_group);
+#endif // REALM_METRICS
+
     // We now have a bit of a chicken-and-egg problem. We need to write the
     // free-lists to the file, but the act of writing them will consume free
     // space, and thereby change the free-lists. To solve this problem, we
     // calculate an upper bound on the amount af space required for all of the
     // remaining arrays and allocate the space as one big chunk. This way we can
     // finalize the free-lists before writing them to the file.
-    size_t max_free_list_size = m_free_positions.size();
+    size_t max_free_list_size = m_free_in_file.size();
 
     // We need to add to the free-list any space that was freed during the
     // current transaction, but to avoid clobering the previous version, we
@@ -366,9 +461,9 @@ ref_type GroupWriter::write_group()
     // maximum number that is required. This ensures that even if we end up
     // using the maximum size possible, we still do not end up with a zero size
     // free-space chunk as we deduct the actually used size from it.
-    std::pair<size_t, size_t> reserve = reserve_free_space(max_free_space_needed + 1); // Throws
-    size_t reserve_ndx = reserve.first;
-    size_t reserve_size = reserve.second;
+    FreeListElement reserve = reserve_free_space(max_free_space_needed + 1); // Throws
+    size_t reserve_pos = size_t(reserve->first);
+    size_t reserve_size = reserve->second.size;
     // At this point we have allocated all the space we need, so we can add to
     // the free-lists any free space created during the current transaction (or
     // since last commit). Had we added it earlier, we would have risked
@@ -378,35 +473,30 @@ ref_type GroupWriter::write_group()
     for (const auto& free_space : new_free_space) {
         ref_type ref = free_space.ref;
         size_t size = free_space.size;
-        // We always want to keep the list of free space in sorted order (by
-        // ascending position) to facilitate merge of adjacent segments. We
-        // can find the correct insert postion by binary search
-        size_t ndx = m_free_positions.lower_bound_int(ref);
-        if (ndx > 0) {
-            ref_type prev_ref = to_ref(m_free_positions.get(ndx - 1));
-            size_t prev_size = to_size_t(m_free_lengths.get(ndx - 1));
-            REALM_ASSERT_RELEASE_EX(prev_ref + prev_size <= ref, prev_ref, prev_size, ref, ndx, m_free_positions.size());
+        // The chunks released during the current transaction must not overlap
+        // any chunk that was already free
+        FreeListElement after = m_free_in_file.lower_bound(ref);
+        if (after != m_free_in_file.begin()) {
+            FreeListElement prev = std::prev(after);
+            REALM_ASSERT_RELEASE_EX(prev->first + prev->second.size <= ref, prev->first, prev->second.size, ref,
+                                    m_free_in_file.size());
         }
-        if (ndx < m_free_positions.size()) {
-            ref_type after_ref = to_ref(m_free_positions.get(ndx));
-            REALM_ASSERT_RELEASE_EX(ref + size <= after_ref, ref, size, after_ref, ndx, m_free_positions.size());
+        if (after != m_free_in_file.end()) {
+            REALM_ASSERT_RELEASE_EX(ref + size <= after->first, ref, size, after->first, m_free_in_file.size());
         }
-        m_free_positions.insert(ndx, ref); // Throws
-        m_free_lengths.insert(ndx, size);  // Throws
-        if (is_shared)
-            m_free_versions.insert(ndx, m_current_version); // Throws
-        // Adjust reserve_ndx if necessary
-        if (ndx <= reserve_ndx)
-            ++reserve_ndx;
+        insert_free_chunk(ref, size, m_current_version); // Throws
+        m_released_bytes += size;
     }
 
     // Before we calculate the actual sizes of the free-list arrays, we must
     // make sure that the final adjustments of the free lists (i.e., the
     // deduction of the actually used space from the reserved chunk,) will not
-    // change the byte-size of those arrays.
-    size_t reserve_pos = to_size_t(m_free_positions.get(reserve_ndx));
+    // change the byte-size of those arrays. The reserved chunk is therefore
+    // written with the largest position it can get, and with its current
+    // size, which is larger than the size it will get.
     REALM_ASSERT_3(reserve_size, >, max_free_space_needed);
     int_fast64_t value_4 = to_int64(reserve_pos + max_free_space_needed);
+    size_t reserve_ndx = write_freelist(reserve_pos, to_ref(value_4)); // Throws
 
 #if REALM_ENABLE_MEMDEBUG
     m_free_positions.m_no_relocation = true;
@@ -481,6 +571,16 @@ ref_type GroupWriter::write_group()
     // Write top
     write_array_at(window, top_ref, top.get_header(), top_byte_size); // Throws
     window->encryption_write_barrier(start_addr, used);
+    add_dirty_range(reserve_ref, used);
+
+#if REALM_METRICS
+    Metrics::report_write_io(m_group, m_bytes_written, m_arrays_written, m_num_sync_calls);
+    Metrics::report_bytes_relocated(m_group, m_bytes_relocated);
+#endif // REALM_METRICS
+    m_bytes_written = 0;
+    m_arrays_written = 0;
+    m_num_sync_calls = 0;
+
     // Return top_ref so that it can be saved in lock file used for coordination
     return top_ref;
 }
@@ -497,193 +597,356 @@ size_t GroupWriter::get_free_space() {
     }
 }
 
-void GroupWriter::merge_free_space()
+void GroupWriter::read_in_freelist()
 {
     bool is_shared = m_group.m_is_shared;
+    size_t n = m_free_lengths.size();
+    REALM_ASSERT_3(m_free_positions.size(), ==, n);
+    REALM_ASSERT(!is_shared || m_free_versions.size() == n);
 
-    if (m_free_lengths.is_empty())
-        return;
-
-    size_t n = m_free_lengths.size() - 1;
+    m_free_in_file.clear();
+    m_size_map.clear();
+    FreeListElement last = m_free_in_file.end();
     for (size_t i = 0; i < n; ++i) {
-        size_t i2 = i + 1;
-        size_t pos1 = to_size_t(m_free_positions.get(i));
-        size_t size1 = to_size_t(m_free_lengths.get(i));
-        size_t pos2 = to_size_t(m_free_positions.get(i2));
-        if (pos2 == pos1 + size1) {
-            // If this is a shared db, we can only merge
-            // segments where no part is currently in use
-            if (is_shared) {
-                size_t v1 = to_size_t(m_free_versions.get(i));
-                if (v1 >= m_readlock_version)
-                    continue;
-                size_t v2 = to_size_t(m_free_versions.get(i2));
-                if (v2 >= m_readlock_version)
-                    continue;
+        ref_type pos = to_ref(m_free_positions.get(i));
+        size_t size = to_size_t(m_free_lengths.get(i));
+        uint64_t version = is_shared ? uint64_t(m_free_versions.get(i)) : 0;
+
+        // Merge with the preceding chunk if they are adjacent. If this is a
+        // shared db, we can only merge segments where no part is currently in
+        // use.
+        if (last != m_free_in_file.end() && last->first + last->second.size == pos) {
+            FreeSpaceEntry entry{size, version};
+            if (is_allocatable(last->second) && is_allocatable(entry)) {
+                last->second.size += size;
+                continue;
             }
-
-            // FIXME: Performing a series of calls to Array::erase() is
-            // unnecessarily expensive because we have to shift the contents
-            // above i2 multiple times in general. A more efficient way would be
-            // to use assigments only, and then make a final call to
-            // Array::truncate() when the new size is know.
-
-            // Merge
-            size_t size2 = to_size_t(m_free_lengths.get(i2));
-            m_free_lengths.set(i, size1 + size2);
-            m_free_positions.erase(i2);
-            m_free_lengths.erase(i2);
-            if (is_shared)
-                m_free_versions.erase(i2);
-
-            --n;
-            --i; // May underflow, but that is ok
         }
+        // The free-lists are ordered by position, so the new chunk always goes
+        // at the end
+        last = m_free_in_file.emplace_hint(m_free_in_file.end(), pos, FreeSpaceEntry{size, version}); // Throws
+    }
+
+    for (const auto& chunk : m_free_in_file) {
+        if (is_allocatable(chunk.second))
+            m_size_map.emplace(chunk.second.size, chunk.first); // Throws
     }
 }
 
 
-size_t GroupWriter::get_free_space(size_t size)
+void GroupWriter::trim_free_tail()
 {
-    REALM_ASSERT_3(size % 8, ==, 0); // 8-byte alignment
+    if (m_free_in_file.empty())
+        return;
 
-    std::pair<size_t, size_t> p = reserve_free_space(size);
+    // read_in_freelist() has merged all adjacent chunks that are not in use,
+    // so the last chunk covers all of the free space at the end of the file
+    // that may be given back.
+    size_t logical_file_size = to_size_t(m_group.m_top.get(2) / 2);
+    FreeListElement last = std::prev(m_free_in_file.end());
+    size_t tail_pos = size_t(last->first);
+    size_t tail_size = last->second.size;
+    if (tail_pos + tail_size != logical_file_size || !is_allocatable(last->second))
+        return;
+    if (tail_size < logical_file_size / trim_min_fraction)
+        return;
 
-    bool is_shared = m_group.m_is_shared;
+    // The file must always end on a section boundary
+    size_t new_file_size = tail_pos + tail_pos / trim_headroom_fraction;
+    if (!m_alloc.matches_section_boundary(new_file_size))
+        new_file_size = m_alloc.get_upper_section_boundary(new_file_size);
+    if (new_file_size >= logical_file_size)
+        return;
+    REALM_ASSERT_3(new_file_size % 8, ==, 0);
 
-    // Claim space from identified chunk
-    size_t chunk_ndx = p.first;
-    size_t chunk_pos = to_size_t(m_free_positions.get(chunk_ndx));
-    size_t chunk_size = p.second;
-    REALM_ASSERT_3(chunk_size, >=, size);
-    REALM_ASSERT((chunk_size % 8) == 0);
+    uint64_t version = last->second.released_at_version;
+    erase_free_chunk(last);
+    if (new_file_size > tail_pos)
+        insert_free_chunk(tail_pos, new_file_size - tail_pos, version); // Throws
 
-    size_t rest = chunk_size - size;
-    if (rest > 0) {
-        // Allocating part of chunk - this alway happens from the beginning
-        // of the chunk. The call to reserve_free_space may split chunks
-        // in order to make sure that it returns a chunk from which allocation
-        // can be done from the beginning
-        m_free_positions.set(chunk_ndx, to_int64(chunk_pos + size));
-        m_free_lengths.set(chunk_ndx, to_int64(rest));
-    }
-    else {
-        // Allocating entire chunk
-        m_free_positions.erase(chunk_ndx);
-        m_free_lengths.erase(chunk_ndx);
-        if (is_shared)
-            m_free_versions.erase(chunk_ndx);
+    // Update the logical file size
+    m_group.m_top.set(2, 1 + 2 * uint64_t(new_file_size)); // Throws
+}
+
+
+void GroupWriter::start_compaction()
+{
+    m_compaction_limit = 0;
+    size_t logical_file_size = to_size_t(m_group.m_top.get(2) / 2);
+    size_t free_space = 0;
+    for (const auto& chunk : m_free_in_file)
+        free_space += chunk.second.size;
+    if (free_space == 0 || double(free_space) <= m_compaction_threshold * double(logical_file_size))
+        return;
+
+    // There is nothing to move if all of the space beyond the limit is free
+    // already
+    ref_type limit = logical_file_size - free_space;
+    size_t free_beyond_limit = 0;
+    auto i = m_free_in_file.lower_bound(limit);
+    if (i != m_free_in_file.begin())
+        --i;
+    for (; i != m_free_in_file.end(); ++i) {
+        ref_type begin = std::max(i->first, limit);
+        ref_type end = i->first + i->second.size;
+        if (end > begin)
+            free_beyond_limit += end - begin;
     }
-    REALM_ASSERT((chunk_pos % 8) == 0);
-    return chunk_pos;
+    if (free_beyond_limit == logical_file_size - limit)
+        return;
+
+    m_compaction_limit = limit;
+    m_relocation_budget_left = m_compaction_budget;
 }
 
 
-inline size_t GroupWriter::split_freelist_chunk(size_t index, size_t start_pos, size_t alloc_pos, size_t chunk_size,
-                                                bool is_shared)
+ref_type GroupWriter::write_and_relocate(ref_type ref)
 {
-    m_free_positions.insert(index, start_pos);
-    m_free_lengths.insert(index, alloc_pos - start_pos);
-    if (is_shared)
-        m_free_versions.insert(index, 0);
-    ++index;
-    m_free_positions.set(index, alloc_pos);
-    chunk_size = start_pos + chunk_size - alloc_pos;
-    m_free_lengths.set(index, chunk_size);
-    return chunk_size;
+    bool read_only = m_alloc.is_read_only(ref);
+    if (read_only && m_relocation_budget_left == 0)
+        return ref;
+
+    const char* header = m_alloc.translate(ref);
+    size_t byte_size = Array::get_byte_size_from_header(header);
+    bool relocate = read_only && ref >= m_compaction_limit && byte_size <= m_relocation_budget_left;
+    uint32_t dummy_checksum = 0x41414141UL; // "AAAA" in ASCII
+    ref_type new_ref;
+
+    if (!Array::get_hasrefs_from_header(header)) {
+        if (!read_only)
+            return write_persistent_array(header, byte_size, dummy_checksum); // Throws
+        if (!relocate)
+            return ref;
+        // Moving an array only helps if it can be placed below the limit
+        FreeListElement chunk = reserve_free_space_below(byte_size, m_compaction_limit); // Throws
+        if (chunk == m_free_in_file.end())
+            return ref;
+        size_t pos = claim_free_space(chunk, byte_size);                        // Throws
+        new_ref = defer_write(pos, header, byte_size, dummy_checksum, true); // Throws
+    }
+    else {
+        // Write the subtrees first, and then this array, if it is modified,
+        // to be moved, or any of the subtrees were written
+        Array array(m_alloc);
+        array.init_from_ref(ref);
+        size_t n = array.size();
+        std::vector<int_fast64_t> values;
+        values.reserve(n); // Throws
+        bool subtrees_written = false;
+        for (size_t i = 0; i < n; ++i) {
+            int_fast64_t value = array.get(i);
+            bool is_ref = (value != 0 && (value & 1) == 0);
+            if (is_ref) {
+                ref_type subref = to_ref(value);
+                ref_type new_subref = write_and_relocate(subref); // Throws
+                if (new_subref != subref) {
+                    value = from_ref(new_subref);
+                    subtrees_written = true;
+                }
+            }
+            values.push_back(value);
+        }
+        if (read_only && !subtrees_written && !relocate)
+            return ref;
+
+        Array new_array(Allocator::get_default());
+        Array::Type type = array.is_inner_bptree_node() ? Array::type_InnerBptreeNode : Array::type_HasRefs;
+        new_array.create(type, array.get_context_flag()); // Throws
+        _impl::ShallowArrayDestroyGuard dg(&new_array);
+        for (int_fast64_t value : values)
+            new_array.add(value); // Throws
+        size_t new_size = new_array.get_byte_size();
+        if (read_only && !subtrees_written) {
+            FreeListElement chunk = reserve_free_space_below(new_size, m_compaction_limit); // Throws
+            if (chunk == m_free_in_file.end())
+                return ref;
+            size_t pos = claim_free_space(chunk, new_size);                                       // Throws
+            new_ref = defer_write(pos, new_array.get_header(), new_size, dummy_checksum, false); // Throws
+        }
+        else {
+            new_ref = write_array(new_array.get_header(), new_size, dummy_checksum); // Throws
+        }
+        if (!read_only)
+            return new_ref;
+    }
+
+    // Unmodified arrays that were written are freed like modified arrays are
+    // when they are copied on write, such that their space becomes reusable
+    // when no reader depends on the current version any longer
+    m_relocation_budget_left -= std::min(byte_size, m_relocation_budget_left);
+    m_bytes_relocated += byte_size;
+    m_alloc.free_(ref, header);
+    return new_ref;
 }
 
 
-std::pair<size_t, size_t> GroupWriter::search_free_space_in_part_of_freelist(size_t size, size_t begin, size_t end,
-                                                                             bool& found)
+size_t GroupWriter::write_freelist(ref_type reserve_pos, ref_type reserve_pos_bound)
 {
     bool is_shared = m_group.m_is_shared;
-    SlabAlloc& alloc = m_group.m_alloc;
-    for (size_t next_start = begin; next_start < end;) {
-        size_t i = m_free_lengths.find_first<Greater>(size - 1, next_start);
-        if (i == not_found) {
-            break;
+
+    m_free_positions.clear(); // Throws
+    m_free_lengths.clear();   // Throws
+    if (is_shared)
+        m_free_versions.clear(); // Throws
+
+    size_t reserve_ndx = realm::npos;
+    size_t ndx = 0;
+    for (const auto& chunk : m_free_in_file) {
+        ref_type pos = chunk.first;
+        if (pos == reserve_pos) {
+            reserve_ndx = ndx;
+            pos = reserve_pos_bound;
         }
+        m_free_positions.add(from_ref(pos));            // Throws
+        m_free_lengths.add(to_int64(chunk.second.size)); // Throws
+        if (is_shared)
+            m_free_versions.add(int_fast64_t(chunk.second.released_at_version)); // Throws
+        ++ndx;
+    }
+    REALM_ASSERT(reserve_ndx != realm::npos);
+    return reserve_ndx;
+}
 
-        next_start = i + 1;
 
-        // Only chunks that are not occupied by current readers
-        // are allowed to be used.
-        if (is_shared) {
-            size_t ver = to_size_t(m_free_versions.get(i));
-            if (ver >= m_readlock_version) {
-                continue;
-            }
-        }
+bool GroupWriter::is_allocatable(const FreeSpaceEntry& entry) const noexcept
+{
+    // Only chunks that are not occupied by current readers are allowed to be
+    // used.
+    return !m_group.m_is_shared || entry.released_at_version < m_readlock_version;
+}
 
-        size_t chunk_size = to_size_t(m_free_lengths.get(i));
 
-        // search through the chunk, finding a place within it,
-        // where an allocation will not cross a mmap boundary
-        size_t start_pos = to_size_t(m_free_positions.get(i));
-        size_t alloc_pos = alloc.find_section_in_range(start_pos, chunk_size, size);
-        if (alloc_pos == 0) {
-            continue;
+GroupWriter::FreeListElement GroupWriter::insert_free_chunk(ref_type pos, size_t size, uint64_t released_at_version)
+{
+    FreeSpaceEntry entry{size, released_at_version};
+    FreeListElement element = m_free_in_file.emplace(pos, entry).first; // Throws
+    if (is_allocatable(entry)) {
+        try {
+            m_size_map.emplace(size, pos); // Throws
         }
-        // we found a place - if it's not at the beginning of the chunk,
-        // we split the chunk so that the allocation can be done from the
-        // beginning of the second chunk.
-        if (alloc_pos != start_pos) {
-            chunk_size = split_freelist_chunk(i, start_pos, alloc_pos, chunk_size, is_shared);
-            ++i;
+        catch (...) {
+            m_free_in_file.erase(element);
+            throw;
         }
-        // Match found!
-        found = true;
-        return std::make_pair(i, chunk_size);
     }
-    // No match
-    found = false;
-    return std::make_pair(end, 0);
+    return element;
 }
 
 
-std::pair<size_t, size_t> GroupWriter::reserve_free_space(size_t size)
+void GroupWriter::erase_free_chunk(FreeListElement element) noexcept
 {
-    typedef std::pair<size_t, size_t> Chunk;
-    Chunk chunk;
-    bool found;
-    // Since we do a first-fit search for small chunks, the top pieces are
-    // likely to get smaller and smaller. So when we are looking for bigger
-    // chunks we are likely to find them faster by skipping the first half of
-    // the list.
-    size_t end = m_free_lengths.size();
-    if (size < 1024) {
-        chunk = search_free_space_in_part_of_freelist(size, 0, end, found);
-        if (found)
-            return chunk;
+    if (is_allocatable(element->second))
+        m_size_map.erase(std::make_pair(element->second.size, element->first));
+    m_free_in_file.erase(element);
+}
+
+
+size_t GroupWriter::get_free_space(size_t size)
+{
+    REALM_ASSERT_3(size % 8, ==, 0); // 8-byte alignment
+
+    FreeListElement chunk = reserve_free_space(size); // Throws
+    return claim_free_space(chunk, size);             // Throws
+}
+
+
+size_t GroupWriter::claim_free_space(FreeListElement chunk, size_t size)
+{
+    // Claim space from identified chunk
+    size_t chunk_pos = size_t(chunk->first);
+    size_t chunk_size = chunk->second.size;
+    uint64_t version = chunk->second.released_at_version;
+    REALM_ASSERT_3(chunk_size, >=, size);
+    REALM_ASSERT((chunk_size % 8) == 0);
+
+    // Allocating part of chunk - this alway happens from the beginning of the
+    // chunk. The call to reserve_free_space may split chunks in order to make
+    // sure that it returns a chunk from which allocation can be done from the
+    // beginning
+    erase_free_chunk(chunk);
+    size_t rest = chunk_size - size;
+    if (rest > 0)
+        insert_free_chunk(chunk_pos + size, rest, version); // Throws
+    REALM_ASSERT((chunk_pos % 8) == 0);
+    return chunk_pos;
+}
+
+
+GroupWriter::FreeListElement GroupWriter::search_free_space_in_free_list_element(FreeListElement element,
+                                                                                 size_t size)
+{
+    SlabAlloc& alloc = m_group.m_alloc;
+    size_t chunk_size = element->second.size;
+
+    // search through the chunk, finding a place within it,
+    // where an allocation will not cross a mmap boundary
+    size_t start_pos = size_t(element->first);
+    size_t alloc_pos = alloc.find_section_in_range(start_pos, chunk_size, size);
+    if (alloc_pos == 0) {
+        return m_free_in_file.end();
     }
-    else {
-        chunk = search_free_space_in_part_of_freelist(size, end / 2, end, found);
-        if (found)
+    // we found a place - if it's not at the beginning of the chunk,
+    // we split the chunk so that the allocation can be done from the
+    // beginning of the second chunk.
+    if (alloc_pos != start_pos) {
+        uint64_t version = element->second.released_at_version;
+        erase_free_chunk(element);
+        insert_free_chunk(start_pos, alloc_pos - start_pos, version);                 // Throws
+        element = insert_free_chunk(alloc_pos, start_pos + chunk_size - alloc_pos, version); // Throws
+    }
+    return element;
+}
+
+
+GroupWriter::FreeListElement GroupWriter::reserve_free_space(size_t size)
+{
+    // Best fit: visit the chunks that are not in use by any reader in order of
+    // increasing size, starting with the smallest one that is big enough.
+    if (m_compaction_limit != 0) {
+        // When compacting, prefer the chunks below the limit
+        FreeListElement chunk = reserve_free_space_below(size, m_compaction_limit); // Throws
+        if (chunk != m_free_in_file.end())
             return chunk;
-        chunk = search_free_space_in_part_of_freelist(size, 0, end / 2, found);
-        if (found)
+    }
+    auto end = m_size_map.end();
+    for (auto i = m_size_map.lower_bound(std::make_pair(size, ref_type(0))); i != end; ++i) {
+        FreeListElement element = m_free_in_file.find(i->second);
+        REALM_ASSERT_DEBUG(element != m_free_in_file.end());
+        FreeListElement chunk = search_free_space_in_free_list_element(element, size); // Throws
+        if (chunk != m_free_in_file.end())
             return chunk;
     }
 
     // No free space, so we have to extend the file.
-    do {
-        extend_free_space(size);
-        // extending the file will add a new entry at the end of the freelist,
-        // so search that particular entry
-        end = m_free_lengths.size();
-        chunk = search_free_space_in_part_of_freelist(size, end - 1, end, found);
-    } while (!found);
-    return chunk;
+    for (;;) {
+        FreeListElement element = extend_free_space(size); // Throws
+        FreeListElement chunk = search_free_space_in_free_list_element(element, size); // Throws
+        if (chunk != m_free_in_file.end())
+            return chunk;
+    }
+}
+
+GroupWriter::FreeListElement GroupWriter::reserve_free_space_below(size_t size, ref_type limit)
+{
+    auto end = m_size_map.end();
+    for (auto i = m_size_map.lower_bound(std::make_pair(size, ref_type(0))); i != end; ++i) {
+        if (i->second >= limit)
+            continue;
+        FreeListElement element = m_free_in_file.find(i->second);
+        REALM_ASSERT_DEBUG(element != m_free_in_file.end());
+        FreeListElement chunk = search_free_space_in_free_list_element(element, size); // Throws
+        if (chunk != m_free_in_file.end())
+            return chunk;
+    }
+    return m_free_in_file.end();
 }
 
 // Extend the free space with at least the requested size.
 // Due to mmap constraints, the extension can not be guaranteed to
 // allow an allocation of the requested size, so multiple calls to
 // extend_free_space may be needed, before an allocation can succeed.
-std::pair<size_t, size_t> GroupWriter::extend_free_space(size_t requested_size)
+GroupWriter::FreeListElement GroupWriter::extend_free_space(size_t requested_size)
 {
-    bool is_shared = m_group.m_is_shared;
     SlabAlloc& alloc = m_group.m_alloc;
 
     // We need to consider the "logical" size of the file here, and not the real
@@ -714,22 +977,16 @@ std::pair<size_t, size_t> GroupWriter::extend_free_space(size_t requested_size)
     // ensure non-concurrent file mutation.
     m_alloc.resize_file(new_file_size); // Throws
 
-    //    m_file_map.remap(m_alloc.get_file(), File::access_ReadWrite, new_file_size); // Throws
-
-    size_t chunk_ndx = m_free_positions.size();
     size_t chunk_size = new_file_size - logical_file_size;
     REALM_ASSERT_3(chunk_size % 8, ==, 0); // 8-byte alignment
-    m_free_positions.add(logical_file_size);
-    m_free_lengths.add(chunk_size);
-    if (is_shared)
-        m_free_versions.add(0); // new space is always free for writing
-
+    // new space is always free for writing
+    FreeListElement element = insert_free_chunk(logical_file_size, chunk_size, 0); // Throws
 
     // Update the logical file size
     m_group.m_top.set(2, 1 + 2 * uint64_t(new_file_size)); // Throws
     REALM_ASSERT(chunk_size != 0);
     REALM_ASSERT((chunk_size % 8) == 0);
-    return std::make_pair(chunk_ndx, chunk_size);
+    return element;
 }
 
 
@@ -745,29 +1002,141 @@ void GroupWriter::write(const char* data, size_t size)
     window->encryption_read_barrier(dest_addr, size);
     realm::safe_copy_n(data, size, dest_addr);
     window->encryption_write_barrier(dest_addr, size);
+    add_dirty_range(pos, size);
 }
 
 
 ref_type GroupWriter::write_array(const char* data, size_t size, uint32_t checksum)
 {
     // Get position of free space to write in (expanding file if needed)
-    size_t pos = get_free_space(size);
+    size_t pos = get_free_space(size);                  // Throws
+    return defer_write(pos, data, size, checksum, false); // Throws
+}
+
+
+ref_type GroupWriter::write_persistent_array(const char* data, size_t size, uint32_t checksum)
+{
+    size_t pos = get_free_space(size);                 // Throws
+    return defer_write(pos, data, size, checksum, true); // Throws
+}
+
+
+ref_type GroupWriter::defer_write(size_t pos, const char* data, size_t size, uint32_t checksum, bool persistent)
+{
     REALM_ASSERT_3((pos & 0x7), ==, 0); // Write position should always be 64bit aligned
 
-    // Write the block
-    MapWindow* window = get_window(pos, size);
-    char* dest_addr = window->translate(pos);
-    window->encryption_read_barrier(dest_addr, size);
-    memcpy(dest_addr, &checksum, 4);
-    memcpy(dest_addr + 4, data + 4, size - 4);
+    DeferredWrite write;
+    write.pos = pos;
+    write.size = size;
+    write.data = data;
+    write.staging_offset = 0;
+    write.checksum = checksum;
+    if (!persistent) {
+        write.data = nullptr;
+        write.staging_offset = m_staging.size();
+        m_staging.insert(m_staging.end(), data, data + size); // Throws
+    }
+    m_deferred_writes.push_back(write); // Throws
+    m_deferred_bytes += size;
+    ++m_arrays_written;
+    add_dirty_range(pos, size);
 
-    window->encryption_write_barrier(dest_addr, size);
     // return ref of the written array
     ref_type ref = to_ref(pos);
     return ref;
 }
 
 
+void GroupWriter::flush_deferred_writes()
+{
+    for (DeferredWrite& write : m_deferred_writes) {
+        if (!write.data)
+            write.data = m_staging.data() + write.staging_offset;
+    }
+    // Copy in file order, such that each part of the file is mapped once
+    std::sort(m_deferred_writes.begin(), m_deferred_writes.end(),
+              [](const DeferredWrite& a, const DeferredWrite& b) { return a.pos < b.pos; });
+
+    // Encrypted mappings, and mappings that must be sync'ed individually, are
+    // managed by the window cache, which is not thread safe
+    size_t num_threads = 1;
+    if (m_use_writeback) {
+        size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+        num_threads = std::min(max_threads, 1 + m_deferred_bytes / parallel_write_min_bytes);
+    }
+
+    if (num_threads == 1) {
+        for (const DeferredWrite& write : m_deferred_writes) {
+            MapWindow* window = get_window(write.pos, write.size);
+            char* dest_addr = window->translate(write.pos);
+            window->encryption_read_barrier(dest_addr, write.size);
+            memcpy(dest_addr, &write.checksum, 4);
+            memcpy(dest_addr + 4, write.data + 4, write.size - 4);
+            window->encryption_write_barrier(dest_addr, write.size);
+        }
+    }
+    else {
+        // Split the writes into runs of about the same number of bytes, and
+        // copy the last run on this thread
+        std::unique_ptr<util::Thread[]> threads(new util::Thread[num_threads - 1]);
+        std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[num_threads - 1]);
+        size_t bytes_per_thread = m_deferred_bytes / num_threads;
+        const DeferredWrite* begin = m_deferred_writes.data();
+        const DeferredWrite* end = begin + m_deferred_writes.size();
+        size_t num_started = 0;
+        try {
+            while (num_started < num_threads - 1) {
+                const DeferredWrite* run_end = begin;
+                size_t run_bytes = 0;
+                while (run_end != end && run_bytes < bytes_per_thread)
+                    run_bytes += (run_end++)->size;
+                std::exception_ptr& error = errors[num_started];
+                threads[num_started].start([=, &error] {
+                    try {
+                        copy_deferred_writes(begin, run_end); // Throws
+                    }
+                    catch (...) {
+                        error = std::current_exception();
+                    }
+                }); // Throws
+                ++num_started;
+                begin = run_end;
+            }
+            copy_deferred_writes(begin, end); // Throws
+        }
+        catch (...) {
+            for (size_t i = 0; i < num_started; ++i)
+                threads[i].join();
+            throw;
+        }
+        for (size_t i = 0; i < num_started; ++i)
+            threads[i].join();
+        for (size_t i = 0; i < num_started; ++i) {
+            if (errors[i])
+                std::rethrow_exception(errors[i]);
+        }
+    }
+
+    m_deferred_writes.clear();
+    m_staging.clear();
+    m_deferred_bytes = 0;
+}
+
+
+void GroupWriter::copy_deferred_writes(const DeferredWrite* begin, const DeferredWrite* end) const
+{
+    util::File& file = m_alloc.get_file();
+    std::unique_ptr<MapWindow> window;
+    for (const DeferredWrite* write = begin; write != end; ++write) {
+        if (!window || !window->matches(write->pos, write->size))
+            window = std::make_unique<MapWindow>(file, write->pos, write->size); // Throws
+        char* dest_addr = window->translate(write->pos);
+        memcpy(dest_addr, &write->checksum, 4);
+        memcpy(dest_addr + 4, write->data + 4, write->size - 4);
+    }
+}
+
+
 void GroupWriter::write_array_at(MapWindow* window, ref_type ref, const char* data, size_t size)
 {
     size_t pos = size_t(ref);
@@ -779,6 +1148,7 @@ void GroupWriter::write_array_at(MapWindow* window, ref_type ref, const char* da
     uint32_t dummy_checksum = 0x41414141UL; // "AAAA" in ASCII
     memcpy(dest_addr, &dummy_checksum, 4);
     memcpy(dest_addr + 4, data + 4, size - 4);
+    ++m_arrays_written;
 }
 
 
@@ -813,18 +1183,100 @@ void GroupWriter::commit(ref_type new_top_ref)
     // Make sure that that all data relating to the new snapshot is written to
     // stable storage before flipping the slot selector
     window->encryption_write_barrier(&file_header, sizeof file_header);
-    if (!disable_sync)
-        sync_all_mappings();
+    if (!disable_sync) {
+#if REALM_METRICS
+        std::unique_ptr<MetricTimer> data_fsync_timer = Metrics::report_data_fsync_time(m_group);
+#endif // REALM_METRICS
+        flush_dirty_ranges(); // Throws
+    }
 
     // Flip the slot selector bit.
     using type_2 = std::remove_reference<decltype(file_header.m_flags)>::type;
     file_header.m_flags = type_2(new_flags);
 
     // Write new selector to disk
-    // FIXME: we might optimize this to write of a single page?
     window->encryption_write_barrier(&file_header, sizeof file_header);
+    if (!disable_sync) {
+#if REALM_METRICS
+        std::unique_ptr<MetricTimer> header_fsync_timer = Metrics::report_header_fsync_time(m_group);
+#endif // REALM_METRICS
+        if (m_use_writeback) {
+            m_alloc.get_file().sync_data(); // Throws
+        }
+        else {
+            window->sync(); // Throws
+        }
+        ++m_num_sync_calls;
+    }
+
+#if REALM_METRICS
+    Metrics::report_write_io(m_group, sizeof file_header, 0, m_num_sync_calls);
+#endif // REALM_METRICS
+
+    truncate_file();
+}
+
+
+void GroupWriter::truncate_file()
+{
+#ifndef _WIN32 // Windows does not allow a mapped file to be shrunk
+    // The encryption layer caches the pages of the file, and would not notice
+    // that they are gone
+    if (m_alloc.get_file().get_encryption_key())
+        return;
+
+    // No snapshot that is still in use, nor the one that is now durable,
+    // refers to any space beyond the logical file size. The mappings held by
+    // readers may extend beyond it, but they are never accessed there.
+    size_t new_file_size = to_size_t(m_group.m_top.get(2) / 2);
+    if (!m_alloc.matches_section_boundary(new_file_size))
+        new_file_size = m_alloc.get_upper_section_boundary(new_file_size);
+    if (new_file_size >= get_file_size())
+        return;
+    try {
+        m_alloc.truncate_file(new_file_size); // Throws
+    }
+    catch (std::runtime_error&) {
+        // The new snapshot is already committed, so failing to give back the
+        // space is not an error. It will be attempted again by the next
+        // commit.
+    }
+#endif
+}
+
+
+void GroupWriter::commit_top_ref(util::File& file, ref_type new_top_ref, int file_format_version)
+{
+    File::Map<SlabAlloc::Header> map(file, File::access_ReadWrite); // Throws
+    SlabAlloc::Header& file_header = *map.get_addr();
+    realm::util::encryption_read_barrier(map, 0);
+
+    // Select the slot that is not in use by the currently durable snapshot, as
+    // in commit()
+    unsigned old_flags = file_header.m_flags;
+    unsigned new_flags = old_flags ^ SlabAlloc::flags_SelectBit;
+    int slot_selector = ((new_flags & SlabAlloc::flags_SelectBit) != 0 ? 1 : 0);
+
+    using type_1 = std::remove_reference<decltype(file_header.m_file_format[0])>::type;
+    REALM_ASSERT(!util::int_cast_has_overflow<type_1>(file_format_version));
+    file_header.m_top_ref[slot_selector] = new_top_ref;
+    file_header.m_file_format[slot_selector] = type_1(file_format_version);
+
+    // When running the test suite, device synchronization is disabled
+    bool disable_sync = get_disable_sync_to_disk();
+
+    // The changes were written through mappings that are gone by now, so the
+    // entire file is synchronized, rather than individual mappings
+    realm::util::encryption_write_barrier(map, 0);
     if (!disable_sync)
-        window->sync();
+        file.sync(); // Throws
+
+    using type_2 = std::remove_reference<decltype(file_header.m_flags)>::type;
+    file_header.m_flags = type_2(new_flags);
+
+    realm::util::encryption_write_barrier(map, 0);
+    if (!disable_sync)
+        map.sync(); // Throws
 }
 
 
@@ -20,6 +20,8 @@
 #define REALM_GROUP_WRITER_HPP
 
 #include <cstdint> // unint8_t etc
+#include <map>
+#include <set>
 #include <utility>
 
 #include <realm/util/file.hpp>
@@ -55,6 +57,12 @@ public:
 
     void set_versions(uint64_t current, uint64_t read_lock) noexcept;
 
+    /// Let write_group() move unmodified arrays from the end of the file into
+    /// free space closer to the beginning, up to \a budget bytes, if more than
+    /// the fraction \a threshold of the file is free space. See
+    /// SharedGroupOptions::compaction_budget.
+    void set_compaction(size_t budget, double threshold) noexcept;
+
     /// Write all changed array nodes into free space.
     ///
     /// Returns the new top ref. When in full durability mode, call
@@ -66,18 +74,30 @@ public:
     /// returned by write_group().
     void commit(ref_type new_top_ref);
 
+    /// Write the specified top ref to the file header, then flush it to
+    /// physical medium. The changes of all the commits since the last time
+    /// the header was written are flushed first. This is used by group
+    /// commit, where the header is written on behalf of several write
+    /// transactions, after their GroupWriters are gone.
+    static void commit_top_ref(util::File&, ref_type new_top_ref, int file_format_version);
+
     size_t get_file_size() const noexcept;
 
     /// Write the specified chunk into free space.
     void write(const char* data, size_t size);
 
     ref_type write_array(const char*, size_t, uint32_t) override;
+    ref_type write_persistent_array(const char*, size_t, uint32_t) override;
 
 #ifdef REALM_DEBUG
     void dump();
 #endif
 
     size_t get_free_space();
+
+    /// The amount of space freed by the changes written by write_group(). It
+    /// can be reused once no reader uses the previous versions any more.
+    size_t get_released_bytes() const noexcept;
 private:
     class MapWindow;
     Group& m_group;
@@ -88,14 +108,76 @@ private:
     uint64_t m_current_version;
     uint64_t m_readlock_version;
 
+    // Incremental compaction. If m_compaction_limit is not zero, write_group()
+    // moves arrays placed at or beyond it, and allocates below it where it can.
+    size_t m_compaction_budget = 0;
+    double m_compaction_threshold = 0;
+    ref_type m_compaction_limit = 0;
+    size_t m_relocation_budget_left = 0;
+    size_t m_bytes_relocated = 0;
+
+    // The free-lists above are only read and written by write_group(). In
+    // between, the free space in the file is tracked by an in-memory index,
+    // so that allocation and coalescing do not have to scan the free-lists.
+    struct FreeSpaceEntry {
+        size_t size;
+        uint64_t released_at_version;
+    };
+    using FreeList = std::map<ref_type, FreeSpaceEntry>;
+    using FreeListElement = FreeList::iterator;
+
+    // All free chunks in the file, ordered by position
+    FreeList m_free_in_file;
+    // The chunks in m_free_in_file that are not in use by any reader, ordered
+    // by size, then by position
+    std::set<std::pair<size_t, ref_type>> m_size_map;
+
     // Currently cached memory mappings. We keep as many as 16 1MB windows
     // open for writing. The allocator will favor sequential allocation
     // from a modest number of windows, depending upon fragmentation, so
     // 16 windows should be more than enough. If more than 16 windows are
     // needed, the least recently used is sync'ed and closed to make room
     // for a new one. The windows are kept in MRU (most recently used) order.
+    // When the file supports writeback (see util::File::is_writeback_supported()),
+    // windows are never sync'ed individually. Instead, the ranges written are
+    // recorded in m_dirty_ranges, and flushed in file order on commit.
     const static int num_map_windows = 16;
     std::vector<std::unique_ptr<MapWindow>> m_map_windows;
+    bool m_use_writeback;
+    std::vector<std::pair<ref_type, size_t>> m_dirty_ranges;
+
+    // write_group() serializes the changed arrays in two phases. First all
+    // arrays are assigned a position in the file, and the copies are
+    // recorded. Then the arrays are copied in file order, using several
+    // threads when there is enough data to copy. Arrays that do not outlive
+    // the call to write_array() are copied into m_staging in the first phase.
+    struct DeferredWrite {
+        ref_type pos;
+        size_t size;
+        const char* data; // Null while the data is in m_staging
+        size_t staging_offset;
+        uint32_t checksum;
+    };
+    std::vector<DeferredWrite> m_deferred_writes;
+    std::vector<char> m_staging;
+    size_t m_deferred_bytes = 0;
+
+    // The minimum amount of data to copy per thread when copying the
+    // deferred writes in parallel
+    static const size_t parallel_write_min_bytes = 8 * 1024 * 1024; // 8MB
+
+    // The free space at the end of the file is given back to the file system
+    // once it makes up at least 1/trim_min_fraction of the file. Some of it,
+    // 1/trim_headroom_fraction of the remaining size, is kept to accomodate
+    // the following commits without extending the file again.
+    static const size_t trim_min_fraction = 4;
+    static const size_t trim_headroom_fraction = 16;
+
+    // Reported to the metrics, if enabled
+    size_t m_bytes_written = 0;
+    size_t m_arrays_written = 0;
+    size_t m_released_bytes = 0;
+    size_t m_num_sync_calls = 0;
 
     // Get a suitable memory mapping for later access:
     // potentially adding it to the cache, potentially closing
@@ -105,8 +187,44 @@ private:
     // Sync all cached memory mappings
     void sync_all_mappings();
 
-    // Merge adjacent chunks
-    void merge_free_space();
+    // Record that the specified range of the file was written to
+    void add_dirty_range(ref_type pos, size_t size);
+
+    // Make everything written so far durable. With writeback, the dirty
+    // ranges are sorted, widened to page boundaries and merged, writeback is
+    // started for each merged range in ascending order, and the file is
+    // synchronized once. Otherwise all cached memory mappings are sync'ed.
+    void flush_dirty_ranges();
+
+    // Decide whether this commit compacts the file, and set
+    // m_compaction_limit accordingly. The limit is the size the file would
+    // have without free space.
+    void start_compaction();
+
+    // Same as Array::write() with `only_if_modified`, except that unmodified
+    // arrays placed at or beyond m_compaction_limit are written too, as long as
+    // the relocation budget lasts. The space of moved arrays is freed.
+    ref_type write_and_relocate(ref_type ref);
+
+    // Build the in-memory index of free space from the free-lists, merging
+    // adjacent chunks where possible.
+    void read_in_freelist();
+
+    // Reduce the logical file size, if the file ends with a large chunk of
+    // free space that is not in use by any reader. The file itself is
+    // truncated accordingly by commit(), once the new snapshot is durable.
+    void trim_free_tail();
+
+    // Truncate the file to the logical size of the committed snapshot
+    // (rounded up to a section boundary), if it is larger than that.
+    void truncate_file();
+
+    // Write the in-memory index of free space back into the free-lists. The
+    // chunk at \a reserve_pos is written with \a reserve_pos_bound as its
+    // position, which must be an upper bound on the position it is going to
+    // be given by write_group(). Returns the index of that chunk in the
+    // free-lists.
+    size_t write_freelist(ref_type reserve_pos, ref_type reserve_pos_bound);
 
     /// Allocate a chunk of free space of the specified size. The
     /// specified size must be 8-byte aligned. Extend the file if
@@ -118,36 +236,56 @@ private:
     /// chunk.
     size_t get_free_space(size_t size);
 
-    /// Find a block of free space that is at least as big as the
+    /// Find the smallest block of free space that is at least as big as the
     /// specified size and which will allow an allocation that is mapped
     /// inside a contiguous address range. The specified size does not
     /// need to be 8-byte aligned. Extend the file if required.
     /// The returned chunk is not removed from the amount of remaing
     /// free space.
     ///
-    /// \return A pair (`chunk_ndx`, `chunk_size`) where `chunk_ndx`
-    /// is the index of a chunk whose size is at least the requestd
-    /// size, and `chunk_size` is the size of that chunk.
-    std::pair<size_t, size_t> reserve_free_space(size_t size);
+    /// \return The chunk, which starts at the position that the allocation
+    /// must be made at.
+    FreeListElement reserve_free_space(size_t size);
+
+    /// Same as reserve_free_space(), but only considers chunks that start
+    /// below \a limit, and returns m_free_in_file.end() instead of extending
+    /// the file if none of them will do.
+    FreeListElement reserve_free_space_below(size_t size, ref_type limit);
+
+    /// Remove an allocation of the specified size from the beginning of a
+    /// chunk returned by reserve_free_space() or reserve_free_space_below().
+    /// Returns the position of the allocation.
+    size_t claim_free_space(FreeListElement chunk, size_t size);
 
-    /// Search only a range of the free list for a block as big as the
-    /// specified size. Return a pair with index and size of the found chunk.
-    /// \param found indicates whether a suitable block was found.
-    std::pair<size_t, size_t> search_free_space_in_part_of_freelist(size_t size, size_t begin, size_t end,
-                                                                    bool& found);
+    /// Check if the specified chunk allows an allocation of the specified
+    /// size inside a contiguous address range. If it does, the chunk is split
+    /// so that the allocation can be made from the beginning of the
+    /// second part, and that part is returned. Otherwise returns
+    /// m_free_in_file.end().
+    FreeListElement search_free_space_in_free_list_element(FreeListElement element, size_t size);
 
     /// Extend the file to ensure that a chunk of free space of the
     /// specified size is available. The specified size does not need
     /// to be 8-byte aligned. This function guarantees that it will
-    /// add at most one entry to the free-lists.
+    /// add at most one chunk to the free space.
     ///
-    /// \return A pair (`chunk_ndx`, `chunk_size`) where `chunk_ndx`
-    /// is the index of a chunk whose size is at least the requestd
-    /// size, and `chunk_size` is the size of that chunk.
-    std::pair<size_t, size_t> extend_free_space(size_t requested_size);
+    /// \return The added chunk.
+    FreeListElement extend_free_space(size_t requested_size);
+
+    FreeListElement insert_free_chunk(ref_type pos, size_t size, uint64_t released_at_version);
+    void erase_free_chunk(FreeListElement) noexcept;
+    bool is_allocatable(const FreeSpaceEntry&) const noexcept;
 
     void write_array_at(MapWindow* window, ref_type, const char* data, size_t size);
-    size_t split_freelist_chunk(size_t index, size_t start_pos, size_t alloc_pos, size_t chunk_size, bool is_shared);
+
+    ref_type defer_write(size_t pos, const char* data, size_t size, uint32_t checksum, bool persistent);
+
+    // Copy all deferred writes to the file
+    void flush_deferred_writes();
+
+    // Copy the specified deferred writes, which must be in file order, using
+    // mappings of its own. May be called from any thread.
+    void copy_deferred_writes(const DeferredWrite* begin, const DeferredWrite* end) const;
 };
 
 
@@ -160,6 +298,17 @@ inline void GroupWriter::set_versions(uint64_t current, uint64_t read_lock) noex
     m_readlock_version = read_lock;
 }
 
+inline size_t GroupWriter::get_released_bytes() const noexcept
+{
+    return m_released_bytes;
+}
+
+inline void GroupWriter::set_compaction(size_t budget, double threshold) noexcept
+{
+    m_compaction_budget = budget;
+    m_compaction_threshold = threshold;
+}
+
 } // namespace realm
 
 #endif // REALM_GROUP_WRITER_HPP
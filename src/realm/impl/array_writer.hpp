@@ -36,6 +36,14 @@ public:
     /// Returns the ref (position in the target stream) of the written copy of
     /// the specified array data.
     virtual ref_type write_array(const char* data, size_t size, uint32_t checksum) = 0;
+
+    /// Same as write_array(), except that the caller guarantees that the
+    /// specified array data stays accessible and unmodified for as long as
+    /// the writer is in use, such that the copy may be deferred.
+    virtual ref_type write_persistent_array(const char* data, size_t size, uint32_t checksum)
+    {
+        return write_array(data, size, checksum); // Throws
+    }
 };
 
 } // namespace impl_
@@ -81,6 +81,7 @@ enum Instruction {
     instr_LinkListClear = 38,   // Ramove all entries from a link list
     instr_LinkListSetAll = 39,  // Assign to link list entry
     instr_AddRowWithKey = 40,   // Insert a row with a given key
+    instr_SetColumnValues = 41, // Assign to a range of rows in one column
 };
 
 class TransactLogStream {
@@ -393,6 +394,20 @@ public:
 
     /// End of methods expected by parser.
 
+    /// Assign to \a num_values consecutive rows of one column, starting at \a
+    /// row_ndx, using a single instruction. The parser reports each
+    /// assignment as a separate call to set_*() or set_null(). If \a nulls is
+    /// not null, the entries for which it is true are set to null. Strings
+    /// and timestamps are null when their value is.
+    bool set_int_values(size_t col_ndx, size_t row_ndx, const int64_t* values, const bool* nulls,
+                        size_t num_values);
+    bool set_bool_values(size_t col_ndx, size_t row_ndx, const int64_t* values, const bool* nulls,
+                         size_t num_values);
+    bool set_double_values(size_t col_ndx, size_t row_ndx, const double* values, const bool* nulls,
+                           size_t num_values);
+    bool set_string_values(size_t col_ndx, size_t row_ndx, const StringData* values, size_t num_values);
+    bool set_timestamp_values(size_t col_ndx, size_t row_ndx, const Timestamp* values, size_t num_values);
+
 
     TransactLogEncoder(TransactLogStream& out_stream);
     void set_buffer(char* new_free_begin, char* new_free_end);
@@ -505,6 +520,20 @@ public:
     virtual void set_link(const Table*, size_t col_ndx, size_t ndx, size_t value, Instruction variant = instr_Set);
     virtual void set_null(const Table*, size_t col_ndx, size_t ndx, Instruction variant = instr_Set);
     virtual void set_link_list(const LinkView&, const IntegerColumn& values);
+
+    /// Assign to a range of rows in one column. See
+    /// TransactLogEncoder::set_int_values() for the meaning of the
+    /// arguments.
+    virtual void set_int_values(const Table*, size_t col_ndx, size_t row_ndx, const int64_t* values,
+                                const bool* nulls, size_t num_values);
+    virtual void set_bool_values(const Table*, size_t col_ndx, size_t row_ndx, const int64_t* values,
+                                 const bool* nulls, size_t num_values);
+    virtual void set_double_values(const Table*, size_t col_ndx, size_t row_ndx, const double* values,
+                                   const bool* nulls, size_t num_values);
+    virtual void set_string_values(const Table*, size_t col_ndx, size_t row_ndx, const StringData* values,
+                                   size_t num_values);
+    virtual void set_timestamp_values(const Table*, size_t col_ndx, size_t row_ndx, const Timestamp* values,
+                                      size_t num_values);
     virtual void insert_substring(const Table*, size_t col_ndx, size_t row_ndx, size_t pos, StringData);
     virtual void erase_substring(const Table*, size_t col_ndx, size_t row_ndx, size_t pos, size_t size);
 
@@ -1418,6 +1447,117 @@ inline void TransactLogConvenientEncoder::set_null(const Table* t, size_t col_nd
     m_encoder.set_null(col_ndx, row_ndx, variant, prior_num_rows); // Throws
 }
 
+inline bool TransactLogEncoder::set_int_values(size_t col_ndx, size_t row_ndx, const int64_t* values,
+                                               const bool* nulls, size_t num_values)
+{
+    append_simple_instr(instr_SetColumnValues, type_Int, col_ndx, row_ndx, num_values); // Throws
+    for (size_t i = 0; i < num_values; ++i) {
+        if (nulls && nulls[i]) {
+            append_simple_instr(true); // Throws
+        }
+        else {
+            append_simple_instr(false, values[i]); // Throws
+        }
+    }
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_int_values(const Table* t, size_t col_ndx, size_t row_ndx,
+                                                         const int64_t* values, const bool* nulls, size_t num_values)
+{
+    select_table(t);                                                      // Throws
+    m_encoder.set_int_values(col_ndx, row_ndx, values, nulls, num_values); // Throws
+}
+
+inline bool TransactLogEncoder::set_bool_values(size_t col_ndx, size_t row_ndx, const int64_t* values,
+                                                const bool* nulls, size_t num_values)
+{
+    append_simple_instr(instr_SetColumnValues, type_Bool, col_ndx, row_ndx, num_values); // Throws
+    for (size_t i = 0; i < num_values; ++i) {
+        if (nulls && nulls[i]) {
+            append_simple_instr(true); // Throws
+        }
+        else {
+            append_simple_instr(false, values[i] != 0); // Throws
+        }
+    }
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_bool_values(const Table* t, size_t col_ndx, size_t row_ndx,
+                                                          const int64_t* values, const bool* nulls, size_t num_values)
+{
+    select_table(t);                                                       // Throws
+    m_encoder.set_bool_values(col_ndx, row_ndx, values, nulls, num_values); // Throws
+}
+
+inline bool TransactLogEncoder::set_double_values(size_t col_ndx, size_t row_ndx, const double* values,
+                                                  const bool* nulls, size_t num_values)
+{
+    append_simple_instr(instr_SetColumnValues, type_Double, col_ndx, row_ndx, num_values); // Throws
+    for (size_t i = 0; i < num_values; ++i) {
+        if (nulls && nulls[i]) {
+            append_simple_instr(true); // Throws
+        }
+        else {
+            append_simple_instr(false, values[i]); // Throws
+        }
+    }
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_double_values(const Table* t, size_t col_ndx, size_t row_ndx,
+                                                            const double* values, const bool* nulls,
+                                                            size_t num_values)
+{
+    select_table(t);                                                         // Throws
+    m_encoder.set_double_values(col_ndx, row_ndx, values, nulls, num_values); // Throws
+}
+
+inline bool TransactLogEncoder::set_string_values(size_t col_ndx, size_t row_ndx, const StringData* values,
+                                                  size_t num_values)
+{
+    append_simple_instr(instr_SetColumnValues, type_String, col_ndx, row_ndx, num_values); // Throws
+    for (size_t i = 0; i < num_values; ++i) {
+        if (values[i].is_null()) {
+            append_simple_instr(true); // Throws
+        }
+        else {
+            append_simple_instr(false, values[i]); // Throws
+        }
+    }
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_string_values(const Table* t, size_t col_ndx, size_t row_ndx,
+                                                            const StringData* values, size_t num_values)
+{
+    select_table(t);                                                  // Throws
+    m_encoder.set_string_values(col_ndx, row_ndx, values, num_values); // Throws
+}
+
+inline bool TransactLogEncoder::set_timestamp_values(size_t col_ndx, size_t row_ndx, const Timestamp* values,
+                                                     size_t num_values)
+{
+    append_simple_instr(instr_SetColumnValues, type_Timestamp, col_ndx, row_ndx, num_values); // Throws
+    for (size_t i = 0; i < num_values; ++i) {
+        if (values[i].is_null()) {
+            append_simple_instr(true); // Throws
+        }
+        else {
+            append_simple_instr(false, values[i].get_seconds(), values[i].get_nanoseconds()); // Throws
+        }
+    }
+    return true;
+}
+
+inline void TransactLogConvenientEncoder::set_timestamp_values(const Table* t, size_t col_ndx, size_t row_ndx,
+                                                               const Timestamp* values, size_t num_values)
+{
+    select_table(t);                                                     // Throws
+    m_encoder.set_timestamp_values(col_ndx, row_ndx, values, num_values); // Throws
+}
+
 inline bool TransactLogEncoder::nullify_link(size_t col_ndx, size_t ndx, size_t target_group_level_ndx)
 {
     append_simple_instr(instr_NullifyLink, col_ndx, ndx, target_group_level_ndx); // Throws
@@ -1868,6 +2008,57 @@ void TransactLogParser::parse_one(InstructionHandler& handler)
             parser_error();
             return;
         }
+        case instr_SetColumnValues: {
+            int type = read_int<int>();             // Throws
+            size_t col_ndx = read_int<size_t>();    // Throws
+            size_t row_ndx = read_int<size_t>();    // Throws
+            size_t num_values = read_int<size_t>(); // Throws
+            for (size_t i = 0; i < num_values; ++i) {
+                size_t row_ndx_2 = row_ndx + i;
+                bool is_null = read_bool(); // Throws
+                bool success;
+                if (is_null) {
+                    success = handler.set_null(col_ndx, row_ndx_2, instr_Set, 0); // Throws
+                }
+                else {
+                    switch (DataType(type)) {
+                        case type_Int: {
+                            int_fast64_t value = read_int<int64_t>();                       // Throws
+                            success = handler.set_int(col_ndx, row_ndx_2, value, instr_Set, 0); // Throws
+                            break;
+                        }
+                        case type_Bool: {
+                            bool value = read_bool();                                    // Throws
+                            success = handler.set_bool(col_ndx, row_ndx_2, value, instr_Set); // Throws
+                            break;
+                        }
+                        case type_Double: {
+                            double value = read_double();                                  // Throws
+                            success = handler.set_double(col_ndx, row_ndx_2, value, instr_Set); // Throws
+                            break;
+                        }
+                        case type_String: {
+                            StringData value = read_string(m_string_buffer);                    // Throws
+                            success = handler.set_string(col_ndx, row_ndx_2, value, instr_Set, 0); // Throws
+                            break;
+                        }
+                        case type_Timestamp: {
+                            int64_t seconds = read_int<int64_t>();     // Throws
+                            int32_t nanoseconds = read_int<int32_t>(); // Throws
+                            Timestamp value = Timestamp(seconds, nanoseconds);
+                            success = handler.set_timestamp(col_ndx, row_ndx_2, value, instr_Set); // Throws
+                            break;
+                        }
+                        default:
+                            success = false;
+                            break;
+                    }
+                }
+                if (!success)
+                    parser_error();
+            }
+            return;
+        }
         case instr_AddInteger: {
             size_t col_ndx = read_int<size_t>();           // Throws
             size_t row_ndx = read_int<size_t>();           // Throws
@@ -0,0 +1,171 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <realm/disable_sync_to_disk.hpp>
+#include <realm/util/safe_int_ops.hpp>
+#include <realm/impl/write_ahead_log.hpp>
+
+using namespace realm;
+using namespace realm::util;
+using namespace realm::_impl;
+
+
+namespace {
+
+size_t round_up_to_multiple_of_8(size_t size) noexcept
+{
+    return (size + 7) & ~size_t(7);
+}
+
+} // anonymous namespace
+
+
+void WriteAheadLog::open(const std::string& realm_path)
+{
+    for (int i = 0; i < num_segments; ++i) {
+        std::string path = realm_path + ".wal." + std::to_string(i);
+        m_segments[i].open(path, File::access_ReadWrite, File::create_Auto, 0); // Throws
+    }
+}
+
+
+void WriteAheadLog::close() noexcept
+{
+    for (int i = 0; i < num_segments; ++i)
+        m_segments[i].close();
+}
+
+
+char* WriteAheadLog::prepare_record(size_t changeset_size)
+{
+    size_t size = sizeof(RecordHeader) + round_up_to_multiple_of_8(changeset_size);
+    m_record.reserve(0, size); // Throws
+    m_record_size = size;
+    RecordHeader header;
+    header.version = 0;
+    header.size = changeset_size;
+    header.checksum = 0;
+    std::memcpy(m_record.data(), &header, sizeof header);
+    // Zero the padding, so that records are reproducible
+    std::memset(m_record.data() + size - 8, 0, 8);
+    return m_record.data() + sizeof(RecordHeader);
+}
+
+
+void WriteAheadLog::finalize_record(version_type version) noexcept
+{
+    RecordHeader header;
+    std::memcpy(&header, m_record.data(), sizeof header);
+    header.version = version;
+    header.checksum = compute_checksum(version, m_record.data() + sizeof header, size_t(header.size));
+    std::memcpy(m_record.data(), &header, sizeof header);
+}
+
+
+uint64_t WriteAheadLog::append_record(int segment, uint64_t offset)
+{
+    File& file = m_segments[segment];
+    file.seek(File::SizeType(offset));          // Throws
+    file.write(m_record.data(), m_record_size); // Throws
+    if (!get_disable_sync_to_disk())
+        file.sync(); // Throws
+    return offset + m_record_size;
+}
+
+
+void WriteAheadLog::truncate(int segment)
+{
+    File& file = m_segments[segment];
+    file.resize(0); // Throws
+    if (!get_disable_sync_to_disk())
+        file.sync(); // Throws
+}
+
+
+uint64_t WriteAheadLog::get_size(int segment)
+{
+    return uint64_t(m_segments[segment].get_size()); // Throws
+}
+
+
+void WriteAheadLog::read_changesets(version_type after_version, std::map<version_type, std::string>& changesets)
+{
+    std::map<version_type, std::string> all_changesets;
+    for (int i = 0; i < num_segments; ++i)
+        read_segment(i, all_changesets); // Throws
+
+    version_type next_version = after_version + 1;
+    auto i = all_changesets.find(next_version);
+    while (i != all_changesets.end() && i->first == next_version) {
+        changesets[next_version] = std::move(i->second);
+        ++i;
+        ++next_version;
+    }
+}
+
+
+uint64_t WriteAheadLog::compute_checksum(uint64_t version, const char* data, size_t size) noexcept
+{
+    // 64-bit FNV-1a over the snapshot number, the size, and the changeset
+    uint64_t hash = 14695981039346656037ULL;
+    auto add = [&](const char* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            hash ^= uint64_t(static_cast<unsigned char>(p[i]));
+            hash *= 1099511628211ULL;
+        }
+    };
+    uint64_t size_2 = size;
+    add(reinterpret_cast<const char*>(&version), sizeof version);
+    add(reinterpret_cast<const char*>(&size_2), sizeof size_2);
+    add(data, size);
+    return hash;
+}
+
+
+void WriteAheadLog::read_segment(int segment, std::map<version_type, std::string>& changesets)
+{
+    File& file = m_segments[segment];
+    size_t file_size;
+    if (int_cast_with_overflow_detect(file.get_size(), file_size)) // Throws
+        throw std::runtime_error("Write-ahead log segment too large");
+    std::unique_ptr<char[]> data(new char[file_size]); // Throws
+    file.seek(0);                                       // Throws
+    file_size = file.read(data.get(), file_size);       // Throws
+
+    size_t offset = 0;
+    while (file_size - offset >= sizeof(RecordHeader)) {
+        RecordHeader header;
+        std::memcpy(&header, data.get() + offset, sizeof header);
+        offset += sizeof header;
+        if (header.size > file_size - offset)
+            break; // Partially written
+        size_t size = size_t(header.size);
+        const char* changeset = data.get() + offset;
+        if (header.checksum != compute_checksum(header.version, changeset, size))
+            break; // Partially written
+        changesets[header.version].assign(changeset, size); // Throws
+        size_t padded_size = round_up_to_multiple_of_8(size);
+        if (padded_size > file_size - offset)
+            break;
+        offset += padded_size;
+    }
+}
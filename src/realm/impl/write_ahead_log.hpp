@@ -0,0 +1,114 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#ifndef REALM_IMPL_WRITE_AHEAD_LOG_HPP
+#define REALM_IMPL_WRITE_AHEAD_LOG_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include <realm/util/buffer.hpp>
+#include <realm/util/file.hpp>
+
+namespace realm {
+namespace _impl {
+
+/// The changeset log used by SharedGroupOptions::Durability::Log.
+///
+/// The log consists of two segment files (`<realm path>.wal.0` and
+/// `<realm path>.wal.1`). Commits append a record holding the new snapshot
+/// number and the changeset of the transaction to the active segment, and
+/// sync only that segment. A checkpoint makes the other segment active,
+/// makes the Realm file itself durable up to the last version logged in the
+/// old segment, and then empties the old segment. Where the segments are
+/// appended to, and which one is active, is tracked by the caller, as it is
+/// shared by all session participants.
+///
+/// Each record consists of a header (snapshot number, changeset size and a
+/// checksum) followed by the changeset, padded to a multiple of 8 bytes. A
+/// record that was only partially written at the time of a crash is detected
+/// by the checksum, and ends the segment.
+class WriteAheadLog {
+public:
+    using version_type = uint_fast64_t;
+
+    static constexpr int num_segments = 2;
+
+    /// Open (or create) both segments of the log that belongs to the
+    /// specified Realm file.
+    void open(const std::string& realm_path);
+
+    void close() noexcept;
+
+    bool is_open() const noexcept;
+
+    /// Make room for a changeset of the specified size in the record buffer,
+    /// and return a pointer to where the changeset must be placed.
+    char* prepare_record(size_t changeset_size);
+
+    /// Finalize the record prepared by prepare_record() by giving it the
+    /// specified snapshot number.
+    void finalize_record(version_type version) noexcept;
+
+    /// Write the finalized record to the specified segment at the specified
+    /// offset, and sync the segment to stable storage. Returns the offset
+    /// immediately after the record.
+    uint64_t append_record(int segment, uint64_t offset);
+
+    /// Empty the specified segment.
+    void truncate(int segment);
+
+    /// Get the size of the specified segment file.
+    uint64_t get_size(int segment);
+
+    /// Read the changesets of all intact records in both segments whose
+    /// snapshot numbers are greater than \a after_version, and that form an
+    /// unbroken sequence starting at `after_version + 1`. Records found in
+    /// the log that do not continue that sequence are ignored. They can
+    /// only stem from versions that were already made durable in the Realm
+    /// file.
+    void read_changesets(version_type after_version, std::map<version_type, std::string>& changesets);
+
+private:
+    struct RecordHeader {
+        uint64_t version;
+        uint64_t size;
+        uint64_t checksum;
+    };
+
+    util::File m_segments[num_segments];
+    util::Buffer<char> m_record;
+    size_t m_record_size = 0;
+
+    static uint64_t compute_checksum(uint64_t version, const char* data, size_t size) noexcept;
+    void read_segment(int segment, std::map<version_type, std::string>& changesets);
+};
+
+
+// Implementation:
+
+inline bool WriteAheadLog::is_open() const noexcept
+{
+    return m_segments[0].is_attached();
+}
+
+} // namespace _impl
+} // namespace realm
+
+#endif // REALM_IMPL_WRITE_AHEAD_LOG_HPP
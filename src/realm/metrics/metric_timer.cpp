@@ -48,6 +48,11 @@ void MetricTimerResult::report_seconds(double time)
     m_elapsed_seconds = time;
 }
 
+void MetricTimerTotal::report_seconds(double time)
+{
+    m_elapsed_seconds += time;
+}
+
 
 MetricTimer::MetricTimer(std::shared_ptr<MetricTimerResult> destination)
     : m_dest(destination)
@@ -43,6 +43,14 @@ protected:
 };
 
 
+/// A MetricTimerResult that adds up the times reported to it, for phases that
+/// are timed in several parts.
+class MetricTimerTotal : public MetricTimerResult {
+public:
+    void report_seconds(double time) override;
+};
+
+
 class MetricTimer {
 public:
     MetricTimer(std::shared_ptr<MetricTimerResult> destination = nullptr);
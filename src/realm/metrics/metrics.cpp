@@ -44,6 +44,16 @@ size_t Metrics::num_transaction_metrics() const
     return m_transaction_info ? m_transaction_info->size() : 0;
 }
 
+void Metrics::set_page_size(size_t page_size) noexcept
+{
+    m_page_size = page_size;
+}
+
+size_t Metrics::get_page_size() const noexcept
+{
+    return m_page_size;
+}
+
 void Metrics::add_query(QueryInfo info)
 {
     REALM_ASSERT_DEBUG(m_query_info);
@@ -68,28 +78,38 @@ void Metrics::start_write_transaction()
     m_pending_write = std::make_unique<TransactionInfo>(TransactionInfo::write_transaction);
 }
 
-void Metrics::end_read_transaction(size_t total_size, size_t free_space, size_t num_objects, size_t num_versions)
+void Metrics::end_read_transaction(size_t total_size, size_t free_space, size_t num_objects, size_t num_versions,
+                                  size_t translation_hits, size_t translation_misses)
 {
     REALM_ASSERT_DEBUG(m_transaction_info);
     if (m_pending_read) {
         m_pending_read->update_stats(total_size, free_space, num_objects, num_versions);
+        m_pending_read->update_translation_stats(translation_hits, translation_misses);
         m_pending_read->finish_timer();
         m_transaction_info->push_back(*m_pending_read);
         m_pending_read.reset(nullptr);
     }
 }
 
-void Metrics::end_write_transaction(size_t total_size, size_t free_space, size_t num_objects, size_t num_versions)
+void Metrics::end_write_transaction(size_t total_size, size_t free_space, size_t num_objects, size_t num_versions,
+                                   size_t translation_hits, size_t translation_misses)
 {
     REALM_ASSERT_DEBUG(m_transaction_info);
     if (m_pending_write) {
         m_pending_write->update_stats(total_size, free_space, num_objects, num_versions);
+        m_pending_write->update_translation_stats(translation_hits, translation_misses);
         m_pending_write->finish_timer();
         m_transaction_info->push_back(*m_pending_write);
         m_pending_write.reset(nullptr);
     }
 }
 
+void Metrics::report_flush_lag(size_t unflushed_versions, double lag_seconds)
+{
+    if (m_pending_write)
+        m_pending_write->update_flush_stats(unflushed_versions, lag_seconds);
+}
+
 std::unique_ptr<MetricTimer> Metrics::report_fsync_time(const Group& g)
 {
     std::shared_ptr<Metrics> instance = g.get_metrics();
@@ -116,6 +136,65 @@ std::unique_ptr<MetricTimer> Metrics::report_write_time(const Group& g)
     return nullptr;
 }
 
+void Metrics::report_lock_wait_time(double seconds)
+{
+    if (m_pending_write)
+        m_pending_write->m_lock_wait_time = seconds;
+}
+
+void Metrics::report_write_io(const Group& g, size_t bytes_written, size_t arrays_written, size_t num_sync_calls)
+{
+    std::shared_ptr<Metrics> instance = g.get_metrics();
+    if (instance && instance->m_pending_write)
+        instance->m_pending_write->update_write_io_stats(bytes_written, arrays_written, num_sync_calls);
+}
+
+void Metrics::report_bytes_relocated(const Group& g, size_t bytes_relocated)
+{
+    std::shared_ptr<Metrics> instance = g.get_metrics();
+    if (instance && instance->m_pending_write)
+        instance->m_pending_write->m_bytes_relocated += bytes_relocated;
+}
+
+std::unique_ptr<MetricTimer> Metrics::report_time(const Group& g,
+                                                  std::shared_ptr<MetricTimerResult> TransactionInfo::*result)
+{
+    std::shared_ptr<Metrics> instance = g.get_metrics();
+    if (instance && instance->m_pending_write)
+        return std::make_unique<MetricTimer>(instance->m_pending_write.get()->*result);
+    return nullptr;
+}
+
+std::unique_ptr<MetricTimer> Metrics::report_history_write_time(const Group& g)
+{
+    return report_time(g, &TransactionInfo::m_history_write_time);
+}
+
+std::unique_ptr<MetricTimer> Metrics::report_serialization_time(const Group& g)
+{
+    return report_time(g, &TransactionInfo::m_serialization_time);
+}
+
+std::unique_ptr<MetricTimer> Metrics::report_free_list_time(const Group& g)
+{
+    return report_time(g, &TransactionInfo::m_free_list_time);
+}
+
+std::unique_ptr<MetricTimer> Metrics::report_data_fsync_time(const Group& g)
+{
+    return report_time(g, &TransactionInfo::m_data_fsync_time);
+}
+
+std::unique_ptr<MetricTimer> Metrics::report_header_fsync_time(const Group& g)
+{
+    return report_time(g, &TransactionInfo::m_header_fsync_time);
+}
+
+std::unique_ptr<MetricTimer> Metrics::report_notify_time(const Group& g)
+{
+    return report_time(g, &TransactionInfo::m_notify_time);
+}
+
 
 std::unique_ptr<Metrics::QueryInfoList> Metrics::take_queries()
 {
@@ -46,10 +46,27 @@ public:
 
     void start_read_transaction();
     void start_write_transaction();
-    void end_read_transaction(size_t total_size, size_t free_space, size_t num_objects, size_t num_versions);
-    void end_write_transaction(size_t total_size, size_t free_space, size_t num_objects, size_t num_versions);
+    void end_read_transaction(size_t total_size, size_t free_space, size_t num_objects, size_t num_versions,
+                              size_t translation_hits, size_t translation_misses);
+    void end_write_transaction(size_t total_size, size_t free_space, size_t num_objects, size_t num_versions,
+                               size_t translation_hits, size_t translation_misses);
+    void report_flush_lag(size_t unflushed_versions, double lag_seconds);
     static std::unique_ptr<MetricTimer> report_fsync_time(const Group& g);
     static std::unique_ptr<MetricTimer> report_write_time(const Group& g);
+    void report_lock_wait_time(double seconds);
+    static void report_write_io(const Group& g, size_t bytes_written, size_t arrays_written, size_t num_sync_calls);
+    static void report_bytes_relocated(const Group& g, size_t bytes_relocated);
+    static std::unique_ptr<MetricTimer> report_history_write_time(const Group& g);
+    static std::unique_ptr<MetricTimer> report_serialization_time(const Group& g);
+    static std::unique_ptr<MetricTimer> report_free_list_time(const Group& g);
+    static std::unique_ptr<MetricTimer> report_data_fsync_time(const Group& g);
+    static std::unique_ptr<MetricTimer> report_header_fsync_time(const Group& g);
+    static std::unique_ptr<MetricTimer> report_notify_time(const Group& g);
+
+    // The size of the pages backing the mappings of the Realm file and the
+    // slabs, as requested by the allocator (see SharedGroupOptions::enable_huge_pages).
+    void set_page_size(size_t page_size) noexcept;
+    size_t get_page_size() const noexcept;
 
     using QueryInfoList = std::vector<QueryInfo>;
     using TransactionInfoList = std::vector<TransactionInfo>;
@@ -63,6 +80,11 @@ private:
 
     std::unique_ptr<TransactionInfo> m_pending_read;
     std::unique_ptr<TransactionInfo> m_pending_write;
+
+    size_t m_page_size = 0;
+
+    static std::unique_ptr<MetricTimer> report_time(const Group& g,
+                                                    std::shared_ptr<MetricTimerResult> TransactionInfo::*result);
 };
 
 
@@ -28,10 +28,25 @@ TransactionInfo::TransactionInfo(TransactionInfo::TransactionType type)
     , m_realm_free_space(0)
     , m_total_objects(0)
     , m_type(type)
+    , m_translation_hits(0)
+    , m_translation_misses(0)
+    , m_num_unflushed_versions(0)
+    , m_flush_lag(0)
+    , m_bytes_written(0)
+    , m_num_sync_calls(0)
+    , m_arrays_written(0)
+    , m_bytes_relocated(0)
+    , m_lock_wait_time(0)
 {
     if (m_type == write_transaction) {
         m_fsync_time = std::make_shared<MetricTimerResult>();
         m_write_time = std::make_shared<MetricTimerResult>();
+        m_history_write_time = std::make_shared<MetricTimerTotal>();
+        m_serialization_time = std::make_shared<MetricTimerTotal>();
+        m_free_list_time = std::make_shared<MetricTimerTotal>();
+        m_data_fsync_time = std::make_shared<MetricTimerTotal>();
+        m_header_fsync_time = std::make_shared<MetricTimerTotal>();
+        m_notify_time = std::make_shared<MetricTimerTotal>();
     }
 }
 
@@ -85,6 +100,90 @@ size_t TransactionInfo::get_num_available_versions() const
     return m_num_versions;
 }
 
+size_t TransactionInfo::get_translation_hits() const
+{
+    return m_translation_hits;
+}
+
+size_t TransactionInfo::get_translation_misses() const
+{
+    return m_translation_misses;
+}
+
+size_t TransactionInfo::get_num_unflushed_versions() const
+{
+    return m_num_unflushed_versions;
+}
+
+double TransactionInfo::get_flush_lag() const
+{
+    return m_flush_lag;
+}
+
+size_t TransactionInfo::get_bytes_written() const
+{
+    return m_bytes_written;
+}
+
+size_t TransactionInfo::get_num_sync_calls() const
+{
+    return m_num_sync_calls;
+}
+
+size_t TransactionInfo::get_arrays_written() const
+{
+    return m_arrays_written;
+}
+
+size_t TransactionInfo::get_bytes_relocated() const
+{
+    return m_bytes_relocated;
+}
+
+double TransactionInfo::get_lock_wait_time() const
+{
+    return m_lock_wait_time;
+}
+
+namespace {
+
+double get_elapsed_seconds(const std::shared_ptr<MetricTimerResult>& result)
+{
+    return result ? result->get_elapsed_seconds() : 0;
+}
+
+} // anonymous namespace
+
+double TransactionInfo::get_history_write_time() const
+{
+    return get_elapsed_seconds(m_history_write_time);
+}
+
+double TransactionInfo::get_serialization_time() const
+{
+    return get_elapsed_seconds(m_serialization_time);
+}
+
+double TransactionInfo::get_free_list_time() const
+{
+    return get_elapsed_seconds(m_free_list_time);
+}
+
+double TransactionInfo::get_data_fsync_time() const
+{
+    return get_elapsed_seconds(m_data_fsync_time);
+}
+
+double TransactionInfo::get_header_fsync_time() const
+{
+    return get_elapsed_seconds(m_header_fsync_time);
+}
+
+double TransactionInfo::get_notify_time() const
+{
+    return get_elapsed_seconds(m_notify_time);
+}
+
 void TransactionInfo::update_stats(size_t disk_size, size_t free_space, size_t total_objects, size_t available_versions)
 {
     m_realm_disk_size = disk_size;
@@ -92,6 +191,25 @@ void TransactionInfo::update_stats(size_t disk_size, size_t free_space, size_t t
     m_total_objects = total_objects;
     m_num_versions = available_versions;
 }
+void TransactionInfo::update_translation_stats(size_t hits, size_t misses)
+{
+    m_translation_hits = hits;
+    m_translation_misses = misses;
+}
+
+void TransactionInfo::update_flush_stats(size_t unflushed_versions, double lag_seconds)
+{
+    m_num_unflushed_versions = unflushed_versions;
+    m_flush_lag = lag_seconds;
+}
+
+void TransactionInfo::update_write_io_stats(size_t bytes_written, size_t arrays_written, size_t num_sync_calls)
+{
+    m_bytes_written += bytes_written;
+    m_arrays_written += arrays_written;
+    m_num_sync_calls += num_sync_calls;
+}
+
 void TransactionInfo::finish_timer()
 {
     m_transaction_time.report_seconds(m_transact_timer.get_elapsed_time());
@@ -51,11 +51,53 @@ public:
     size_t get_free_space() const;
     size_t get_total_objects() const;
     size_t get_num_available_versions() const;
+    // ref translations done during the transaction, see SlabAlloc::get_translation_hits()
+    size_t get_translation_hits() const;
+    size_t get_translation_misses() const;
+    // with Durability::Async, the number of committed versions that were not
+    // yet flushed to disk, and the age in seconds of the oldest of them, right
+    // after a write transaction committed
+    size_t get_num_unflushed_versions() const;
+    double get_flush_lag() const;
+    // the number of bytes written to the Realm file by a write transaction,
+    // and the number of system calls made to flush them to stable storage
+    size_t get_bytes_written() const;
+    size_t get_num_sync_calls() const;
+    // the number of arrays written by a write transaction
+    size_t get_arrays_written() const;
+    // the number of bytes of unmodified arrays moved by incremental
+    // compaction, see SharedGroupOptions::compaction_budget
+    size_t get_bytes_relocated() const;
+
+    // Breakdown of the time spent by a write transaction. The time spent
+    // waiting for the write lock precedes the transaction, and is not part of
+    // the transaction time. The rest is part of the commit:
+    // - get_history_write_time(): Replication::prepare_commit(), and capturing
+    //   the changeset for the write-ahead log.
+    // - get_serialization_time(): copying the changed arrays to the file.
+    // - get_free_list_time(): tracking of free space in the file, and writing
+    //   the free-lists and the top array.
+    // - get_data_fsync_time() and get_header_fsync_time(): the two parts of
+    //   get_fsync_time(), before and after the file header is updated.
+    // - get_notify_time(): publishing the new version to readers.
+    double get_lock_wait_time() const;
+    double get_history_write_time() const;
+    double get_serialization_time() const;
+    double get_free_list_time() const;
+    double get_data_fsync_time() const;
+    double get_header_fsync_time() const;
+    double get_notify_time() const;
 
 private:
     MetricTimerResult m_transaction_time;
     std::shared_ptr<MetricTimerResult> m_fsync_time;
     std::shared_ptr<MetricTimerResult> m_write_time;
+    std::shared_ptr<MetricTimerResult> m_history_write_time;
+    std::shared_ptr<MetricTimerResult> m_serialization_time;
+    std::shared_ptr<MetricTimerResult> m_free_list_time;
+    std::shared_ptr<MetricTimerResult> m_data_fsync_time;
+    std::shared_ptr<MetricTimerResult> m_header_fsync_time;
+    std::shared_ptr<MetricTimerResult> m_notify_time;
     MetricTimer m_transact_timer;
 
     size_t m_realm_disk_size;
@@ -63,9 +105,21 @@ private:
     size_t m_total_objects;
     TransactionType m_type;
     size_t m_num_versions;
+    size_t m_translation_hits;
+    size_t m_translation_misses;
+    size_t m_num_unflushed_versions;
+    double m_flush_lag;
+    size_t m_bytes_written;
+    size_t m_num_sync_calls;
+    size_t m_arrays_written;
+    size_t m_bytes_relocated;
+    double m_lock_wait_time;
 
     friend class Metrics;
     void update_stats(size_t disk_size, size_t free_space, size_t total_objects, size_t available_versions);
+    void update_translation_stats(size_t hits, size_t misses);
+    void update_flush_stats(size_t unflushed_versions, double lag_seconds);
+    void update_write_io_stats(size_t bytes_written, size_t arrays_written, size_t num_sync_calls);
     void finish_timer();
 };
 
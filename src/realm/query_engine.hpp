@@ -609,6 +609,11 @@ protected:
         // column only, with no references to other columns:
         bool fastmode = should_run_in_fastmode(source_column);
         for (size_t s = start; s < end;) {
+            if (s >= m_leaf_end || s < m_leaf_start) {
+                s = skip_subtrees(s, end, c);
+                if (s == end)
+                    break;
+            }
             cache_leaf(s);
 
             size_t end_in_leaf;
@@ -708,6 +713,23 @@ protected:
         }
     }
 
+    // Skip leaves of the condition column that cannot contain a match
+    // according to the value bounds kept in its inner B+-tree nodes.
+    size_t skip_subtrees(size_t s, size_t end, int c) const noexcept
+    {
+        return skip_subtrees(s, end, c, m_value);
+    }
+
+    size_t skip_subtrees(size_t s, size_t end, int c, int64_t value) const noexcept
+    {
+        return m_condition_column->find_candidate(c, value, s, end);
+    }
+
+    size_t skip_subtrees(size_t s, size_t, int, const util::Optional<int64_t>&) const noexcept
+    {
+        return s; // Nullable columns carry no bounds
+    }
+
     bool should_run_in_fastmode(SequentialGetterBase* source_column) const
     {
         return (m_children.size() == 1 &&
@@ -778,6 +800,9 @@ public:
 
             // Cache internal leaves
             if (start >= this->m_leaf_end || start < this->m_leaf_start) {
+                start = this->skip_subtrees(start, end, TConditionFunction::condition);
+                if (start == end)
+                    break;
                 this->get_leaf(*this->m_condition_column, start);
             }
 
@@ -134,6 +134,12 @@ public:
             case 2:
                 num_bytes = size;
                 break;
+            case 3: {
+                // Elements are followed by a 64-bit base
+                unsigned num_bits = size * width;
+                num_bytes = (((num_bits + 7) >> 3) + 7) & ~size_t(7);
+                return num_bytes + 8;
+            }
         }
 
         // Ensure 8-byte alignment
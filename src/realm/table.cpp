@@ -1539,7 +1539,9 @@ ColumnBase* Table::create_column_accessor(ColumnType col_type, size_t col_ndx, s
                 col = new IntNullColumn(alloc, ref, col_ndx); // Throws
             }
             else {
-                col = new IntegerColumn(alloc, ref, col_ndx); // Throws
+                IntegerColumn* int_col = new IntegerColumn(alloc, ref, col_ndx); // Throws
+                int_col->enable_bptree_summaries();
+                col = int_col;
             }
             break;
         case col_type_Float:
@@ -2316,6 +2318,189 @@ size_t Table::add_row_with_key(size_t key_col_ndx, int64_t key)
 }
 
 
+size_t Table::append_columns(size_t num_rows, const std::vector<ColumnValues>& columns)
+{
+    if (REALM_UNLIKELY(!is_attached()))
+        throw LogicError(LogicError::detached_accessor);
+    size_t num_cols = m_spec->get_column_count();
+    if (REALM_UNLIKELY(num_cols == 0))
+        throw LogicError(LogicError::table_has_no_columns);
+
+    // Check all the values before anything is modified
+    std::vector<const ColumnValues*> values_by_col(num_cols, nullptr);
+    for (const ColumnValues& values : columns) {
+        size_t col_ndx = values.col_ndx;
+        if (REALM_UNLIKELY(col_ndx >= num_cols))
+            throw LogicError(LogicError::column_index_out_of_range);
+        if (REALM_UNLIKELY(values_by_col[col_ndx]))
+            throw LogicError(LogicError::illegal_combination);
+        int num_arrays = int(bool(values.ints)) + int(bool(values.doubles)) + int(bool(values.strings)) +
+                         int(bool(values.timestamps));
+        bool nullable = is_nullable(col_ndx);
+        bool type_matches = false;
+        bool has_null = false;
+        switch (get_real_column_type(col_ndx)) {
+            case col_type_Int:
+            case col_type_Bool:
+                type_matches = bool(values.ints);
+                break;
+            case col_type_Double:
+                type_matches = bool(values.doubles);
+                break;
+            case col_type_String:
+            case col_type_StringEnum:
+                type_matches = bool(values.strings) && !values.nulls;
+                for (size_t i = 0; type_matches && i < num_rows; ++i) {
+                    if (REALM_UNLIKELY(values.strings[i].size() > max_string_size))
+                        throw LogicError(LogicError::string_too_big);
+                    has_null = has_null || values.strings[i].is_null();
+                }
+                break;
+            case col_type_Timestamp:
+                type_matches = bool(values.timestamps) && !values.nulls;
+                for (size_t i = 0; type_matches && i < num_rows; ++i)
+                    has_null = has_null || values.timestamps[i].is_null();
+                break;
+            default:
+                break;
+        }
+        if (REALM_UNLIKELY(!type_matches || num_arrays != 1))
+            throw LogicError(LogicError::type_mismatch);
+        if (values.nulls)
+            has_null = std::find(values.nulls, values.nulls + num_rows, true) != values.nulls + num_rows;
+        if (REALM_UNLIKELY(has_null && !nullable))
+            throw LogicError(LogicError::column_not_nullable);
+        values_by_col[col_ndx] = &values;
+    }
+
+    size_t row_ndx = m_size;
+    bump_version();
+
+    for (size_t col_ndx = 0; col_ndx != num_cols; ++col_ndx) {
+        if (const ColumnValues* values = values_by_col[col_ndx]) {
+            do_append_column(col_ndx, *values, num_rows); // Throws
+        }
+        else {
+            ColumnBase& col = get_column_base(col_ndx);
+            bool insert_nulls = is_nullable(col_ndx);
+            col.insert_rows(row_ndx, num_rows, m_size, insert_nulls); // Throws
+        }
+    }
+    m_size += num_rows;
+
+    if (Replication* repl = get_repl()) {
+        size_t prior_num_rows = row_ndx;
+        repl->insert_empty_rows(this, row_ndx, num_rows, prior_num_rows); // Throws
+        for (const ColumnValues& values : columns) {
+            size_t col_ndx = values.col_ndx;
+            switch (get_real_column_type(col_ndx)) {
+                case col_type_Int:
+                    repl->set_int_values(this, col_ndx, row_ndx, values.ints, values.nulls, num_rows); // Throws
+                    break;
+                case col_type_Bool:
+                    repl->set_bool_values(this, col_ndx, row_ndx, values.ints, values.nulls, num_rows); // Throws
+                    break;
+                case col_type_Double:
+                    repl->set_double_values(this, col_ndx, row_ndx, values.doubles, values.nulls,
+                                            num_rows); // Throws
+                    break;
+                case col_type_String:
+                case col_type_StringEnum:
+                    repl->set_string_values(this, col_ndx, row_ndx, values.strings, num_rows); // Throws
+                    break;
+                case col_type_Timestamp:
+                    repl->set_timestamp_values(this, col_ndx, row_ndx, values.timestamps, num_rows); // Throws
+                    break;
+                default:
+                    REALM_ASSERT(false);
+            }
+        }
+    }
+
+    return row_ndx;
+}
+
+
+namespace {
+
+// Pass values to a column one leaf's worth at a time, after converting
+// them to the representation used by the column.
+template <class T, class C, class F>
+void append_converted(C& col, size_t num_values, F convert)
+{
+    std::vector<T> buffer(std::min(num_values, size_t(REALM_MAX_BPNODE_SIZE)));
+    for (size_t begin = 0; begin < num_values; begin += buffer.size()) {
+        size_t n = std::min(num_values - begin, buffer.size());
+        for (size_t i = 0; i < n; ++i)
+            buffer[i] = convert(begin + i);
+        col.append(buffer.data(), n); // Throws
+    }
+}
+
+} // anonymous namespace
+
+
+void Table::do_append_column(size_t col_ndx, const ColumnValues& values, size_t num_rows)
+{
+    const bool* nulls = values.nulls;
+    ColumnType type = get_real_column_type(col_ndx);
+    switch (type) {
+        case col_type_Int:
+        case col_type_Bool: {
+            const int64_t* ints = values.ints;
+            bool is_bool = type == col_type_Bool;
+            if (is_nullable(col_ndx)) {
+                auto convert = [=](size_t i) {
+                    if (nulls && nulls[i])
+                        return util::Optional<int64_t>();
+                    return util::make_optional(is_bool ? int64_t(ints[i] != 0) : ints[i]);
+                };
+                append_converted<util::Optional<int64_t>>(get_column_int_null(col_ndx), num_rows, convert); // Throws
+            }
+            else if (is_bool) {
+                auto convert = [=](size_t i) { return int64_t(ints[i] != 0); };
+                append_converted<int64_t>(get_column(col_ndx), num_rows, convert); // Throws
+            }
+            else {
+                get_column(col_ndx).append(ints, num_rows); // Throws
+            }
+            return;
+        }
+        case col_type_Double: {
+            const double* doubles = values.doubles;
+            if (nulls) {
+                auto convert = [=](size_t i) { return nulls[i] ? null::get_null_float<double>() : doubles[i]; };
+                append_converted<double>(get_column_double(col_ndx), num_rows, convert); // Throws
+            }
+            else {
+                get_column_double(col_ndx).append(doubles, num_rows); // Throws
+            }
+            return;
+        }
+        case col_type_String: {
+            // String leaves change their format with the length of the
+            // strings, so these are still added one at a time.
+            StringColumn& col = get_column_string(col_ndx);
+            for (size_t i = 0; i < num_rows; ++i)
+                col.add(values.strings[i]); // Throws
+            return;
+        }
+        case col_type_StringEnum: {
+            StringEnumColumn& col = get_column_string_enum(col_ndx);
+            for (size_t i = 0; i < num_rows; ++i)
+                col.add(values.strings[i]); // Throws
+            return;
+        }
+        case col_type_Timestamp:
+            get_column<TimestampColumn, col_type_Timestamp>(col_ndx).append(values.timestamps, num_rows); // Throws
+            return;
+        default:
+            break;
+    }
+    REALM_ASSERT(false);
+}
+
+
 void Table::erase_row(size_t row_ndx, bool is_move_last_over)
 {
     REALM_ASSERT(is_attached());
@@ -5818,6 +6003,8 @@ void Table::adj_acc_insert_rows(size_t row_ndx, size_t num_rows) noexcept
 
     adj_row_acc_insert_rows(row_ndx, num_rows);
 
+    m_rows_adjusted = true;
+
     // Adjust column and subtable accessors after insertion of new rows
     for (auto& col : m_cols) {
         if (col != nullptr) {
@@ -5835,6 +6022,8 @@ void Table::adj_acc_erase_row(size_t row_ndx) noexcept
 
     adj_row_acc_erase_row(row_ndx);
 
+    m_rows_adjusted = true;
+
     // Adjust subtable accessors after removal of a row
     for (auto& col : m_cols) {
         if (col != nullptr) {
@@ -5851,6 +6040,8 @@ void Table::adj_acc_swap_rows(size_t row_ndx_1, size_t row_ndx_2) noexcept
 
     adj_row_acc_swap_rows(row_ndx_1, row_ndx_2);
 
+    m_rows_adjusted = true;
+
     // Adjust subtable accessors after row swap
     for (auto& col : m_cols) {
         if (col != nullptr) {
@@ -5868,6 +6059,8 @@ void Table::adj_acc_move_row(size_t from_ndx, size_t to_ndx) noexcept
 
     adj_row_acc_move_row(from_ndx, to_ndx);
 
+    m_rows_adjusted = true;
+
     // Adjust subtable accessors after row move
     for (auto& col : m_cols) {
         if (col != nullptr) {
@@ -5885,6 +6078,8 @@ void Table::adj_acc_merge_rows(size_t old_row_ndx, size_t new_row_ndx) noexcept
 
     adj_row_acc_merge_rows(old_row_ndx, new_row_ndx);
 
+    m_rows_adjusted = true;
+
     // Adjust LinkViews for new rows
     for (auto& col : m_cols) {
         if (col) {
@@ -5902,6 +6097,7 @@ void Table::adj_acc_move_over(size_t from_row_ndx, size_t to_row_ndx) noexcept
 
     adj_row_acc_move_over(from_row_ndx, to_row_ndx);
 
+    m_rows_adjusted = true;
     for (auto& col : m_cols) {
         if (col != nullptr) {
             col->adj_acc_move_over(from_row_ndx, to_row_ndx);
@@ -5918,6 +6114,7 @@ void Table::adj_acc_clear_root_table() noexcept
 
     discard_row_accessors();
 
+    m_rows_adjusted = true;
     for (auto& col : m_cols) {
         if (col != nullptr) {
             col->adj_acc_clear_root_table();
@@ -6203,6 +6400,9 @@ void Table::refresh_accessor_tree()
 {
     REALM_ASSERT(is_attached());
 
+    // Unless the spec has changed, only the columns that have changed need to
+    // be refreshed
+    bool skip_unchanged_columns = false;
     if (m_top.is_attached()) {
         // Root table (free-standing table, group-level table, or subtable with
         // independent descriptor)
@@ -6215,6 +6415,9 @@ void Table::refresh_accessor_tree()
                 df::detach_subdesc_accessors(*desc);
             }
         }
+        else {
+            skip_unchanged_columns = !m_rows_adjusted;
+        }
         m_columns.init_from_parent();
     }
     else {
@@ -6241,8 +6444,9 @@ void Table::refresh_accessor_tree()
         }
     }
 
-    refresh_column_accessors(); // Throws
+    refresh_column_accessors(0, skip_unchanged_columns); // Throws
     m_mark = false;
+    m_rows_adjusted = false;
 }
 
 void Table::refresh_spec_accessor()
@@ -6260,7 +6464,7 @@ void Table::refresh_spec_accessor()
     }
 }
 
-void Table::refresh_column_accessors(size_t col_ndx_begin)
+void Table::refresh_column_accessors(size_t col_ndx_begin, bool skip_unchanged)
 {
     // Index of column in Table::m_columns, which is not always equal to the
     // 'logical' column index.
@@ -6275,6 +6479,19 @@ void Table::refresh_column_accessors(size_t col_ndx_begin)
         ColumnAttr attr = m_spec->get_column_attr(col_ndx);
         bool column_has_search_index = (attr & col_attr_Indexed) != 0;
 
+        if (skip_unchanged && col && col->get_ref() == m_columns.get_as_ref(ndx_in_parent)) {
+            const StringIndex* index = col->get_search_index();
+            if (!column_has_search_index) {
+                REALM_ASSERT(!index);
+                ++ndx_in_parent;
+                continue;
+            }
+            if (index && index->get_ref() == m_columns.get_as_ref(ndx_in_parent + 1)) {
+                ndx_in_parent += 2;
+                continue;
+            }
+        }
+
         if (!column_has_search_index && col)
             col->destroy_search_index();
 
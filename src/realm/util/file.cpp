@@ -824,6 +824,60 @@ void File::sync()
 }
 
 
+void File::sync_data()
+{
+#if defined(__linux__) && !REALM_ANDROID
+    REALM_ASSERT_RELEASE(is_attached());
+
+    if (::fdatasync(m_fd) == 0)
+        return;
+    throw std::runtime_error("fdatasync() failed");
+#else
+    sync();
+#endif
+}
+
+
+void File::start_writeback(SizeType offset, size_t size)
+{
+    REALM_ASSERT_RELEASE(is_attached());
+
+#if defined(__linux__) && !REALM_ANDROID
+    REALM_ASSERT_RELEASE(is_writeback_supported());
+
+    // Encrypted data is not laid out linearly in the file, so write back
+    // the whole file
+    if (m_encryption_key) {
+        offset = 0;
+        size = 0;
+    }
+
+    off64_t size2;
+    if (int_cast_with_overflow_detect(size, size2))
+        throw std::runtime_error("File size overflow");
+
+    if (::sync_file_range(m_fd, offset, size2, SYNC_FILE_RANGE_WRITE) == 0)
+        return;
+    int err = errno; // Eliminate any risk of clobbering
+    throw std::runtime_error(get_errno_msg("sync_file_range() failed: ", err));
+#else
+    static_cast<void>(offset);
+    static_cast<void>(size);
+    REALM_ASSERT_RELEASE(is_writeback_supported());
+#endif
+}
+
+
+bool File::is_writeback_supported()
+{
+#if defined(__linux__) && !REALM_ANDROID
+    return true;
+#else
+    return false;
+#endif
+}
+
+
 bool File::lock(bool exclusive, bool non_blocking)
 {
     REALM_ASSERT_RELEASE(is_attached());
@@ -925,15 +979,17 @@ void File::unlock() noexcept
 }
 
 
-void* File::map(AccessMode a, size_t size, int /*map_flags*/, size_t offset) const
+void* File::map(AccessMode a, size_t size, int map_flags, size_t offset) const
 {
-    return realm::util::mmap(m_fd, size, a, offset, m_encryption_key.get());
+    bool huge_pages = (map_flags & map_HugePages) != 0;
+    return realm::util::mmap(m_fd, size, a, offset, m_encryption_key.get(), huge_pages);
 }
 
 #if REALM_ENABLE_ENCRYPTION
-void* File::map(AccessMode a, size_t size, EncryptedFileMapping*& mapping, int /*map_flags*/, size_t offset) const
+void* File::map(AccessMode a, size_t size, EncryptedFileMapping*& mapping, int map_flags, size_t offset) const
 {
-    return realm::util::mmap(m_fd, size, a, offset, m_encryption_key.get(), mapping);
+    bool huge_pages = (map_flags & map_HugePages) != 0;
+    return realm::util::mmap(m_fd, size, a, offset, m_encryption_key.get(), mapping, huge_pages);
 }
 #endif
 
@@ -943,10 +999,16 @@ void File::unmap(void* addr, size_t size) noexcept
 }
 
 
-void* File::remap(void* old_addr, size_t old_size, AccessMode a, size_t new_size, int /*map_flags*/,
+void* File::remap(void* old_addr, size_t old_size, AccessMode a, size_t new_size, int map_flags,
                   size_t file_offset) const
 {
-    return realm::util::mremap(m_fd, file_offset, old_addr, old_size, a, new_size, m_encryption_key.get());
+    void* new_addr = realm::util::mremap(m_fd, file_offset, old_addr, old_size, a, new_size,
+                                         m_encryption_key.get());
+    // The kernel may move the mapping, so the alignment is not guaranteed
+    // here, but the advice still applies to every aligned 2MB range within it.
+    if (map_flags & map_HugePages)
+        realm::util::advise_huge_pages(new_addr, new_size);
+    return new_addr;
 }
 
 
@@ -320,6 +320,27 @@ public:
     /// `F_FULLFSYNC`.
     void sync();
 
+    /// Like sync(), but may skip metadata that is not needed for reading the
+    /// contents back, such as the modification time. On Linux this function
+    /// calls `fdatasync()`, elsewhere it is the same as sync().
+    void sync_data();
+
+    /// Start writing the dirty pages in the specified range of the file to the
+    /// storage device, including pages that were modified through memory
+    /// mappings, without waiting for it to complete. This does not make the
+    /// data durable, but a subsequent sync() or sync_data() has less to wait
+    /// for. Ranges are best passed in ascending order. On Linux this function
+    /// calls `sync_file_range()`.
+    ///
+    /// Must only be called when is_writeback_supported() returns true.
+    void start_writeback(SizeType offset, size_t size);
+
+    /// Returns true if start_writeback() is supported, and sync() and
+    /// sync_data() also write out pages that were modified through memory
+    /// mappings of the file, so that those need not be synchronized
+    /// individually (see File::Map::sync()).
+    static bool is_writeback_supported();
+
     /// Place an exclusive lock on this file. This blocks the caller
     /// until all other locks have been released.
     ///
@@ -372,7 +393,13 @@ public:
         /// the default behavior. An explicit call to sync_map() will
         /// flush the buffers regardless of whether this flag is
         /// specified or not.
-        map_NoSync = 1
+        map_NoSync = 1,
+
+        /// If possible, place the mapping at an address that allows it
+        /// to be backed by transparent huge pages, and advise the system
+        /// to do so. This is only a hint; it has no effect on systems
+        /// that do not support it.
+        map_HugePages = 2
     };
 
     /// Map this file into memory. The file is mapped as shared
@@ -24,6 +24,8 @@
 #include <windows.h>
 #else
 #include <cerrno>
+#include <fstream>
+#include <string>
 #include <sys/mman.h>
 #include <unistd.h>
 #endif
@@ -69,6 +71,42 @@ inline bool is_mmap_memory_error(int err)
     return (err == EAGAIN || err == EMFILE || err == ENOMEM);
 }
 
+#ifndef _WIN32
+
+// Reserve a range of address space in which a mapping of `size` bytes can be
+// placed at an address that is congruent to `offset` modulo huge_page_size,
+// which is what allows the system to back it with huge pages. Returns the
+// address at which the mapping must be placed with MAP_FIXED.
+char* reserve_huge_page_aligned(size_t size, size_t offset)
+{
+    using realm::util::huge_page_size;
+    size_t reserved_size = size + huge_page_size;
+    void* addr = ::mmap(nullptr, reserved_size, PROT_NONE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (addr == MAP_FAILED) {
+        int err = errno; // Eliminate any risk of clobbering
+        if (is_mmap_memory_error(err)) {
+            throw realm::AddressSpaceExhausted(realm::util::get_errno_msg("mmap() failed: ", err) + " size: " +
+                                               realm::util::to_string(reserved_size));
+        }
+        throw std::runtime_error(realm::util::get_errno_msg("mmap() failed: ", err) +
+                                 " size: " + realm::util::to_string(reserved_size));
+    }
+
+    // Release the parts of the reservation that the mapping will not cover
+    char* begin = static_cast<char*>(addr);
+    size_t head = (offset - reinterpret_cast<uintptr_t>(begin)) & (huge_page_size - 1);
+    char* aligned = begin + head;
+    size_t page_mask = realm::util::page_size() - 1;
+    char* aligned_end = aligned + ((size + page_mask) & ~page_mask);
+    if (head != 0)
+        ::munmap(begin, head);
+    if (aligned_end != begin + reserved_size)
+        ::munmap(aligned_end, begin + reserved_size - aligned_end);
+    return aligned;
+}
+
+#endif
+
 } // Unnamed namespace
 
 using namespace realm;
@@ -282,29 +320,80 @@ size_t round_up_to_page_size(size_t size) noexcept
 }
 
 void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key,
-           EncryptedFileMapping*& mapping)
+           EncryptedFileMapping*& mapping, bool huge_pages)
 {
     if (encryption_key) {
         size = round_up_to_page_size(size);
-        void* addr = mmap_anon(size);
+        void* addr = huge_pages ? mmap_anon_huge_pages(size) : mmap_anon(size);
         mapping = add_mapping(addr, size, fd, offset, access, encryption_key);
         return addr;
     }
     else {
         mapping = nullptr;
-        return mmap(fd, size, access, offset, nullptr);
+        return mmap(fd, size, access, offset, nullptr, huge_pages);
     }
 }
 
 #endif // enable encryption
 
 
-void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key)
+bool huge_pages_supported()
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    static bool supported = [] {
+        std::ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string modes;
+        std::getline(in, modes);
+        return modes.find("[always]") != std::string::npos || modes.find("[madvise]") != std::string::npos;
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+
+bool advise_huge_pages(void* addr, size_t size) noexcept
+{
+#ifdef MADV_HUGEPAGE
+    return ::madvise(addr, size, MADV_HUGEPAGE) == 0;
+#else
+    static_cast<void>(addr);
+    static_cast<void>(size);
+    return false;
+#endif
+}
+
+
+void* mmap_anon_huge_pages(size_t size)
+{
+#ifdef _WIN32
+    static_cast<void>(size);
+    throw std::runtime_error("Huge pages are not supported");
+#else
+    char* hint = reserve_huge_page_aligned(size, 0); // Throws
+    void* addr = ::mmap(hint, size, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE | MAP_FIXED, -1, 0);
+    if (addr == MAP_FAILED) {
+        int err = errno; // Eliminate any risk of clobbering
+        ::munmap(hint, size);
+        if (is_mmap_memory_error(err)) {
+            throw AddressSpaceExhausted(get_errno_msg("mmap() failed: ", err) + " size: " + util::to_string(size));
+        }
+        throw std::runtime_error(get_errno_msg("mmap() failed: ", err) + " size: " + util::to_string(size));
+    }
+    advise_huge_pages(addr, size);
+    return addr;
+#endif
+}
+
+
+void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key,
+           bool huge_pages)
 {
 #if REALM_ENABLE_ENCRYPTION
     if (encryption_key) {
         size = round_up_to_page_size(size);
-        void* addr = mmap_anon(size);
+        void* addr = huge_pages ? mmap_anon_huge_pages(size) : mmap_anon(size);
         add_mapping(addr, size, fd, offset, access, encryption_key);
         return addr;
     }
@@ -324,11 +413,22 @@ void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, con
                 break;
         }
 
-        void* addr = ::mmap(nullptr, size, prot, MAP_SHARED, fd, offset);
-        if (addr != MAP_FAILED)
+        void* hint = nullptr;
+        int flags = MAP_SHARED;
+        if (huge_pages) {
+            hint = reserve_huge_page_aligned(size, offset); // Throws
+            flags |= MAP_FIXED;
+        }
+        void* addr = ::mmap(hint, size, prot, flags, fd, offset);
+        if (addr != MAP_FAILED) {
+            if (huge_pages)
+                advise_huge_pages(addr, size);
             return addr;
+        }
 
         int err = errno; // Eliminate any risk of clobbering
+        if (huge_pages)
+            ::munmap(hint, size);
         if (is_mmap_memory_error(err)) {
             throw AddressSpaceExhausted(get_errno_msg("mmap() failed: ", err) + " size: " + util::to_string(size) +
                                         " offset: " + util::to_string(offset));
@@ -339,6 +439,7 @@ void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, con
 
 #else
         // FIXME: Is there anything that we must do on Windows to honor map_NoSync?
+        static_cast<void>(huge_pages);
 
         DWORD protect = PAGE_READONLY;
         DWORD desired_access = FILE_MAP_READ;
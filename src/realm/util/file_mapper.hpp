@@ -27,12 +27,32 @@
 namespace realm {
 namespace util {
 
-void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key);
+/// If \a huge_pages is true, the mapping is placed at an address that is
+/// congruent to \a offset modulo huge_page_size, and the system is advised to
+/// back it with transparent huge pages.
+void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key,
+           bool huge_pages = false);
 void munmap(void* addr, size_t size) noexcept;
 void* mremap(FileDesc fd, size_t file_offset, void* old_addr, size_t old_size, File::AccessMode a, size_t new_size,
              const char* encryption_key);
 void msync(FileDesc fd, void* addr, size_t size);
 
+/// The size of the pages requested by File::map_HugePages.
+const size_t huge_page_size = 2 * 1024 * 1024;
+
+/// Returns true if the system can back memory mappings with transparent huge
+/// pages on request.
+bool huge_pages_supported();
+
+/// Advise the system to back the specified range with transparent huge pages.
+/// Returns false if the advice was rejected.
+bool advise_huge_pages(void* addr, size_t size) noexcept;
+
+/// Map zero-filled anonymous memory at an address that is aligned to
+/// huge_page_size, and advise the system to back it with transparent huge
+/// pages. The memory must be released with munmap().
+void* mmap_anon_huge_pages(size_t size);
+
 // A function which may be given to encryption_read_barrier. If present, the read barrier is a
 // a barrier for a full array. If absent, the read barrier is a barrier only for the address
 // range give as argument. If the barrier is for a full array, it will read the array header
@@ -46,7 +66,7 @@ class EncryptedFileMapping;
 // This variant allows the caller to obtain direct access to the encrypted file mapping
 // for optimization purposes.
 void* mmap(FileDesc fd, size_t size, File::AccessMode access, size_t offset, const char* encryption_key,
-           EncryptedFileMapping*& mapping);
+           EncryptedFileMapping*& mapping, bool huge_pages = false);
 
 void do_encryption_read_barrier(const void* addr, size_t size, HeaderToSize header_to_size,
                                 EncryptedFileMapping* mapping);
@@ -61,6 +61,31 @@ inline unsigned long long _xgetbv(unsigned index)
 #endif
 }
 
+// Returns EBX of CPUID leaf 7 (structured extended feature flags), or 0 if the leaf is not available
+inline unsigned int cpuid_leaf7_ebx()
+{
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    __asm__ __volatile__("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+    if (eax < 7)
+        return 0;
+    eax = 7;
+    ecx = 0;
+    __asm__ __volatile__("cpuid" : "+a"(eax), "=b"(ebx), "+c"(ecx), "=d"(edx));
+    return ebx;
+}
+
+#elif defined REALM_COMPILER_AVX && defined _MSC_VER
+
+inline unsigned int cpuid_leaf7_ebx()
+{
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return 0;
+    __cpuidex(info, 7, 0);
+    return static_cast<unsigned int>(info[1]);
+}
+
 #endif
 #endif
 #endif
@@ -107,6 +132,8 @@ void cpuid_init()
     }
 
     bool avxSupported = false;
+    bool avx2Supported = false;
+    bool avx512Supported = false;
 
 // seems like in jenkins builds, __GNUC__ is defined for clang?! todo fixme
 #if !defined __clang__ && ((defined(_MSC_FULL_VER) && _MSC_FULL_VER >= 160040219) || defined __GNUC__)
@@ -116,19 +143,30 @@ void cpuid_init()
     if (osUsesXSAVE_XRSTORE && cpuAVXSuport) {
         // Check if the OS will save the YMM registers
         unsigned long long xcrFeatureMask = _xgetbv(_XCR_XFEATURE_ENABLED_MASK);
-        avxSupported = (xcrFeatureMask & 0x6) || false;
+        avxSupported = (xcrFeatureMask & 0x6) == 0x6;
+
+        // AVX2 is bit 5 of leaf 7 EBX. AVX-512 needs both the F (bit 16) and BW (bit 30) subsets, and the OS must
+        // also save the opmask and upper ZMM registers (XCR0 bits 5-7)
+        unsigned int leaf7 = cpuid_leaf7_ebx();
+        avx2Supported = avxSupported && (leaf7 & (1 << 5)) != 0;
+        avx512Supported = avx2Supported && (leaf7 & (1 << 16)) != 0 && (leaf7 & (1u << 30)) != 0 &&
+                          (xcrFeatureMask & 0xe0) == 0xe0;
     }
 #endif
 
-    if (avxSupported) {
+    if (avx512Supported) {
+        avx_support = 2; // AVX-512 (F + BW) supported
+    }
+    else if (avx2Supported) {
+        avx_support = 1; // AVX2 supported
+    }
+    else if (avxSupported) {
         avx_support = 0; // AVX1 supported
     }
     else {
         avx_support = -1; // No AVX supported
     }
 
-// 1 is reserved for AVX2
-
 #endif
 }
 
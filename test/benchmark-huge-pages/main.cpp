@@ -0,0 +1,198 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <realm.hpp>
+#include <realm/group_shared.hpp>
+#include <realm/util/file.hpp>
+#include <realm/util/file_mapper.hpp>
+
+#include "../util/timer.hpp"
+#include "../util/random.hpp"
+#include "../util/benchmark_results.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace realm;
+using namespace realm::util;
+using namespace realm::test_util;
+
+
+namespace {
+
+const size_t num_rows = 4 * 1024 * 1024;
+const size_t num_random_reads = 1024 * 1024;
+const int num_reps = 5;
+
+// Counts data TLB read misses of the calling thread, where the system permits
+// it. Otherwise, available() returns false, and the counts are zero.
+class TLBMissCounter {
+public:
+    TLBMissCounter()
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~TLBMissCounter()
+    {
+#ifdef __linux__
+        if (m_fd >= 0)
+            close(m_fd);
+#endif
+    }
+
+    bool available() const
+    {
+        return m_fd >= 0;
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t stop()
+    {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (m_fd >= 0) {
+            ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(m_fd, &count, sizeof count) != sizeof count)
+                count = 0;
+        }
+#endif
+        return count;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+void populate(const std::string& path)
+{
+    SharedGroup sg(path);
+    WriteTransaction wt(sg);
+    TableRef table = wt.add_table("IntTable");
+    table->add_column(type_Int, "i");
+    table->add_empty_row(num_rows);
+    Random random;
+    for (size_t i = 0; i != num_rows; ++i)
+        table->set_int(0, i, random.draw_int<int64_t>());
+    wt.commit();
+}
+
+void run(BenchmarkResults& results, const std::string& path, bool huge_pages, const std::vector<size_t>& order)
+{
+    SharedGroupOptions options;
+    options.enable_huge_pages = huge_pages;
+    SharedGroup sg(path, false, options);
+    ReadTransaction rt(sg);
+    ConstTableRef table = rt.get_table("IntTable");
+
+    const char* suffix = huge_pages ? "_huge" : "_regular";
+    const char* desc_suffix = huge_pages ? " (huge pages)" : " (regular pages)";
+    TLBMissCounter tlb_misses;
+    Timer timer(Timer::type_UserTime);
+    int_fast64_t dummy = 0;
+
+    std::string id = std::string("scan") + suffix;
+    uint64_t scan_misses = 0;
+    for (int i = 0; i != num_reps; ++i) {
+        tlb_misses.start();
+        timer.reset();
+        dummy += table->sum_int(0);
+        results.submit(id.c_str(), timer);
+        scan_misses += tlb_misses.stop();
+    }
+    results.finish(id, std::string("Scan") + desc_suffix);
+
+    id = std::string("read_random") + suffix;
+    uint64_t random_misses = 0;
+    for (int i = 0; i != num_reps; ++i) {
+        tlb_misses.start();
+        timer.reset();
+        for (size_t ndx : order)
+            dummy += table->get_int(0, ndx);
+        results.submit(id.c_str(), timer);
+        random_misses += tlb_misses.stop();
+    }
+    results.finish(id, std::string("Random read") + desc_suffix);
+
+    if (tlb_misses.available()) {
+        std::cout << "dTLB misses per scan" << desc_suffix << ": " << scan_misses / num_reps << "\n";
+        std::cout << "dTLB misses per random read pass" << desc_suffix << ": " << random_misses / num_reps << "\n";
+    }
+    // Prevent the compiler from optimizing the reads away
+    if (dummy == 0)
+        std::cout << "\n";
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+    std::cout << "Number of rows: " << num_rows << "\n";
+    if (!huge_pages_supported())
+        std::cout << "Transparent huge pages are not supported on this system\n";
+
+    std::string path = "benchmark-huge-pages.realm";
+    File::try_remove(path);
+    File::try_remove(path + ".lock");
+    populate(path);
+
+    std::vector<size_t> order;
+    Random random;
+    for (size_t i = 0; i != num_random_reads; ++i)
+        order.push_back(random.draw_int_mod(num_rows));
+
+    int max_lead_text_size = 32;
+    BenchmarkResults results(max_lead_text_size);
+    run(results, path, false, order);
+    run(results, path, true, order);
+
+    File::try_remove(path);
+    File::try_remove(path + ".lock");
+    return 0;
+}
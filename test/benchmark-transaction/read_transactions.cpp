@@ -0,0 +1,138 @@
+/*************************************************************************
+ *
+ * Copyright 2016 Realm Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************/
+
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <realm.hpp>
+#include <realm/group_shared.hpp>
+#include <realm/util/file.hpp>
+
+#include "../util/timer.hpp"
+#include "../util/benchmark_results.hpp"
+
+using namespace realm;
+using namespace realm::util;
+using namespace realm::test_util;
+
+
+// Measures the cost of short read transactions, begin_read() immediately
+// followed by end_read(), as the number of threads doing them concurrently
+// grows. Every thread has its own SharedGroup, so the threads only contend on
+// the reader ringbuffer in the lock file. Ideally the time for a fixed number
+// of transactions per thread does not depend on the number of threads, as long
+// as there are enough cores.
+
+namespace {
+
+const int max_num_threads = 64;
+const int num_transactions_per_thread = 10000;
+const int num_reps = 3;
+
+void populate(const std::string& path)
+{
+    SharedGroup sg(path);
+    WriteTransaction wt(sg);
+    TableRef table = wt.add_table("IntTable");
+    table->add_column(type_Int, "i");
+    table->add_empty_row(1000);
+    wt.commit();
+}
+
+class StartGate {
+public:
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [&] { return m_open; });
+    }
+
+    void open()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = true;
+        m_cond.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_open = false;
+};
+
+void run(BenchmarkResults& results, const std::string& path, int num_threads)
+{
+    // Open all the SharedGroups up front, so that only the transactions are
+    // timed
+    std::vector<std::unique_ptr<SharedGroup>> shared_groups;
+    for (int i = 0; i != num_threads; ++i)
+        shared_groups.emplace_back(new SharedGroup(path));
+
+    std::string id = "begin_end_read_" + std::to_string(num_threads);
+    for (int rep = 0; rep != num_reps; ++rep) {
+        StartGate gate;
+        std::vector<std::thread> threads;
+        for (int i = 0; i != num_threads; ++i) {
+            SharedGroup& sg = *shared_groups[i];
+            threads.emplace_back([&gate, &sg] {
+                gate.wait();
+                for (int j = 0; j != num_transactions_per_thread; ++j) {
+                    sg.begin_read();
+                    sg.end_read();
+                }
+            });
+        }
+        Timer timer(Timer::type_RealTime);
+        gate.open();
+        for (auto& thread : threads)
+            thread.join();
+        results.submit(id.c_str(), timer);
+    }
+    std::string lead_text = "Begin/end read, " + std::to_string(num_threads) + " thread";
+    if (num_threads != 1)
+        lead_text += "s";
+    results.finish(id, lead_text);
+}
+
+} // anonymous namespace
+
+
+int main()
+{
+    std::cout << "Read transactions per thread: " << num_transactions_per_thread << "\n";
+    std::cout << "Hardware concurrency: " << std::thread::hardware_concurrency() << "\n";
+
+    std::string path = "benchmark-transaction.realm";
+    File::try_remove(path);
+    File::try_remove(path + ".lock");
+    populate(path);
+
+    int max_lead_text_size = 32;
+    BenchmarkResults results(max_lead_text_size);
+    for (int num_threads = 1; num_threads <= max_num_threads; num_threads *= 2)
+        run(results, path, num_threads);
+
+    File::try_remove(path);
+    File::try_remove(path + ".lock");
+    return 0;
+}
@@ -29,6 +29,7 @@
 
 using namespace realm;
 using namespace realm::util;
+using namespace realm::test_util;
 
 
 // Test independence and thread-safety
@@ -305,6 +306,86 @@ TEST(Alloc_Fuzzy)
     }
 }
 
+TEST(Alloc_Coalescing)
+{
+    // Fill exactly one slab with small blocks, free them in random order, and
+    // check that they are merged back into a single chunk that can satisfy a
+    // request for the entire slab.
+    SlabAlloc alloc;
+    alloc.attach_empty();
+    const size_t slab_size = page_size();
+    const size_t block_size = 64;
+    std::vector<MemRef> refs;
+    for (size_t i = 0; i < slab_size / block_size; ++i) {
+        MemRef r = alloc.alloc(block_size);
+        set_capacity(r.get_addr(), block_size);
+        refs.push_back(r);
+    }
+    ref_type begin = refs.front().get_ref(), end = begin;
+    for (MemRef& r : refs) {
+        begin = std::min(begin, r.get_ref());
+        end = std::max(end, r.get_ref() + block_size);
+    }
+    CHECK_EQUAL(slab_size, end - begin);
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    random.shuffle(refs.begin(), refs.end());
+    for (MemRef& r : refs)
+        alloc.free_(r.get_ref(), r.get_addr());
+
+    MemRef whole = alloc.alloc(slab_size);
+    CHECK_EQUAL(begin, whole.get_ref());
+    set_capacity(whole.get_addr(), slab_size);
+
+    // The first slab is full, so this goes into a new one
+    MemRef small = alloc.alloc(24);
+    set_capacity(small.get_addr(), 24);
+    CHECK_GREATER_EQUAL(small.get_ref(), end);
+
+    // Requests are served from the smallest size class that fits, which
+    // leaves the whole first slab available for a large request
+    alloc.free_(whole.get_ref(), whole.get_addr());
+    MemRef medium = alloc.alloc(200);
+    set_capacity(medium.get_addr(), 200);
+    CHECK_GREATER_EQUAL(medium.get_ref(), end);
+    whole = alloc.alloc(slab_size);
+    CHECK_EQUAL(begin, whole.get_ref());
+    set_capacity(whole.get_addr(), slab_size);
+
+    alloc.free_(small.get_ref(), small.get_addr());
+    alloc.free_(medium.get_ref(), medium.get_addr());
+    alloc.free_(whole.get_ref(), whole.get_addr());
+}
+
+TEST(Alloc_TranslationStats)
+{
+    SlabAlloc alloc;
+    alloc.attach_empty();
+    MemRef mr = alloc.alloc(8);
+    set_capacity(mr.get_addr(), 8);
+    alloc.reset_translation_stats();
+
+    // The first translation of a ref into a slab requires a search of the
+    // slabs, after which the result is cached
+    CHECK_EQUAL(static_cast<void*>(mr.get_addr()), alloc.translate(mr.get_ref()));
+    CHECK_EQUAL(0, alloc.get_translation_hits());
+    CHECK_EQUAL(1, alloc.get_translation_misses());
+    CHECK_EQUAL(static_cast<void*>(mr.get_addr()), alloc.translate(mr.get_ref()));
+    CHECK_EQUAL(1, alloc.get_translation_hits());
+    CHECK_EQUAL(1, alloc.get_translation_misses());
+
+    // Resetting the free space tracking invalidates the cache
+    alloc.reset_free_space_tracking();
+    CHECK_EQUAL(static_cast<void*>(mr.get_addr()), alloc.translate(mr.get_ref()));
+    CHECK_EQUAL(1, alloc.get_translation_hits());
+    CHECK_EQUAL(2, alloc.get_translation_misses());
+
+    alloc.reset_translation_stats();
+    CHECK_EQUAL(0, alloc.get_translation_hits());
+    CHECK_EQUAL(0, alloc.get_translation_misses());
+}
+
+
 namespace {
 
 class TestSlabAlloc : public SlabAlloc
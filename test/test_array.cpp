@@ -903,6 +903,219 @@ TEST(Array_find_sse)
 }
 
 
+namespace {
+
+template <class Cond>
+void check_find_vectorized(TestContext& test_context, const Array& a, const std::vector<int64_t>& values,
+                           int64_t value, size_t start, size_t end)
+{
+    Cond c;
+    size_t expected_count = 0;
+    int64_t expected_sum = 0;
+    size_t expected_first = not_found;
+    for (size_t i = start; i < end; ++i) {
+        if (c(values[i], value)) {
+            ++expected_count;
+            expected_sum += values[i];
+            if (expected_first == not_found)
+                expected_first = i;
+        }
+    }
+
+    QueryState<int64_t> state;
+    state.init(act_Count, nullptr, size_t(-1));
+    a.find<Cond>(act_Count, value, start, end, 0, &state);
+    CHECK_EQUAL(expected_count, size_t(state.m_state));
+
+    state.init(act_Sum, nullptr, size_t(-1));
+    a.find<Cond>(act_Sum, value, start, end, 0, &state);
+    CHECK_EQUAL(expected_sum, state.m_state);
+
+    state.init(act_ReturnFirst, nullptr, 1);
+    a.find<Cond>(act_ReturnFirst, value, start, end, 0, &state);
+    CHECK_EQUAL(expected_first, size_t(state.m_state));
+
+    // A limit must stop the search even when matches are consumed a whole vector at a time
+    if (expected_count > 3) {
+        state.init(act_Count, nullptr, 3);
+        a.find<Cond>(act_Count, value, start, end, 0, &state);
+        CHECK_EQUAL(3, size_t(state.m_state));
+    }
+}
+
+} // anonymous namespace
+
+// Compares Equal/NotEqual/Greater/Less against a brute-force scan for every vectorized bit width, with start and end
+// offsets that leave both partial and whole SIMD chunks (SSE, AVX2 or AVX-512 depending on the CPU)
+TEST(Array_FindVectorized)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const int64_t bounds[] = {100, 30000, 2000000000LL, 8000000000LL}; // widths 8, 16, 32 and 64
+
+    for (int64_t bound : bounds) {
+        Array a(Allocator::get_default());
+        a.create(Array::type_Normal);
+        std::vector<int64_t> values;
+
+        for (size_t i = 0; i < 300; ++i) {
+            // Few distinct values so that all conditions get a fair share of matches
+            int64_t v = bound - random.draw_int_mod(8) * (bound / 4);
+            a.add(v);
+            values.push_back(v);
+        }
+
+        for (size_t start = 0; start < 70; start += 13) {
+            for (size_t end = 300; end > start + 150; end -= 37) {
+                int64_t value = bound - random.draw_int_mod(8) * (bound / 4);
+                check_find_vectorized<Equal>(test_context, a, values, value, start, end);
+                check_find_vectorized<NotEqual>(test_context, a, values, value, start, end);
+                check_find_vectorized<Greater>(test_context, a, values, value, start, end);
+                check_find_vectorized<Less>(test_context, a, values, value, start, end);
+            }
+        }
+        a.destroy();
+    }
+}
+
+
+// Checks sum(), maximum(), minimum() and count() against a brute-force scan for every bit width, over ranges long
+// enough to reach the vectorized kernels and with unaligned start and end offsets
+TEST(Array_AggregatesVectorized)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const int64_t bounds[] = {1, 3, 15, 100, 30000, 2000000000LL, 8000000000LL};
+
+    for (int64_t bound : bounds) {
+        Array a(Allocator::get_default());
+        a.create(Array::type_Normal);
+        std::vector<int64_t> values;
+
+        for (size_t i = 0; i < 500; ++i) {
+            // Widths below 8 bits only hold non-negative values
+            int64_t v = bound < 16 ? random.draw_int(int64_t(0), bound) : random.draw_int(-bound, bound);
+            a.add(v);
+            values.push_back(v);
+        }
+
+        for (size_t start = 0; start < 100; start += 21) {
+            for (size_t end = 500; end > start + 100; end -= 97) {
+                int64_t expected_sum = 0;
+                size_t expected_max_ndx = start, expected_min_ndx = start;
+                for (size_t i = start; i < end; ++i) {
+                    expected_sum += values[i];
+                    if (values[i] > values[expected_max_ndx])
+                        expected_max_ndx = i;
+                    if (values[i] < values[expected_min_ndx])
+                        expected_min_ndx = i;
+                }
+
+                CHECK_EQUAL(expected_sum, a.sum(start, end));
+
+                int64_t result;
+                size_t ndx;
+                CHECK(a.maximum(result, start, end, &ndx));
+                CHECK_EQUAL(values[expected_max_ndx], result);
+                CHECK_EQUAL(expected_max_ndx, ndx);
+                CHECK(a.minimum(result, start, end, &ndx));
+                CHECK_EQUAL(values[expected_min_ndx], result);
+                CHECK_EQUAL(expected_min_ndx, ndx);
+            }
+        }
+
+        int64_t value = values[random.draw_int_mod(values.size())];
+        CHECK_EQUAL(size_t(std::count(values.begin(), values.end(), value)), a.count(value));
+
+        a.destroy();
+    }
+}
+
+
+// Epoch timestamps need 64 bits as plain values, but only a few bits in the frame-of-reference form
+TEST(Array_CompressWithBase)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const int64_t base = 1500000000000LL;
+    const size_t n = 1000;
+
+    Array a(Allocator::get_default());
+    a.create(Array::type_Normal);
+    std::vector<int64_t> values;
+    for (size_t i = 0; i < n; ++i) {
+        int64_t v = base + int64_t(i) * 10 + random.draw_int(int64_t(0), int64_t(9));
+        a.add(v);
+        values.push_back(v);
+    }
+    size_t plain_byte_size = a.get_byte_size();
+
+    CHECK(a.compress_with_base());
+    CHECK(a.has_base());
+    CHECK_LESS(a.get_byte_size() * 3, plain_byte_size);
+    CHECK(!a.compress_with_base());
+
+    for (size_t i = 0; i < n; ++i) {
+        CHECK_EQUAL(values[i], a.get(i));
+        CHECK_EQUAL(values[i], Array::get(a.get_mem().get_addr(), i));
+    }
+    int64_t chunk[8];
+    a.get_chunk(n - 3, chunk);
+    CHECK_EQUAL(values[n - 1], chunk[2]);
+
+    int64_t expected_sum = 0;
+    for (size_t i = 100; i < 900; ++i)
+        expected_sum += values[i];
+    CHECK_EQUAL(expected_sum, a.sum(100, 900));
+    int64_t result;
+    size_t ndx;
+    CHECK(a.maximum(result, 0, n, &ndx));
+    CHECK_EQUAL(values[n - 1], result);
+    CHECK_EQUAL(n - 1, ndx);
+    CHECK(a.minimum(result, 10, n, &ndx));
+    CHECK_EQUAL(values[10], result);
+    CHECK_EQUAL(10, ndx);
+
+    CHECK_EQUAL(500, a.find_first(values[500]));
+    CHECK_EQUAL(not_found, a.find_first(base - 1));
+    CHECK_EQUAL(not_found, a.find_first(std::numeric_limits<int64_t>::min()));
+    CHECK_EQUAL(1, a.count(values[1]));
+    CHECK_EQUAL(0, a.count(0));
+    CHECK_EQUAL(501, a.find_first<Greater>(values[500]));
+    CHECK_EQUAL(0, a.find_first<Greater>(std::numeric_limits<int64_t>::min()));
+    CHECK_EQUAL(not_found, a.find_first<Less>(std::numeric_limits<int64_t>::min()));
+    CHECK_EQUAL(500, a.lower_bound_int(values[500]));
+    CHECK_EQUAL(501, a.upper_bound_int(values[500]));
+    CHECK_EQUAL(0, a.lower_bound_int(0));
+    CHECK_EQUAL(n, a.upper_bound_int(std::numeric_limits<int64_t>::max()));
+    CHECK_EQUAL(700, a.find_gte(values[700], 0));
+
+    QueryState<int64_t> state;
+    state.init(act_Sum, nullptr, size_t(-1));
+    a.find(cond_Greater, act_Sum, values[899], 0, n, 0, &state);
+    CHECK_EQUAL(a.sum(900, n), state.m_state);
+    CHECK_EQUAL(100, state.m_match_count);
+
+    state.init(act_Max, nullptr, size_t(-1));
+    a.find(cond_Less, act_Max, values[300], 0, n, 0, &state);
+    CHECK_EQUAL(values[299], state.m_state);
+    CHECK_EQUAL(299, state.m_minmax_index);
+
+    // Any modification expands the array back to the plain form
+    a.set(3, -1);
+    CHECK(!a.has_base());
+    values[3] = -1;
+    a.insert(0, 7);
+    values.insert(values.begin(), 7);
+    CHECK_EQUAL(n + 1, a.size());
+    for (size_t i = 0; i < n + 1; ++i)
+        CHECK_EQUAL(values[i], a.get(i));
+
+    // Nothing to gain for values that are spread out
+    a.add(std::numeric_limits<int64_t>::max());
+    CHECK(!a.compress_with_base());
+
+    a.destroy();
+}
+
+
 TEST(Array_Greater)
 {
     Array a(Allocator::get_default());
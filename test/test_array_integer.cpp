@@ -19,6 +19,7 @@
 #include "testsettings.hpp"
 
 #include <limits>
+#include <vector>
 
 #include <realm/array_integer.hpp>
 #include <realm/column.hpp>
@@ -409,3 +410,75 @@ TEST(ArrayIntNull_MinMaxOfNegativeIntegers)
 
     a.destroy();
 }
+
+// The aggregates of ArrayIntNull sum, or take the max/min of, all elements and then correct for the nulls. Check that
+// against a brute-force scan for every width that has a vectorized kernel, with nulls both inside and outside the
+// range.
+TEST(ArrayIntNull_AggregatesSkipNulls)
+{
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    const int64_t bounds[] = {100, 30000, 2000000000LL, 8000000000LL}; // widths 8, 16, 32 and 64
+
+    for (int64_t bound : bounds) {
+        ArrayIntNull a(Allocator::get_default());
+        a.create(Array::type_Normal);
+        std::vector<util::Optional<int64_t>> values;
+
+        for (size_t i = 0; i < 500; ++i) {
+            if (random.draw_int_mod(4) == 0) {
+                a.add(null());
+                values.push_back(util::none);
+            }
+            else {
+                int64_t v = random.draw_int(-bound, bound);
+                a.add(v);
+                values.push_back(v);
+            }
+        }
+
+        for (size_t start = 0; start < 100; start += 33) {
+            for (size_t end = 500; end > start + 100; end -= 123) {
+                int64_t expected_sum = 0;
+                util::Optional<int64_t> expected_max, expected_min;
+                size_t expected_max_ndx = not_found, expected_min_ndx = not_found;
+                for (size_t i = start; i < end; ++i) {
+                    if (!values[i])
+                        continue;
+                    expected_sum += *values[i];
+                    if (!expected_max || *values[i] > *expected_max) {
+                        expected_max = values[i];
+                        expected_max_ndx = i;
+                    }
+                    if (!expected_min || *values[i] < *expected_min) {
+                        expected_min = values[i];
+                        expected_min_ndx = i;
+                    }
+                }
+
+                CHECK_EQUAL(expected_sum, a.sum(start, end));
+
+                int64_t result;
+                size_t ndx;
+                CHECK(a.maximum(result, start, end, &ndx));
+                CHECK_EQUAL(*expected_max, result);
+                CHECK_EQUAL(expected_max_ndx, ndx);
+                CHECK(a.minimum(result, start, end, &ndx));
+                CHECK_EQUAL(*expected_min, result);
+                CHECK_EQUAL(expected_min_ndx, ndx);
+            }
+        }
+
+        // A range of only nulls has no maximum or minimum
+        a.clear();
+        for (size_t i = 0; i < 200; ++i)
+            a.add(null());
+        a.add(bound);
+        int64_t result;
+        CHECK_NOT(a.maximum(result, 0, 200));
+        CHECK_NOT(a.minimum(result, 0, 200));
+        CHECK_EQUAL(0, a.sum(0, 200));
+        CHECK_EQUAL(bound, a.sum());
+
+        a.destroy();
+    }
+}
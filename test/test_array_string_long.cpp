@@ -22,6 +22,7 @@
 #include <vector>
 
 #include <realm/array_string_long.hpp>
+#include <realm/util/to_string.hpp>
 #include "test.hpp"
 
 using namespace realm;
@@ -461,4 +462,89 @@ TEST(ArrayStringLong_Null)
     }
 }
 
+TEST_TYPES(ArrayStringLong_Compress, non_nullable, nullable)
+{
+    constexpr bool nullable = TEST_TYPE::value;
+
+    ArrayStringLong a(Allocator::get_default(), nullable);
+    a.create();
+
+    std::vector<std::string> v;
+    for (size_t i = 0; i < 500; ++i) {
+        std::string str = "https://www.example.com/products/" + util::to_string(i % 37) + "/item?id=" +
+                          util::to_string(i);
+        v.push_back(str);
+        a.add(str);
+    }
+    a.add("");
+    v.push_back("");
+    if (nullable) {
+        a.add(realm::null());
+        v.push_back("realm::null()");
+    }
+
+    auto check_values = [&] {
+        CHECK_EQUAL(v.size(), a.size());
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (v[i] == "realm::null()") {
+                CHECK(a.is_null(i));
+                CHECK(a.get(i).is_null());
+            }
+            else {
+                CHECK_EQUAL(v[i], a.get(i));
+                CHECK(!a.get(i).is_null());
+            }
+        }
+    };
+
+    CHECK(a.compress());
+    CHECK(a.is_compressed());
+    CHECK(ArrayStringLong::is_compressed(a.get_mem().get_addr(), a.get_alloc()));
+    check_values();
+
+    CHECK_EQUAL(0, a.find_first("https://www.example.com/products/0/item?id=0"));
+    CHECK_EQUAL(499, a.find_first("https://www.example.com/products/18/item?id=499"));
+    CHECK_EQUAL(not_found, a.find_first("https://www.example.com/products/18/item?id=500"));
+    CHECK_EQUAL(not_found, a.find_first("https://www.example.com/products/1"));
+    CHECK_EQUAL(500, a.find_first(""));
+    CHECK_EQUAL(nullable ? 501 : not_found, a.find_first(realm::null()));
+    std::string long_value(100, 'x');
+    CHECK_EQUAL(not_found, a.find_first(long_value));
+    CHECK_EQUAL(1, a.count("https://www.example.com/products/3/item?id=40"));
+    CHECK_EQUAL(not_found, a.find_first("https://www.example.com/products/3/item?id=40", 41));
+
+    // Modifications expand the leaf
+    a.set(3, "foo");
+    v[3] = "foo";
+    CHECK(!a.is_compressed());
+    check_values();
+    CHECK_EQUAL(3, a.find_first("foo"));
+
+    CHECK(a.compress());
+    a.insert(0, "bar");
+    v.insert(v.begin(), "bar");
+    CHECK(!a.is_compressed());
+    check_values();
+
+    CHECK(a.compress());
+    a.erase(10);
+    v.erase(v.begin() + 10);
+    a.truncate(100);
+    v.resize(100);
+    check_values();
+
+    a.destroy();
+
+    // Strings without repetition do not compress
+    ArrayStringLong b(Allocator::get_default(), nullable);
+    b.create();
+    for (unsigned i = 0; i < 256; ++i) {
+        char c = char(i);
+        b.add(StringData(&c, 1));
+    }
+    CHECK(!b.compress());
+    CHECK(!b.is_compressed());
+    b.destroy();
+}
+
 #endif // TEST_ARRAY_STRING_LONG
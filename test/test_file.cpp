@@ -311,6 +311,28 @@ TEST(File_ReadWrite)
 }
 
 
+TEST(File_Writeback)
+{
+    TEST_PATH(path);
+    File f(path, File::mode_Write);
+    f.resize(page_size() * 4);
+    {
+        File::Map<char> m(f, File::access_ReadWrite, page_size() * 4);
+        m.get_addr()[page_size() + 1] = 'a';
+        m.get_addr()[page_size() * 3] = 'b';
+        if (File::is_writeback_supported()) {
+            f.start_writeback(page_size(), page_size());
+            f.start_writeback(page_size() * 3, page_size());
+        }
+        f.sync_data();
+    }
+
+    File::Map<char> m(f, File::access_ReadOnly, page_size() * 4);
+    CHECK_EQUAL(m.get_addr()[page_size() + 1], 'a');
+    CHECK_EQUAL(m.get_addr()[page_size() * 3], 'b');
+}
+
+
 TEST(File_Resize)
 {
     TEST_PATH(path);
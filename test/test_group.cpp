@@ -39,6 +39,7 @@ static const mode_t2 MS_MODE_MASK = 0x0000ffff;
 
 #include <realm.hpp>
 #include <realm/util/file.hpp>
+#include <realm/util/to_string.hpp>
 
 #include "test.hpp"
 #include "test_table_helper.hpp"
@@ -2693,4 +2694,200 @@ TEST(Group_RemoveRecursive)
     CHECK_EQUAL(target->size(), 0);
 }
 
+// Integer column leaves that fill up while appending are stored in the frame-of-reference form, which must be
+// transparent to readers, also after the group has been written to a file and when the leaves are modified again
+TEST(Group_IntegerLeavesWithBase)
+{
+    GROUP_TEST_PATH(path);
+    const int64_t base = 1500000000000LL;
+    const size_t n = 5 * REALM_MAX_BPNODE_SIZE + 3;
+
+    auto check_table = [&](ConstTableRef t) {
+        CHECK_EQUAL(n, t->size());
+        int64_t expected_sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            CHECK_EQUAL(base + int64_t(i) * 3, t->get_int(0, i));
+            expected_sum += base + int64_t(i) * 3;
+        }
+        CHECK_EQUAL(expected_sum, t->sum_int(0));
+        CHECK_EQUAL(base + int64_t(n - 1) * 3, t->maximum_int(0));
+        CHECK_EQUAL(base, t->minimum_int(0));
+        CHECK_EQUAL(n / 2, t->find_first_int(0, base + int64_t(n / 2) * 3));
+        CHECK_EQUAL(not_found, t->find_first_int(0, base + 1));
+        CHECK_EQUAL(n - 10, t->where().greater(0, base + int64_t(9) * 3).count());
+        CHECK_EQUAL(10, t->where().less(0, base + int64_t(10) * 3).find_all().size());
+    };
+
+    {
+        Group g;
+        TableRef t = g.add_table("t");
+        t->add_column(type_Int, "time");
+        for (size_t i = 0; i < n; ++i) {
+            size_t row_ndx = t->add_empty_row();
+            t->set_int(0, row_ndx, base + int64_t(i) * 3);
+        }
+        check_table(t);
+        g.verify();
+        g.write(path);
+    }
+    {
+        Group g(path);
+        TableRef t = g.get_table("t");
+        check_table(t);
+        g.verify();
+
+        t->set_int(0, 2, -5);
+        t->insert_empty_row(1);
+        CHECK_EQUAL(-5, t->get_int(0, 3));
+        CHECK_EQUAL(0, t->get_int(0, 1));
+        CHECK_EQUAL(base + int64_t(n - 1) * 3, t->get_int(0, n));
+        g.verify();
+    }
+}
+
+TEST(Group_CompressedStringLeaves)
+{
+    GROUP_TEST_PATH(path);
+    const size_t n = 5 * REALM_MAX_BPNODE_SIZE + 3;
+
+    auto url = [](size_t i) {
+        return "https://www.example.com/catalog/" + util::to_string(i % 11) + "/item.html?id=" + util::to_string(i);
+    };
+
+    auto check_table = [&](ConstTableRef t) {
+        CHECK_EQUAL(n, t->size());
+        for (size_t i = 0; i < n; ++i)
+            CHECK_EQUAL(url(i), t->get_string(0, i));
+        std::string middle = url(n / 2), missing = url(n), value = url(17);
+        CHECK_EQUAL(n / 2, t->find_first_string(0, middle));
+        CHECK_EQUAL(not_found, t->find_first_string(0, missing));
+        CHECK_EQUAL(1, t->where().equal(0, StringData(value)).count());
+        CHECK_EQUAL(n / 11 + 1, t->where().begins_with(0, "https://www.example.com/catalog/0/").count());
+        CHECK_EQUAL(1, t->where().contains(0, "?id=1234").count());
+        ConstTableView tv = t->get_sorted_view(0);
+        for (size_t i = 1; i < tv.size(); ++i)
+            CHECK(tv.get_string(0, i - 1) <= tv.get_string(0, i));
+    };
+
+    {
+        Group g;
+        TableRef t = g.add_table("t");
+        t->add_column(type_String, "url");
+        for (size_t i = 0; i < n; ++i) {
+            size_t row_ndx = t->add_empty_row();
+            std::string value = url(i);
+            t->set_string(0, row_ndx, value);
+        }
+        check_table(t);
+        g.verify();
+        g.write(path);
+    }
+    {
+        Group g(path);
+        TableRef t = g.get_table("t");
+        check_table(t);
+        g.verify();
+
+        t->set_string(0, 2, "foo");
+        t->insert_empty_row(1);
+        t->move_last_over(0);
+        CHECK_EQUAL("foo", t->get_string(0, 3));
+        CHECK_EQUAL("", t->get_string(0, 1));
+        CHECK_EQUAL(url(n - 1), t->get_string(0, 0));
+        CHECK_EQUAL(url(n - 2), t->get_string(0, n - 1));
+        t->add_search_index(0);
+        CHECK_EQUAL(3, t->find_first_string(0, "foo"));
+        g.verify();
+    }
+}
+
+TEST(Group_IntegerSubtreeBounds)
+{
+    GROUP_TEST_PATH(path);
+    const int64_t base = 1500000000000LL;
+    const size_t n = 20 * REALM_MAX_BPNODE_SIZE + 7;
+
+    // Compare the query results against a plain scan of the column
+    auto check_table = [&](ConstTableRef t) {
+        size_t size = t->size();
+        std::vector<int64_t> values(size);
+        for (size_t i = 0; i < size; ++i)
+            values[i] = t->get_int(0, i);
+        int64_t probes[] = {base - 1, base, base + 5, base + int64_t(n / 2) * 10, base + int64_t(n - 50) * 10, -7};
+        for (int64_t v : probes) {
+            size_t num_greater = std::count_if(values.begin(), values.end(), [&](int64_t w) { return w > v; });
+            size_t num_less = std::count_if(values.begin(), values.end(), [&](int64_t w) { return w < v; });
+            size_t num_equal = std::count(values.begin(), values.end(), v);
+            size_t first_greater = std::find_if(values.begin(), values.end(), [&](int64_t w) { return w > v; }) -
+                                   values.begin();
+            CHECK_EQUAL(num_greater, t->where().greater(0, v).count());
+            CHECK_EQUAL(num_less, t->where().less(0, v).count());
+            CHECK_EQUAL(num_equal, t->where().equal(0, v).count());
+            CHECK_EQUAL(size - num_equal, t->where().not_equal(0, v).find_all().size());
+            size_t expected_first = first_greater == size ? not_found : first_greater;
+            CHECK_EQUAL(expected_first, t->where().greater(0, v).find());
+            // With a second condition, matches are verified row by row
+            size_t num_odd_greater = 0;
+            for (size_t i = 0; i < size; ++i) {
+                if (values[i] > v && t->get_int(1, i) == 1)
+                    ++num_odd_greater;
+            }
+            CHECK_EQUAL(num_odd_greater, t->where().greater(0, v).equal(1, 1).count());
+        }
+    };
+
+    {
+        Group g;
+        TableRef t = g.add_table("t");
+        t->add_column(type_Int, "time");
+        t->add_column(type_Int, "odd");
+        for (size_t i = 0; i < n; ++i) {
+            size_t row_ndx = t->add_empty_row();
+            t->set_int(0, row_ndx, base + int64_t(i) * 10);
+            t->set_int(1, row_ndx, int64_t(i % 2));
+        }
+        check_table(t);
+        g.verify();
+
+        // The leaves holding older values are skipped
+        auto& col = static_cast<const IntegerColumn&>(_impl::TableFriend::get_column(*t, 0));
+        int64_t recent = base + int64_t(n - 50) * 10;
+        CHECK_GREATER(col.find_candidate(cond_Greater, recent, 0, n), n - 50 - REALM_MAX_BPNODE_SIZE);
+        CHECK_EQUAL(n, col.find_candidate(cond_Greater, base + int64_t(n) * 10, 0, n));
+        // The last leaf is still open for appends, so its bounds include the default
+        // values of the new rows
+        CHECK_EQUAL(20 * REALM_MAX_BPNODE_SIZE, col.find_candidate(cond_Less, base, 0, n));
+        CHECK_EQUAL(0, col.find_candidate(cond_Less, base + 1, 0, n));
+        CHECK_EQUAL(7, col.find_candidate(cond_Less, base + 1, 7, n));
+
+        // Bounds must follow modifications
+        t->set_int(0, 3, base + int64_t(n) * 20);
+        t->set_int(0, n - 3, -7);
+        t->insert_empty_row(REALM_MAX_BPNODE_SIZE + 5);
+        t->set_int(0, REALM_MAX_BPNODE_SIZE + 5, base + 5);
+        t->insert_empty_row(0, REALM_MAX_BPNODE_SIZE);
+        check_table(t);
+        g.verify();
+        for (size_t i = 0; i < 3 * REALM_MAX_BPNODE_SIZE; ++i)
+            t->remove(REALM_MAX_BPNODE_SIZE / 2);
+        t->move_last_over(7);
+        check_table(t);
+        g.verify();
+        g.write(path);
+    }
+    {
+        Group g(path);
+        TableRef t = g.get_table("t");
+        check_table(t);
+        g.verify();
+
+        t->add_int(0, 11, 1000);
+        t->set_int(0, t->size() - 1, base - 1);
+        check_table(t);
+        t->clear();
+        CHECK_EQUAL(0, t->where().greater(0, base).count());
+        g.verify();
+    }
+}
+
 #endif // TEST_GROUP
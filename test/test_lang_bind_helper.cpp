@@ -534,6 +534,98 @@ TEST(LangBindHelper_AdvanceReadTransact_CreateManyTables)
 }
 
 
+TEST(LangBindHelper_AdvanceReadTransact_UntouchedColumns)
+{
+    // Column accessors of unchanged columns are not refreshed, and table
+    // accessors of unchanged tables are only refreshed if their arrays were
+    // moved by compaction
+    SHARED_GROUP_TEST_PATH(path);
+    const size_t rows = 20000;
+    {
+        // Table c goes first in the file, so that the arrays of table b are
+        // moved down once it is cleared
+        std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+        SharedGroup sg_w(*hist_w, SharedGroupOptions(crypt_key()));
+        std::vector<std::vector<const char*>> batches = {{"c"}, {"a", "b"}};
+        for (const auto& names : batches) {
+            WriteTransaction wt(sg_w);
+            for (const char* name : names) {
+                TableRef table = wt.add_table(name);
+                table->add_column(type_Int, "i");
+                table->add_column(type_String, "s");
+                table->add_search_index(1);
+                table->add_empty_row(rows);
+                for (size_t i = 0; i < rows; ++i) {
+                    std::string str = util::to_string(i);
+                    table->set_int(0, i, int64_t(i));
+                    table->set_string(1, i, str);
+                }
+            }
+            wt.commit();
+        }
+    }
+
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, SharedGroupOptions(crypt_key()));
+    Group& group = const_cast<Group&>(sg.begin_read());
+    ConstTableRef a = group.get_table("a");
+    ConstTableRef b = group.get_table("b");
+
+    SharedGroupOptions options(crypt_key());
+    options.compaction_budget = 64 * 1024;
+    options.compaction_threshold = 0.1;
+    std::unique_ptr<Replication> hist_w(make_in_realm_history(path));
+    SharedGroup sg_w(*hist_w, options);
+
+    // Only the integer column of table a changes
+    for (int64_t i = 0; i < 3; ++i) {
+        WriteTransaction wt(sg_w);
+        wt.get_table("a")->set_int(0, 0, 100 + i);
+        wt.commit();
+        LangBindHelper::advance_read(sg);
+        CHECK_EQUAL(a->get_int(0, 0), 100 + i);
+        CHECK_EQUAL(a->get_string(1, 0), "0");
+        CHECK_EQUAL(a->find_first_string(1, "17"), 17);
+    }
+
+    // Only the indexed string column of table a changes
+    {
+        WriteTransaction wt(sg_w);
+        wt.get_table("a")->set_string(1, 17, "x");
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    CHECK_EQUAL(a->find_first_string(1, "x"), 17);
+    CHECK_EQUAL(a->find_first_string(1, "17"), not_found);
+    CHECK_EQUAL(a->get_int(0, 0), 102);
+
+    // Free space for compaction to move the arrays of table b into, while
+    // only table a is changed
+    {
+        WriteTransaction wt(sg_w);
+        wt.get_table("c")->clear();
+        wt.commit();
+    }
+    LangBindHelper::advance_read(sg);
+    for (int64_t i = 0; i < 20; ++i) {
+        WriteTransaction wt(sg_w);
+        wt.get_table("a")->set_int(0, 1, i);
+        wt.commit();
+        LangBindHelper::advance_read(sg);
+        CHECK_EQUAL(a->get_int(0, 1), i);
+        CHECK_EQUAL(b->size(), rows);
+        CHECK_EQUAL(b->get_int(0, rows - 1), int64_t(rows - 1));
+        CHECK_EQUAL(b->find_first_string(1, "1234"), 1234);
+    }
+    group.verify();
+    for (size_t i = 0; i < rows; ++i) {
+        if (!CHECK_EQUAL(b->get_int(0, i), int64_t(i)))
+            break;
+    }
+    sg.end_read();
+}
+
+
 TEST(LangBindHelper_AdvanceReadTransact_InsertTable)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -53,15 +53,19 @@
 
 #if REALM_METRICS
 
+#include <realm/disable_sync_to_disk.hpp>
 #include <realm/descriptor.hpp>
 #include <realm/query_expression.hpp>
 #include <realm/lang_bind_helper.hpp>
 #include <realm/util/encrypted_file_mapping.hpp>
+#include <realm/util/file_mapper.hpp>
 #include <realm/util/to_string.hpp>
 #include <realm/replication.hpp>
 #include <realm/history.hpp>
 
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -896,6 +900,216 @@ TEST(Metrics_TransactionVersions)
     }
 }
 
+TEST(Metrics_TransactionTranslations)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroupOptions options(crypt_key());
+    options.enable_metrics = true;
+    SharedGroup sg(*hist, options);
+    populate(sg);
+
+    {
+        ReadTransaction rt(sg);
+        ConstTableRef t0 = rt.get_table(0);
+        for (size_t i = 0; i < t0->size(); ++i)
+            t0->get_int(0, i);
+    }
+    {
+        WriteTransaction wt(sg);
+        TableRef t0 = wt.get_table(0);
+        t0->add_empty_row(3);
+        wt.commit();
+    }
+
+    std::shared_ptr<Metrics> metrics = sg.get_metrics();
+    CHECK(metrics);
+    std::unique_ptr<Metrics::TransactionInfoList> transactions = metrics->take_transactions();
+    CHECK(transactions);
+    CHECK_EQUAL(transactions->size(), 3);
+
+    // Reading resolves refs into the file, writing resolves refs into the
+    // newly allocated slabs, which first requires a search of the slabs
+    const TransactionInfo& read = transactions->at(1);
+    const TransactionInfo& write = transactions->at(2);
+    CHECK_EQUAL(read.get_transaction_type(), TransactionInfo::read_transaction);
+    CHECK_GREATER(read.get_translation_hits() + read.get_translation_misses(), 0);
+    CHECK_EQUAL(write.get_transaction_type(), TransactionInfo::write_transaction);
+    CHECK_GREATER(write.get_translation_misses(), 0);
+    CHECK_GREATER(write.get_translation_hits(), 0);
+}
+
+TEST(Metrics_TransactionWriteIO)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroupOptions options(crypt_key());
+    options.enable_metrics = true;
+    SharedGroup sg(*hist, options);
+    populate(sg);
+
+    {
+        ReadTransaction rt(sg);
+    }
+    {
+        WriteTransaction wt(sg);
+        TableRef t0 = wt.get_table(0);
+        t0->add_empty_row(3);
+        wt.commit();
+    }
+
+    std::shared_ptr<Metrics> metrics = sg.get_metrics();
+    CHECK(metrics);
+    std::unique_ptr<Metrics::TransactionInfoList> transactions = metrics->take_transactions();
+    CHECK(transactions);
+    CHECK_EQUAL(transactions->size(), 3);
+
+    const TransactionInfo& read = transactions->at(1);
+    const TransactionInfo& write = transactions->at(2);
+    CHECK_EQUAL(read.get_bytes_written(), 0);
+    CHECK_EQUAL(read.get_num_sync_calls(), 0);
+    // At least the modified table, the top array and the file header
+    CHECK_GREATER(write.get_bytes_written(), 24);
+    CHECK_EQUAL(read.get_arrays_written(), 0);
+    CHECK_GREATER(write.get_arrays_written(), 2);
+    // Synchronization to disk is disabled when running the test suite
+    if (get_disable_sync_to_disk())
+        CHECK_EQUAL(write.get_num_sync_calls(), 0);
+}
+
+TEST(Metrics_CommitBreakdown)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroupOptions options(crypt_key());
+    options.enable_metrics = true;
+    SharedGroup sg(*hist, options);
+    populate(sg);
+    metrics::Metrics& metrics = *sg.get_metrics();
+    metrics.take_transactions();
+
+    // Make the commit below wait for another one to finish
+    std::unique_ptr<Replication> hist_2(make_in_realm_history(path));
+    SharedGroup sg_2(*hist_2, SharedGroupOptions(crypt_key()));
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool writing = false;
+    std::thread thread([&] {
+        using namespace std::literals::chrono_literals;
+        WriteTransaction wt(sg_2);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writing = true;
+        }
+        cond.notify_one();
+        wt.get_table(0)->add_empty_row();
+        std::this_thread::sleep_for(20ms);
+        wt.commit();
+    });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return writing; });
+    }
+    {
+        WriteTransaction wt(sg);
+        wt.get_table(0)->add_empty_row(3);
+        wt.commit();
+    }
+    thread.join();
+
+    std::unique_ptr<Metrics::TransactionInfoList> transactions = metrics.take_transactions();
+    CHECK_EQUAL(transactions->size(), 1);
+    const TransactionInfo& write = transactions->at(0);
+    CHECK_GREATER(write.get_lock_wait_time(), 0);
+    CHECK_GREATER(write.get_history_write_time(), 0);
+    CHECK_GREATER(write.get_serialization_time(), 0);
+    CHECK_GREATER(write.get_free_list_time(), 0);
+    CHECK_GREATER(write.get_notify_time(), 0);
+    // Parts of array serialization
+    CHECK_LESS_EQUAL(write.get_serialization_time() + write.get_free_list_time(), write.get_write_time());
+    CHECK_LESS_EQUAL(write.get_data_fsync_time() + write.get_header_fsync_time(), write.get_fsync_time());
+    if (get_disable_sync_to_disk()) {
+        CHECK_EQUAL(write.get_data_fsync_time(), 0);
+        CHECK_EQUAL(write.get_header_fsync_time(), 0);
+    }
+    CHECK_LESS(write.get_history_write_time() + write.get_write_time() + write.get_fsync_time() +
+                   write.get_notify_time(),
+               write.get_transaction_time());
+}
+
+TEST(Metrics_IncrementalCompaction)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(crypt_key());
+    options.enable_metrics = true;
+    options.compaction_budget = 64 * 1024;
+    options.compaction_threshold = 0.3;
+    SharedGroup sg(path, false, options);
+    const size_t rows = 100000;
+    for (const char* name : {"a", "b"}) {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table(name);
+        table->add_column(type_Int, "i");
+        table->add_empty_row(rows);
+        for (size_t i = 0; i < rows; ++i)
+            table->set_int(0, i, int64_t(i) << 20);
+        wt.commit();
+    }
+    {
+        // Leave free space in front of table b
+        WriteTransaction wt(sg);
+        wt.get_table("a")->clear();
+        wt.add_table("c")->add_column(type_Int, "i");
+        wt.commit();
+    }
+    sg.get_metrics()->take_transactions();
+
+    // Table b is moved into the free space bit by bit by unrelated commits
+    size_t total_relocated = 0;
+    size_t last_relocated = 0;
+    for (int i = 0; i < 100; ++i) {
+        WriteTransaction wt(sg);
+        wt.get_table("c")->add_empty_row();
+        wt.commit();
+        std::unique_ptr<Metrics::TransactionInfoList> transactions = sg.get_metrics()->take_transactions();
+        for (const TransactionInfo& info : *transactions) {
+            CHECK_LESS_EQUAL(info.get_bytes_relocated(), options.compaction_budget);
+            total_relocated += info.get_bytes_relocated();
+            if (info.get_transaction_type() == TransactionInfo::write_transaction)
+                last_relocated = info.get_bytes_relocated();
+        }
+    }
+    CHECK_GREATER(total_relocated, rows * 8 / 2);
+    // Nothing is left to move
+    CHECK_EQUAL(last_relocated, 0);
+
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+    ConstTableRef table = rt.get_table("b");
+    CHECK_EQUAL(table->size(), rows);
+    for (size_t i = 0; i < rows; ++i) {
+        if (!CHECK_EQUAL(table->get_int(0, i), int64_t(i) << 20))
+            break;
+    }
+}
+
+TEST(Metrics_PageSize)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(crypt_key());
+    options.enable_metrics = true;
+    {
+        SharedGroup sg(path, false, options);
+        CHECK_EQUAL(sg.get_metrics()->get_page_size(), page_size());
+    }
+    options.enable_huge_pages = true;
+    {
+        SharedGroup sg(path, false, options);
+        size_t expected = util::huge_pages_supported() ? util::huge_page_size : page_size();
+        CHECK_EQUAL(sg.get_metrics()->get_page_size(), expected);
+    }
+}
+
 
 
 #endif // REALM_METRICS
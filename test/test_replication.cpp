@@ -3610,6 +3610,75 @@ TEST(Replication_AddRowWithKey)
 }
 
 
+TEST(Replication_AppendColumns)
+{
+    SHARED_GROUP_TEST_PATH(path_1);
+    SHARED_GROUP_TEST_PATH(path_2);
+
+    util::Logger& replay_logger = test_context.logger;
+
+    MyTrivialReplication repl(path_1);
+    SharedGroup sg_1(repl);
+    SharedGroup sg_2(path_2);
+
+    const size_t n = 2 * REALM_MAX_BPNODE_SIZE + 3;
+    std::vector<int64_t> ints(n);
+    std::unique_ptr<bool[]> nulls(new bool[n]);
+    std::vector<double> doubles(n);
+    std::vector<StringData> strings(n);
+    std::vector<Timestamp> timestamps(n);
+    for (size_t i = 0; i < n; ++i) {
+        ints[i] = int64_t(i * i) - 1000;
+        nulls[i] = i % 4 == 1;
+        doubles[i] = i / 3.0;
+        strings[i] = i % 5 == 0 ? StringData() : StringData("abc", i % 4);
+        timestamps[i] = i % 6 == 0 ? Timestamp() : Timestamp(int64_t(i), int32_t(i * 7));
+    }
+
+    {
+        WriteTransaction wt(sg_1);
+        TableRef table1 = wt.add_table("table");
+        table1->add_column(type_Int, "c1");
+        table1->add_column(type_Int, "c2", true);
+        table1->add_column(type_Bool, "c3", true);
+        table1->add_column(type_Double, "c4", true);
+        table1->add_column(type_String, "c5", true);
+        table1->add_column(type_Timestamp, "c6", true);
+        table1->add_column(type_String, "c7");
+        table1->add_empty_row(2);
+        std::vector<Table::ColumnValues> columns(6);
+        for (size_t i = 0; i < 6; ++i)
+            columns[i].col_ndx = i;
+        columns[0].ints = ints.data();
+        columns[1].ints = ints.data();
+        columns[1].nulls = nulls.get();
+        columns[2].ints = ints.data();
+        columns[2].nulls = nulls.get();
+        columns[3].doubles = doubles.data();
+        columns[3].nulls = nulls.get();
+        columns[4].strings = strings.data();
+        columns[5].timestamps = timestamps.data();
+        table1->append_columns(n, columns);
+        wt.commit();
+    }
+    repl.replay_transacts(sg_2, replay_logger);
+    {
+        ReadTransaction rt_1(sg_1);
+        ReadTransaction rt_2(sg_2);
+        rt_1.get_group().verify();
+        rt_2.get_group().verify();
+        ConstTableRef table1 = rt_1.get_table("table");
+        ConstTableRef table2 = rt_2.get_table("table");
+        CHECK_EQUAL(n + 2, table2->size());
+        CHECK(*table1 == *table2);
+        CHECK(table2->is_null(1, 3));
+        CHECK_EQUAL(ints[3], table2->get_int(1, 5));
+        CHECK(table2->get_bool(2, 2));
+        CHECK(table2->is_null(5, 2));
+    }
+}
+
+
 TEST(Replication_RenameGroupLevelTable_MoveGroupLevelTable_RenameColumn_MoveColumn)
 {
     SHARED_GROUP_TEST_PATH(path_1);
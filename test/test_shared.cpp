@@ -29,6 +29,7 @@
 
 // Need fork() and waitpid() for Shared_RobustAgainstDeathDuringWrite
 #ifndef _WIN32
+#include <poll.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/types.h>
@@ -144,14 +145,20 @@ TEST(Shared_Unattached)
 
 namespace {
 
-// async deamon does not start when launching unit tests from osx, so async is currently disabled on osx.
-// Also: async requires interprocess communication, which does not work with our current encryption support.
+// async relies on timed waits on condition variables, which are not supported where they are emulated, so
+// async is currently disabled on osx. Also: async from several processes requires interprocess communication, which
+// does not work with our current encryption support.
 #if !defined(_WIN32) && !REALM_PLATFORM_APPLE
-#if REALM_ANDROID || defined DISABLE_ASYNC || REALM_ENABLE_ENCRYPTION
+#if REALM_ANDROID
 bool allow_async = false;
 #else
 bool allow_async = true;
 #endif
+#if REALM_ANDROID || defined DISABLE_ASYNC || REALM_ENABLE_ENCRYPTION
+bool allow_async_multiprocess = false;
+#else
+bool allow_async_multiprocess = true;
+#endif
 #endif
 
 
@@ -404,6 +411,481 @@ TEST(Shared_EncryptedRemap)
 }
 
 
+TEST(Shared_HugePages)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(crypt_key());
+    options.enable_huge_pages = true;
+    const size_t rows = 300000;
+    {
+        SharedGroup sg(path, false, options);
+        WriteTransaction wt(sg);
+        auto t1 = wt.add_table("test");
+        t1->add_column(type_Int, "i");
+        t1->add_empty_row(rows);
+        for (size_t i = 0; i < rows; ++i)
+            t1->set_int(0, i, int64_t(i) * 1000);
+        wt.commit();
+    }
+    {
+        // Huge pages must not be observable, not even when the file is shared
+        // with a SharedGroup that does not use them
+        SharedGroup sg(path, false, options);
+        SharedGroup sg2(path, false, SharedGroupOptions(crypt_key()));
+        {
+            WriteTransaction wt(sg2);
+            wt.get_table("test")->set_int(0, 7, -7);
+            wt.commit();
+        }
+        ReadTransaction rt(sg);
+        auto table = rt.get_table("test");
+        CHECK(table);
+        CHECK_EQUAL(table->size(), rows);
+        CHECK_EQUAL(table->get_int(0, 7), -7);
+        CHECK_EQUAL(table->get_int(0, rows - 1), int64_t(rows - 1) * 1000);
+        rt.get_group().verify();
+    }
+}
+
+TEST(Shared_BigCommit)
+{
+    // Enough data for the commit to be copied to the file by several threads,
+    // where the system has the cores for it
+    SHARED_GROUP_TEST_PATH(path);
+    const size_t rows = 6000;
+    const size_t blob_size = 4000;
+    std::vector<char> blob(blob_size);
+    {
+        SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+        WriteTransaction wt(sg);
+        auto table = wt.add_table("test");
+        table->add_column(type_Int, "i");
+        table->add_column(type_Binary, "b");
+        table->add_empty_row(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            std::fill(blob.begin(), blob.end(), char(i));
+            table->set_int(0, i, int64_t(i));
+            table->set_binary(1, i, BinaryData(blob.data(), blob_size));
+        }
+        wt.commit();
+    }
+    {
+        SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+        {
+            WriteTransaction wt(sg);
+            wt.get_table("test")->set_int(0, rows / 2, -1);
+            wt.commit();
+        }
+        ReadTransaction rt(sg);
+        auto table = rt.get_table("test");
+        CHECK_EQUAL(table->size(), rows);
+        for (size_t i = 0; i < rows; ++i) {
+            CHECK_EQUAL(table->get_int(0, i), i == rows / 2 ? -1 : int64_t(i));
+            BinaryData bin = table->get_binary(1, i);
+            CHECK_EQUAL(bin.size(), blob_size);
+            if (bin.size() == blob_size) {
+                CHECK_EQUAL(bin.data()[0], char(i));
+                CHECK_EQUAL(bin.data()[blob_size - 1], char(i));
+            }
+        }
+        rt.get_group().verify();
+    }
+}
+
+TEST(Shared_IncrementalCompaction)
+{
+    // Arrays moved by compaction must stay intact for readers of older
+    // versions, and for accessors that were attached before they moved
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(crypt_key());
+    options.compaction_budget = 16 * 1024;
+    options.compaction_threshold = 0.2;
+    const size_t rows = 50000;
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, options);
+    {
+        WriteTransaction wt(sg);
+        for (const char* name : {"a", "b"}) {
+            TableRef table = wt.add_table(name);
+            table->add_column(type_Int, "i");
+            table->add_column(type_String, "s");
+            table->add_empty_row(rows);
+            for (size_t i = 0; i < rows; ++i) {
+                std::string str = util::to_string(i);
+                table->set_int(0, i, int64_t(i) * 3);
+                table->set_string(1, i, str);
+            }
+        }
+        wt.commit();
+    }
+    {
+        WriteTransaction wt(sg);
+        wt.get_table("a")->clear();
+        wt.commit();
+    }
+    {
+        // Let the space of table a become reusable
+        WriteTransaction wt(sg);
+        wt.commit();
+    }
+
+    std::unique_ptr<Replication> hist_2(make_in_realm_history(path));
+    SharedGroup sg_2(*hist_2, options);
+    ReadTransaction rt(sg_2);
+    ConstTableRef old_table = rt.get_table("b");
+    Group& group = const_cast<Group&>(sg.begin_read());
+    ConstTableRef table = group.get_table("b");
+    for (size_t i = 0; i < 50; ++i) {
+        LangBindHelper::promote_to_write(sg);
+        TableRef t = group.get_table("b");
+        t->set_int(0, i * 1000, -1);
+        LangBindHelper::commit_and_continue_as_read(sg);
+        CHECK_EQUAL(table->get_int(0, i * 1000), -1);
+        CHECK_EQUAL(table->get_string(1, i * 1000 + 1), util::to_string(i * 1000 + 1));
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        CHECK_EQUAL(table->get_int(0, i), (i < 50 * 1000 && i % 1000 == 0) ? -1 : int64_t(i) * 3);
+        CHECK_EQUAL(old_table->get_int(0, i), int64_t(i) * 3);
+        CHECK_EQUAL(table->get_string(1, i), util::to_string(i));
+    }
+    group.verify();
+    sg.end_read();
+}
+
+TEST(Shared_TruncateFreeTail)
+{
+    // Free space at the end of the file is given back to the file system once
+    // no reader is using it any more
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    const size_t rows = 100000;
+    auto fill = [&] {
+        WriteTransaction wt(sg);
+        TableRef table = wt.get_or_add_table("cache");
+        if (table->get_column_count() == 0) {
+            table->add_column(type_Int, "i");
+            table->add_column(type_String, "s");
+        }
+        table->add_empty_row(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            std::string str = "value " + util::to_string(i);
+            table->set_int(0, i, int64_t(i));
+            table->set_string(1, i, str);
+        }
+        wt.commit();
+    };
+    auto drain = [&] {
+        WriteTransaction wt(sg);
+        wt.get_table("cache")->clear();
+        wt.commit();
+    };
+    auto empty_commits = [&] {
+        for (int i = 0; i < 4; ++i) {
+            WriteTransaction wt(sg);
+            wt.commit();
+        }
+    };
+    auto file_size = [&] { return util::File(path).get_size(); };
+
+    fill();
+    auto full_size = file_size();
+    {
+        // A reader of the full table keeps the space from being released
+        SharedGroup sg_2(path, false, SharedGroupOptions(crypt_key()));
+        ReadTransaction rt(sg_2);
+        drain();
+        empty_commits();
+        CHECK_GREATER_EQUAL(file_size(), full_size);
+        ConstTableRef table = rt.get_table("cache");
+        CHECK_EQUAL(table->size(), rows);
+        CHECK_EQUAL(table->get_string(1, rows - 1), "value " + util::to_string(rows - 1));
+    }
+    empty_commits();
+    if (!crypt_key())
+        CHECK_LESS(file_size(), full_size / 4);
+
+    // Filling and draining the table repeatedly does not make the file grow
+    for (int i = 0; i < 3; ++i) {
+        fill();
+        {
+            SharedGroup sg_2(path, false, SharedGroupOptions(crypt_key()));
+            ReadTransaction rt(sg_2);
+            ConstTableRef table = rt.get_table("cache");
+            CHECK_EQUAL(table->size(), rows);
+            CHECK_EQUAL(table->get_int(0, rows - 1), int64_t(rows - 1));
+            CHECK_EQUAL(table->get_string(1, rows / 2), "value " + util::to_string(rows / 2));
+            rt.get_group().verify();
+        }
+        drain();
+        empty_commits();
+        if (!crypt_key())
+            CHECK_LESS(file_size(), full_size / 4);
+    }
+}
+
+TEST(Shared_RetainedVersions)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("t");
+        table->add_column(type_Int, "i");
+        table->add_empty_row(1000);
+        wt.commit();
+    }
+    CHECK(sg.get_retained_versions().empty());
+
+    SharedGroup sg_2(path, false, SharedGroupOptions(crypt_key()));
+    ReadTransaction rt(sg_2);
+    SharedGroup sg_3(path, false, SharedGroupOptions(crypt_key()));
+    ReadTransaction rt_2(sg_3);
+    for (int i = 0; i < 3; ++i) {
+        WriteTransaction wt(sg);
+        wt.get_table("t")->set_int(0, 0, i);
+        wt.commit();
+    }
+    std::vector<SharedGroup::RetainedVersion> versions = sg.get_retained_versions();
+    CHECK_EQUAL(versions.size(), 1);
+    CHECK_EQUAL(versions[0].version, sg_2.get_version_of_current_transaction().version);
+    CHECK_EQUAL(versions[0].num_read_locks, 2);
+    CHECK_GREATER(versions[0].retained_bytes, 0);
+    CHECK_EQUAL(sg.get_number_of_invalidated_versions(), 0);
+    CHECK_NOT(sg_2.is_read_lock_invalidated());
+}
+
+// Read locks are counted in separate shards for different threads, so check
+// that the locks of more threads than there are shards are all accounted for,
+// and that a version pinned by one thread can be unpinned by another
+TEST(Shared_ReadLocksFromManyThreads)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("t");
+        table->add_column(type_Int, "i");
+        table->add_empty_row(10);
+        wt.commit();
+    }
+    auto commit = [&](int64_t value) {
+        WriteTransaction wt(sg);
+        wt.get_table("t")->set_int(0, 0, value);
+        wt.commit();
+    };
+
+    const int num_threads = 20;
+    std::vector<std::unique_ptr<SharedGroup>> shared_groups;
+    for (int i = 0; i < num_threads; ++i)
+        shared_groups.emplace_back(new SharedGroup(path, false, SharedGroupOptions(crypt_key())));
+    auto run_in_threads = [&](std::function<void(SharedGroup&)> func) {
+        std::vector<std::thread> threads;
+        for (auto& shared_group : shared_groups)
+            threads.emplace_back([&func, &shared_group] { func(*shared_group); });
+        for (auto& thread : threads)
+            thread.join();
+    };
+
+    run_in_threads([](SharedGroup& shared_group) { shared_group.begin_read(); });
+    commit(1);
+    std::vector<SharedGroup::RetainedVersion> versions = sg.get_retained_versions();
+    CHECK_EQUAL(versions.size(), 1);
+    CHECK_EQUAL(versions[0].num_read_locks, num_threads);
+
+    run_in_threads([](SharedGroup& shared_group) { shared_group.end_read(); });
+    commit(2);
+    CHECK(sg.get_retained_versions().empty());
+
+    SharedGroup::VersionID pinned;
+    std::thread([&] {
+        shared_groups[0]->begin_read();
+        pinned = shared_groups[0]->pin_version();
+        shared_groups[0]->end_read();
+    }).join();
+    commit(3);
+    versions = sg.get_retained_versions();
+    CHECK_EQUAL(versions.size(), 1);
+    CHECK_EQUAL(versions[0].version, pinned.version);
+    CHECK_EQUAL(versions[0].num_read_locks, 1);
+
+    sg.begin_read();
+    sg.unpin_version(pinned);
+    sg.end_read();
+    commit(4);
+    CHECK(sg.get_retained_versions().empty());
+}
+
+#ifndef _WIN32
+
+TEST(Shared_ChangeNotificationFd)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    SharedGroup sg_2(path, false, SharedGroupOptions(crypt_key()));
+    auto commit = [&](SharedGroup& shared_group) {
+        WriteTransaction wt(shared_group);
+        if (!wt.has_table("t"))
+            wt.add_table("t");
+        wt.commit();
+    };
+    auto is_readable = [](int fd) {
+        pollfd pfd = {fd, POLLIN, 0};
+        return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLIN) != 0;
+    };
+
+    sg.begin_read();
+    sg.end_read();
+    int fd = sg.get_change_notification_fd();
+    CHECK_EQUAL(sg.get_change_notification_fd(), fd);
+    CHECK_NOT(is_readable(fd));
+
+    // Commits by others wake the subscriber until it has caught up
+    commit(sg_2);
+    CHECK(is_readable(fd));
+    CHECK(sg.consume_change_notification());
+    CHECK_NOT(is_readable(fd));
+    commit(sg_2);
+    commit(sg_2);
+    CHECK(is_readable(fd));
+    sg.begin_read();
+    sg.end_read();
+    CHECK_NOT(sg.consume_change_notification());
+    CHECK_NOT(is_readable(fd));
+
+    // A descriptor obtained after a commit is readable right away
+    commit(sg);
+    int fd_2 = sg_2.get_change_notification_fd();
+    CHECK(is_readable(fd_2));
+    CHECK(sg_2.consume_change_notification());
+    sg_2.begin_read();
+    sg_2.end_read();
+    CHECK_NOT(sg_2.consume_change_notification());
+
+    // The descriptor survives compaction
+    sg_2.close();
+    CHECK(sg.compact());
+    SharedGroup sg_3(path, false, SharedGroupOptions(crypt_key()));
+    sg.begin_read();
+    sg.end_read();
+    sg.consume_change_notification();
+    CHECK_NOT(is_readable(fd));
+    commit(sg_3);
+    CHECK(is_readable(fd));
+    CHECK(sg.consume_change_notification());
+}
+
+#endif
+
+TEST(Shared_RetentionPolicy)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(crypt_key());
+    options.max_retained_versions = 4;
+    std::vector<std::pair<uint_fast64_t, uint_fast32_t>> invalidated;
+    options.invalidation_callback = [&](uint_fast64_t version, uint_fast32_t num_read_locks) {
+        invalidated.emplace_back(version, num_read_locks);
+    };
+    std::unique_ptr<Replication> hist(make_in_realm_history(path));
+    SharedGroup sg(*hist, options);
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("t");
+        table->add_column(type_Int, "i");
+        table->add_empty_row(1000);
+        wt.commit();
+    }
+
+    std::unique_ptr<Replication> hist_2(make_in_realm_history(path));
+    SharedGroup sg_2(*hist_2, options);
+    sg_2.begin_read();
+    SharedGroup::version_type stale_version = sg_2.get_version_of_current_transaction().version;
+    auto commit = [&](int64_t value) {
+        WriteTransaction wt(sg);
+        wt.get_table("t")->set_int(0, 0, value);
+        wt.commit();
+    };
+    for (int i = 0; i < 3; ++i)
+        commit(i);
+    CHECK(invalidated.empty());
+    CHECK_NOT(sg_2.is_read_lock_invalidated());
+
+    commit(3);
+    CHECK_EQUAL(invalidated.size(), 1);
+    CHECK_EQUAL(invalidated[0].first, stale_version);
+    CHECK_EQUAL(invalidated[0].second, 1);
+    CHECK_EQUAL(sg.get_number_of_invalidated_versions(), 1);
+    CHECK_LESS_EQUAL(sg.get_number_of_versions(), 4);
+    CHECK(sg.get_retained_versions().empty());
+    CHECK(sg_2.is_read_lock_invalidated());
+    CHECK_THROW(LangBindHelper::advance_read(sg_2), SharedGroup::ReadLockInvalidated);
+    CHECK_THROW(LangBindHelper::promote_to_write(sg_2), SharedGroup::ReadLockInvalidated);
+    CHECK_THROW(sg_2.pin_version(), SharedGroup::ReadLockInvalidated);
+    sg_2.end_read();
+
+    // The reader can start over, and the invalidated entry does not get in the
+    // way of later versions
+    for (int i = 4; i < 40; ++i) {
+        ReadTransaction rt(sg_2);
+        CHECK_EQUAL(rt.get_table("t")->get_int(0, 0), i - 1);
+        commit(i);
+        commit(i);
+    }
+    CHECK_EQUAL(invalidated.size(), 1);
+    {
+        ReadTransaction rt(sg_2);
+        CHECK_EQUAL(rt.get_table("t")->get_int(0, 0), 39);
+        rt.get_group().verify();
+    }
+}
+
+TEST(Shared_RetentionPolicyBytesAndAge)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(crypt_key());
+    options.max_retained_bytes = 1024 * 1024;
+    options.max_pinned_age_ms = 200;
+    SharedGroup sg(path, false, options);
+    {
+        WriteTransaction wt(sg);
+        TableRef table = wt.add_table("t");
+        table->add_column(type_Int, "i");
+        table->add_empty_row(300000);
+        wt.commit();
+    }
+    auto rewrite = [&] {
+        WriteTransaction wt(sg);
+        TableRef table = wt.get_table("t");
+        for (size_t i = 0; i < table->size(); ++i)
+            table->set_int(0, i, table->get_int(0, i) + 1000000);
+        wt.commit();
+    };
+
+    // Each rewrite frees the previous copy of the column, which takes more
+    // than 1MB once the values need 32 bits
+    SharedGroup sg_2(path, false, options);
+    {
+        ReadTransaction rt(sg_2);
+        rewrite();
+        rewrite();
+        CHECK_NOT(sg_2.is_read_lock_invalidated());
+        rewrite();
+        CHECK(sg_2.is_read_lock_invalidated());
+    }
+    CHECK_EQUAL(sg.get_number_of_invalidated_versions(), 1);
+
+    {
+        ReadTransaction rt(sg_2);
+        WriteTransaction wt(sg);
+        wt.commit();
+        millisleep(300);
+        CHECK_NOT(sg_2.is_read_lock_invalidated());
+        WriteTransaction wt_2(sg);
+        wt_2.commit();
+        CHECK(sg_2.is_read_lock_invalidated());
+    }
+    CHECK_EQUAL(sg.get_number_of_invalidated_versions(), 2);
+}
+
 TEST(Shared_Initial)
 {
     SHARED_GROUP_TEST_PATH(path);
@@ -1686,6 +2168,62 @@ TEST(Shared_SpaceOveruse)
 }
 
 
+TEST(Shared_FreeSpaceReuse)
+{
+    // Fragment the free space with many small commits, partly while a reader
+    // pins an old version, then check that the free space is reused once
+    // the reader is gone
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroup sg(path, false, SharedGroupOptions(crypt_key()));
+    const size_t num_tables = 50;
+    const size_t num_rows = 200;
+    {
+        WriteTransaction wt(sg);
+        for (size_t i = 0; i != num_tables; ++i) {
+            std::string name = "table_" + util::to_string(i);
+            TableRef table = wt.add_table(name);
+            table->add_column(type_Int, "i");
+            table->add_column(type_String, "s");
+            table->add_empty_row(num_rows);
+        }
+        wt.commit();
+    }
+
+    Random random(random_int<unsigned long>()); // Seed from slow global generator
+    auto modify = [&](int round) {
+        WriteTransaction wt(sg);
+        for (size_t i = 0; i != 5; ++i) {
+            TableRef table = wt.get_table(random.draw_int_mod(num_tables));
+            size_t row = random.draw_int_mod(num_rows);
+            table->set_int(0, row, round);
+            std::string str(random.draw_int_mod(100), 'x');
+            table->set_string(1, row, str);
+        }
+        wt.get_group().verify();
+        wt.commit();
+    };
+
+    {
+        SharedGroup sg_r(path, false, SharedGroupOptions(crypt_key()));
+        ReadTransaction rt(sg_r);
+        for (int i = 0; i != 50; ++i)
+            modify(i);
+        CHECK_EQUAL(rt.get_group().size(), num_tables);
+    }
+    for (int i = 0; i != 50; ++i)
+        modify(i);
+
+    // With no readers left, the free space is sufficient to hold the changes
+    size_t file_size = size_t(util::File(path).get_size());
+    for (int i = 0; i != 50; ++i)
+        modify(i);
+    CHECK_EQUAL(file_size, size_t(util::File(path).get_size()));
+
+    ReadTransaction rt(sg);
+    rt.get_group().verify();
+}
+
+
 TEST(Shared_Notifications)
 {
     // Create a new shared db
@@ -1899,7 +2437,7 @@ TEST(Shared_ClearColumnWithBasicArrayRootLeaf)
 }
 
 // disable shared async on windows and any Apple operating system
-// TODO: enable async daemon for OS X - think how to do it in XCode (no issue for build.sh)
+// TODO: enable async for OS X - requires timed waits on emulated condition variables
 #if !defined(_WIN32) && !REALM_PLATFORM_APPLE
 // Todo. Keywords: winbug
 TEST_IF(Shared_Async, allow_async)
@@ -1909,7 +2447,7 @@ TEST_IF(Shared_Async, allow_async)
     // Do some changes in a async db
     {
         bool no_create = false;
-        SharedGroup db(path, no_create, SharedGroupOptions(SharedGroupOptions::Durability::Async));
+        SharedGroup db(path, no_create, SharedGroupOptions(SharedGroupOptions::Durability::Async, crypt_key()));
 
         for (size_t i = 0; i < 100; ++i) {
             //            std::cout << "t "<<n<<"\n";
@@ -1925,13 +2463,9 @@ TEST_IF(Shared_Async, allow_async)
         }
     }
 
-    // Wait for async_commit process to shutdown
-    // FIXME: we need a way to determine properly if the daemon has shot down instead of just sleeping
-    millisleep(1000);
-
     // Read the db again in normal mode to verify
     {
-        SharedGroup db(path);
+        SharedGroup db(path, false, SharedGroupOptions(crypt_key()));
 
         ReadTransaction rt(db);
         rt.get_group().verify();
@@ -1941,6 +2475,56 @@ TEST_IF(Shared_Async, allow_async)
 }
 
 
+TEST_IF(Shared_AsyncHandover, allow_async)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(SharedGroupOptions::Durability::Async, crypt_key());
+    options.enable_metrics = true;
+    // Let writers run out of room long before the flushing thread would wake
+    // up by itself
+    options.max_flush_delay_ms = 60 * 1000;
+    options.max_unflushed_versions = 4;
+
+    bool no_create = false;
+    std::unique_ptr<SharedGroup> sg_1(new SharedGroup(path, no_create, options));
+    SharedGroup sg_2(path, no_create, options);
+    for (int i = 0; i < 20; ++i) {
+        WriteTransaction wt(*sg_1);
+        TableRef table = wt.get_or_add_table("table");
+        if (table->get_column_count() == 0)
+            table->add_column(type_Int, "i");
+        table->add_empty_row();
+        wt.commit();
+    }
+#if REALM_METRICS
+    size_t max_unflushed_versions = 0;
+    auto transactions = sg_1->get_metrics()->take_transactions();
+    for (auto& transaction : *transactions) {
+        if (transaction.get_transaction_type() == metrics::TransactionInfo::write_transaction) {
+            max_unflushed_versions = std::max(max_unflushed_versions, transaction.get_num_unflushed_versions());
+            CHECK_GREATER_EQUAL(transaction.get_flush_lag(), 0);
+        }
+    }
+    CHECK_GREATER_EQUAL(max_unflushed_versions, 1);
+    CHECK_LESS_EQUAL(max_unflushed_versions, 5);
+#endif // REALM_METRICS
+
+    // Closing the SharedGroup that started the flushing thread stops it, and
+    // the other SharedGroup takes over when it writes
+    sg_1.reset();
+    for (int i = 0; i < 10; ++i) {
+        WriteTransaction wt(sg_2);
+        wt.get_table("table")->add_empty_row();
+        wt.commit();
+    }
+    sg_2.close();
+    {
+        Group group(path, crypt_key());
+        CHECK_EQUAL(30, group.get_table("table")->size());
+    }
+}
+
+
 namespace {
 
 #define multiprocess_increments 100
@@ -2040,9 +2624,6 @@ void multiprocess_make_table(std::string path, std::string lock_path, std::strin
     }
 #endif
 #endif
-    // Wait for async_commit process to shutdown
-    // FIXME: No good way of doing this
-    millisleep(1000);
 #else
     {
         Group g(alone_path, Group::mode_ReadWrite);
@@ -2095,10 +2676,7 @@ void multiprocess_threaded(TestContext& test_context, std::string path, size_t n
 void multiprocess_validate_and_clear(TestContext& test_context, std::string path, std::string lock_path, size_t rows,
                                      int result)
 {
-    // Wait for async_commit process to shutdown
-    // FIXME: this is not apropriate
     static_cast<void>(lock_path);
-    millisleep(1000);
 
     // Verify - once more, in sync mode - that the changes were made
     {
@@ -2134,14 +2712,11 @@ void multiprocess(TestContext& test_context, std::string path, int num_procs, si
 } // anonymous namespace
 
 
-TEST_IF(Shared_AsyncMultiprocess, allow_async)
+TEST_IF(Shared_AsyncMultiprocess, allow_async_multiprocess)
 {
     SHARED_GROUP_TEST_PATH(path);
     SHARED_GROUP_TEST_PATH(alone_path);
 
-    // wait for any daemon hanging around to exit
-    millisleep(1); // FIXME: Is this really acceptable?
-
 #if TEST_DURATION < 1
     multiprocess_make_table(path, path.get_lock_path(), alone_path, 4);
 
@@ -3078,6 +3653,207 @@ TEST(Shared_SessionDurabilityConsistency)
 }
 
 
+TEST(Shared_SessionGroupCommitConsistency)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    {
+        bool no_create = false;
+        SharedGroupOptions options_1(crypt_key());
+        options_1.enable_group_commit = true;
+        SharedGroup sg(path, no_create, options_1);
+
+        SharedGroupOptions options_2(crypt_key());
+        CHECK_LOGIC_ERROR(SharedGroup(path, no_create, options_2), LogicError::mixed_group_commit);
+    }
+}
+
+
+TEST(Shared_GroupCommit)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    const size_t num_threads = 4;
+    const int num_commits = 50;
+    SharedGroupOptions options(crypt_key());
+    options.enable_group_commit = true;
+    {
+        SharedGroup sg(path, false, options);
+        {
+            WriteTransaction wt(sg);
+            TableRef table = wt.add_table("counters");
+            table->add_column(type_Int, "value");
+            table->add_empty_row(num_threads);
+            wt.commit();
+        }
+
+        std::unique_ptr<test_util::ThreadWrapper[]> threads(new test_util::ThreadWrapper[num_threads]);
+        for (size_t i = 0; i != num_threads; ++i) {
+            threads[i].start([&, i] {
+                SharedGroup sg_2(path, false, options);
+                SharedGroup::version_type last_version = 0;
+                for (int j = 0; j != num_commits; ++j) {
+                    WriteTransaction wt(sg_2);
+                    TableRef table = wt.get_table("counters");
+                    table->set_int(0, i, table->get_int(0, i) + 1);
+                    SharedGroup::version_type version = wt.commit();
+                    // Every committer gets its own version
+                    REALM_ASSERT_RELEASE(version > last_version);
+                    last_version = version;
+                }
+            });
+        }
+        for (size_t i = 0; i != num_threads; ++i) {
+            std::string except_msg;
+            bool thread_has_thrown = threads[i].join(except_msg);
+            CHECK(!thread_has_thrown);
+        }
+
+        uint_fast64_t commits, flushes;
+        sg.get_group_commit_stats(commits, flushes);
+        CHECK_EQUAL(commits, 1 + num_threads * num_commits);
+        CHECK_GREATER(flushes, 0);
+        CHECK_LESS_EQUAL(flushes, commits);
+    }
+
+    // The file header must select the latest version when the session is over
+    Group group(path, crypt_key());
+    ConstTableRef table = group.get_table("counters");
+    CHECK(table);
+    for (size_t i = 0; i != num_threads; ++i)
+        CHECK_EQUAL(table->get_int(0, i), num_commits);
+    group.verify();
+}
+
+
+TEST(Shared_WriteAheadLog)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    SharedGroupOptions options(SharedGroupOptions::Durability::Log);
+    const int num_rows = 10;
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        SharedGroup sg(*hist, options);
+        {
+            WriteTransaction wt(sg);
+            TableRef table = wt.add_table("table");
+            table->add_column(type_Int, "value");
+            wt.commit();
+        }
+        for (int i = 0; i != num_rows; ++i) {
+            WriteTransaction wt(sg);
+            TableRef table = wt.get_table("table");
+            table->add_empty_row();
+            table->set_int(0, i, i);
+            wt.commit();
+        }
+
+        // Simulate a crash by copying the files while the session is still
+        // in progress
+        File::copy(path, path_2);
+        File::copy(std::string(path) + ".wal.0", std::string(path_2) + ".wal.0");
+        File::copy(std::string(path) + ".wal.1", std::string(path_2) + ".wal.1");
+    }
+
+    // None of the commits made it into the Realm file itself
+    {
+        Group group(path_2);
+        CHECK(!group.has_table("table"));
+    }
+
+    // They are replayed from the log when the Realm file is opened again
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+        SharedGroup sg(*hist, options);
+        ReadTransaction rt(sg);
+        ConstTableRef table = rt.get_table("table");
+        CHECK(table);
+        CHECK_EQUAL(table->size(), num_rows);
+        for (int i = 0; i != num_rows; ++i)
+            CHECK_EQUAL(table->get_int(0, i), i);
+    }
+
+    // When a session ends, the Realm file is made durable and the log is
+    // emptied
+    for (const std::string& p : {std::string(path), std::string(path_2)}) {
+        CHECK_EQUAL(File(p + ".wal.0").get_size(), 0);
+        CHECK_EQUAL(File(p + ".wal.1").get_size(), 0);
+        Group group(p);
+        ConstTableRef table = group.get_table("table");
+        CHECK(table);
+        CHECK_EQUAL(table->size(), num_rows);
+        group.verify();
+    }
+}
+
+
+TEST(Shared_WriteAheadLogCheckpoints)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SHARED_GROUP_TEST_PATH(path_2);
+    const size_t num_threads = 4;
+    const int num_commits = 50;
+    SharedGroupOptions options(SharedGroupOptions::Durability::Log);
+    options.log_checkpoint_size = 1024;
+    {
+        std::unique_ptr<Replication> hist(make_in_realm_history(path));
+        SharedGroup sg(*hist, options);
+        {
+            WriteTransaction wt(sg);
+            TableRef table = wt.add_table("counters");
+            table->add_column(type_Int, "value");
+            table->add_column(type_String, "text");
+            table->add_empty_row(num_threads);
+            wt.commit();
+        }
+
+        std::unique_ptr<test_util::ThreadWrapper[]> threads(new test_util::ThreadWrapper[num_threads]);
+        for (size_t i = 0; i != num_threads; ++i) {
+            threads[i].start([&, i] {
+                std::unique_ptr<Replication> hist_2(make_in_realm_history(path));
+                SharedGroup sg_2(*hist_2, options);
+                std::string text(100, 'x');
+                for (int j = 0; j != num_commits; ++j) {
+                    WriteTransaction wt(sg_2);
+                    TableRef table = wt.get_table("counters");
+                    table->set_int(0, i, table->get_int(0, i) + 1);
+                    table->set_string(1, i, text);
+                    wt.commit();
+                }
+            });
+        }
+        for (size_t i = 0; i != num_threads; ++i) {
+            std::string except_msg;
+            bool thread_has_thrown = threads[i].join(except_msg);
+            CHECK(!thread_has_thrown);
+        }
+
+        // Checkpoints have kept the log short
+        CHECK_LESS(File(std::string(path) + ".wal.0").get_size() + File(std::string(path) + ".wal.1").get_size(), 2 * 1024 + 1024);
+
+        File::copy(path, path_2);
+        File::copy(std::string(path) + ".wal.0", std::string(path_2) + ".wal.0");
+        File::copy(std::string(path) + ".wal.1", std::string(path_2) + ".wal.1");
+    }
+
+    std::unique_ptr<Replication> hist(make_in_realm_history(path_2));
+    SharedGroup sg(*hist, options);
+    ReadTransaction rt(sg);
+    ConstTableRef table = rt.get_table("counters");
+    CHECK(table);
+    for (size_t i = 0; i != num_threads; ++i)
+        CHECK_EQUAL(table->get_int(0, i), num_commits);
+    rt.get_group().verify();
+}
+
+
+TEST(Shared_WriteAheadLogRequiresHistory)
+{
+    SHARED_GROUP_TEST_PATH(path);
+    SharedGroupOptions options(SharedGroupOptions::Durability::Log);
+    CHECK_LOGIC_ERROR(SharedGroup(path, false, options), LogicError::no_history);
+}
+
+
 TEST(Shared_WriteEmpty)
 {
     SHARED_GROUP_TEST_PATH(path_1);
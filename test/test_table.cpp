@@ -8742,4 +8742,109 @@ TEST(Table_KeyRow)
     CHECK_EQUAL(i, 1);
 }
 
+
+TEST(Table_AppendColumns)
+{
+    Group g;
+    TableRef table = g.add_table("table");
+    table->add_column(type_Int, "int");
+    table->add_column(type_Int, "int_null", true);
+    table->add_column(type_Bool, "bool");
+    table->add_column(type_Double, "double", true);
+    table->add_column(type_String, "string", true);
+    table->add_column(type_Timestamp, "timestamp", true);
+    table->add_column(type_Float, "float");
+    table->add_search_index(0);
+
+    // Start out with a partially filled last leaf
+    table->add_empty_row(7);
+    table->set_int(0, 3, 1000);
+
+    const size_t n = 3 * REALM_MAX_BPNODE_SIZE + 11;
+    std::vector<int64_t> ints(n);
+    std::unique_ptr<bool[]> nulls(new bool[n]);
+    std::vector<double> doubles(n);
+    std::vector<std::string> strings(n);
+    std::vector<StringData> string_data(n);
+    std::vector<Timestamp> timestamps(n);
+    for (size_t i = 0; i < n; ++i) {
+        ints[i] = i % 5 == 0 ? -int64_t(i) * 1000000 : int64_t(i);
+        nulls[i] = i % 3 == 0;
+        doubles[i] = i * 0.5;
+        strings[i] = std::string(i % 20, 'x');
+        string_data[i] = i % 7 == 0 ? StringData() : StringData(strings[i]);
+        timestamps[i] = i % 11 == 0 ? Timestamp() : Timestamp(int64_t(i) * 60, int32_t(i));
+    }
+
+    std::vector<Table::ColumnValues> columns(6);
+    columns[0].col_ndx = 0;
+    columns[0].ints = ints.data();
+    columns[1].col_ndx = 1;
+    columns[1].ints = ints.data();
+    columns[1].nulls = nulls.get();
+    columns[2].col_ndx = 2;
+    columns[2].ints = ints.data();
+    columns[3].col_ndx = 3;
+    columns[3].doubles = doubles.data();
+    columns[3].nulls = nulls.get();
+    columns[4].col_ndx = 4;
+    columns[4].strings = string_data.data();
+    columns[5].col_ndx = 5;
+    columns[5].timestamps = timestamps.data();
+    CHECK_EQUAL(7, table->append_columns(n, columns));
+    CHECK_EQUAL(n + 7, table->size());
+    table->verify();
+
+    CHECK_EQUAL(1000, table->get_int(0, 3));
+    CHECK(table->is_null(1, 6));
+    for (size_t i = 0; i < n; ++i) {
+        size_t row_ndx = 7 + i;
+        CHECK_EQUAL(ints[i], table->get_int(0, row_ndx));
+        CHECK_EQUAL(nulls[i], table->is_null(1, row_ndx));
+        if (!nulls[i])
+            CHECK_EQUAL(ints[i], table->get_int(1, row_ndx));
+        CHECK_EQUAL(ints[i] != 0, table->get_bool(2, row_ndx));
+        CHECK_EQUAL(nulls[i], table->is_null(3, row_ndx));
+        if (!nulls[i])
+            CHECK_EQUAL(doubles[i], table->get_double(3, row_ndx));
+        CHECK_EQUAL(string_data[i], table->get_string(4, row_ndx));
+        CHECK_EQUAL(timestamps[i], table->get_timestamp(5, row_ndx));
+        CHECK_EQUAL(0.0f, table->get_float(6, row_ndx));
+    }
+
+    // The search index and the bounds of the inner nodes must cover the
+    // appended values
+    CHECK_EQUAL(7 + 5, table->find_first_int(0, -5000000));
+    size_t num_negative = (n - 1) / 5;
+    CHECK_EQUAL(num_negative, table->where().less(0, 0).count());
+    CHECK_EQUAL(1, table->where().greater(0, int64_t(n - 3)).count());
+
+    // Appending more keeps filling up the last leaf first
+    CHECK_EQUAL(n + 7, table->append_columns(n, columns));
+    CHECK_EQUAL(2 * n + 7, table->size());
+    table->verify();
+    CHECK_EQUAL(ints[n - 1], table->get_int(0, 2 * n + 6));
+    CHECK_EQUAL(string_data[5], table->get_string(4, n + 12));
+    CHECK_EQUAL(2 * num_negative, table->where().less(0, 0).count());
+    table->add_empty_row();
+    table->remove(0);
+    table->verify();
+
+    // Nothing is changed when the values are not acceptable
+    size_t size = table->size();
+    std::vector<Table::ColumnValues> bad(1);
+    bad[0].col_ndx = 7;
+    bad[0].ints = ints.data();
+    CHECK_LOGIC_ERROR(table->append_columns(n, bad), LogicError::column_index_out_of_range);
+    bad[0].col_ndx = 3;
+    CHECK_LOGIC_ERROR(table->append_columns(n, bad), LogicError::type_mismatch);
+    bad[0].col_ndx = 0;
+    bad[0].nulls = nulls.get();
+    CHECK_LOGIC_ERROR(table->append_columns(n, bad), LogicError::column_not_nullable);
+    bad[0].nulls = nullptr;
+    bad.push_back(bad[0]);
+    CHECK_LOGIC_ERROR(table->append_columns(n, bad), LogicError::illegal_combination);
+    CHECK_EQUAL(size, table->size());
+}
+
 #endif // TEST_TABLE
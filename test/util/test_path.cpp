@@ -180,6 +180,8 @@ void SharedGroupTestPathGuard::cleanup() const noexcept
         if (File::is_dir(m_path + ".management"))
             remove_dir(m_path + ".management");
         File::try_remove(get_lock_path());
+        File::try_remove(m_path + ".wal.0");
+        File::try_remove(m_path + ".wal.1");
     }
     catch (...) {
         // Exception deliberately ignored